@@ -0,0 +1,753 @@
+#include <benchmark/benchmark.h>
+#include <bitset>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+#include "intersection.hpp"
+#include "kernels.hpp"
+#include "mesh.hpp"
+#include "pipeline.hpp"
+#include "static_scene.hpp"
+#include "compact_scene.hpp"
+#include "validation.hpp"
+
+using namespace triangle_intersection;
+
+/*
+Every workload is a list of triangle pairs (2 * 9 doubles per pair) chosen to drive
+the kernel through one group of branches:
+    Far        the second triangle lies far away, rejected by the first plane test
+    Crossing   the second triangle pierces the first one, full test with a hit
+    NearMiss   both planes are crossed but the triangles miss each other, full test without a hit
+    Coplanar   both triangles lie in the same plane, 2D test
+    Degenerate points and segments
+    Mixed      all of the above, shuffled
+*/
+
+namespace {
+    enum class Workload { Far, Crossing, NearMiss, Coplanar, Degenerate, Mixed };
+
+    constexpr std::size_t PAIR_COUNT = 1 << 12;
+
+    struct Generator {
+        std::mt19937 gen;
+        std::uniform_real_distribution<double> unit { -1, 1 };
+        std::uniform_real_distribution<double> positive { 0.05, 1 };
+        std::uniform_int_distribution<int> grid { -4, 4 };
+
+        void random_triangle(double t[9]) {
+            for (int k = 0; k < 9; k++) {
+                t[k] = unit(gen);
+            }
+        }
+
+        // point of the plane of t with barycentric coordinates (1 - u - v, u, v)
+        void get_point(const double t[9], double u, double v, double p[3]) {
+            for (int k = 0; k < 3; k++) {
+                p[k] = t[k] + u * (t[3 + k] - t[k]) + v * (t[6 + k] - t[k]);
+            }
+        }
+
+        void get_normal(const double t[9], double n[3]) {
+            double e1[3] = { t[3] - t[0], t[4] - t[1], t[5] - t[2] };
+            double e2[3] = { t[6] - t[0], t[7] - t[1], t[8] - t[2] };
+            n[0] = e1[1] * e2[2] - e1[2] * e2[1];
+            n[1] = e1[2] * e2[0] - e1[0] * e2[2];
+            n[2] = e1[0] * e2[1] - e1[1] * e2[0];
+        }
+
+        // triangle around p reaching both sides of the plane with normal n
+        void piercing_triangle(const double p[3], const double n[3], double t[9]) {
+            double a = positive(gen), b = positive(gen);
+            for (int k = 0; k < 3; k++) {
+                double side = unit(gen) * 0.2;
+                t[k] = p[k] + a * n[k] + side;
+                t[3 + k] = p[k] - b * n[k] + side;
+                t[6 + k] = p[k] + unit(gen) * 0.2 * n[k] - side;
+            }
+        }
+
+        void far(double t1[9], double t2[9]) {
+            random_triangle(t1);
+            random_triangle(t2);
+            for (int k = 0; k < 9; k += 3) {
+                t2[k] += 100;
+            }
+        }
+
+        void crossing(double t1[9], double t2[9]) {
+            random_triangle(t1);
+            double u = positive(gen) * 0.4, v = positive(gen) * 0.4;
+            double p[3], n[3];
+            get_point(t1, u, v, p);
+            get_normal(t1, n);
+            piercing_triangle(p, n, t2);
+        }
+
+        void near_miss(double t1[9], double t2[9]) {
+            random_triangle(t1);
+            double u = 1 + positive(gen), v = positive(gen);
+            double p[3], n[3];
+            get_point(t1, u, v, p);
+            get_normal(t1, n);
+            piercing_triangle(p, n, t2);
+        }
+
+        void coplanar(double t1[9], double t2[9]) {
+            // integer coordinates in z = 0 give exactly zero determinants
+            for (int k = 0; k < 9; k++) {
+                t1[k] = k % 3 == 2 ? 0 : grid(gen);
+                t2[k] = k % 3 == 2 ? 0 : grid(gen);
+            }
+        }
+
+        void degenerate(double t1[9], double t2[9]) {
+            random_triangle(t1);
+            double p[3] = { unit(gen), unit(gen), unit(gen) };
+            double dir[3] = { unit(gen), unit(gen), unit(gen) };
+            bool point = gen() % 2 == 0;
+            for (int i = 0; i < 3; i++) {
+                double s = point ? 0 : i * 0.5;
+                for (int k = 0; k < 3; k++) {
+                    t2[i * 3 + k] = p[k] + s * dir[k];
+                }
+            }
+        }
+
+        void generate(Workload workload, double t1[9], double t2[9]) {
+            switch (workload) {
+                case Workload::Far: far(t1, t2); break;
+                case Workload::Crossing: crossing(t1, t2); break;
+                case Workload::NearMiss: near_miss(t1, t2); break;
+                case Workload::Coplanar: coplanar(t1, t2); break;
+                case Workload::Degenerate: degenerate(t1, t2); break;
+                case Workload::Mixed: generate(static_cast<Workload>(gen() % 5), t1, t2); break;
+            }
+        }
+    };
+
+    struct Pairs {
+        std::vector<double> t1;
+        std::vector<double> t2;
+    };
+
+    Pairs make_pairs(Workload workload, std::size_t n) {
+        Generator g { std::mt19937(static_cast<unsigned>(workload) + 1) };
+        Pairs p { std::vector<double>(n * 9), std::vector<double>(n * 9) };
+        for (std::size_t i = 0; i < n; i++) {
+            g.generate(workload, &p.t1[i * 9], &p.t2[i * 9]);
+        }
+        return p;
+    }
+
+    std::vector<double> make_soup(std::size_t n, double extent, double size, unsigned seed) {
+        std::mt19937 gen(seed);
+        std::uniform_real_distribution<double> position(0, extent);
+        std::uniform_real_distribution<double> offset(-size, size);
+
+        std::vector<double> t(n * 9);
+        for (std::size_t i = 0; i < n; i++) {
+            double c[3] = { position(gen), position(gen), position(gen) };
+            for (int k = 0; k < 9; k++) {
+                t[i * 9 + k] = c[k % 3] + offset(gen);
+            }
+        }
+        return t;
+    }
+
+    void set_counters(benchmark::State& state, std::size_t pairs, std::size_t hits) {
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * pairs));
+        state.counters["ns_per_pair"] = benchmark::Counter(static_cast<double>(pairs),
+                                                           benchmark::Counter::kIsIterationInvariantRate | benchmark::Counter::kInvert);
+        state.counters["hit_rate"] = static_cast<double>(hits) / pairs;
+    }
+}
+
+static void Single(benchmark::State& state, Workload workload) {
+    Pairs p = make_pairs(workload, PAIR_COUNT);
+    std::size_t hits = 0;
+    for (auto _ : state) {
+        hits = 0;
+        for (std::size_t i = 0; i < PAIR_COUNT; i++) {
+            hits += have_intersection(&p.t1[i * 9], &p.t2[i * 9]);
+        }
+        benchmark::DoNotOptimize(hits);
+    }
+    set_counters(state, PAIR_COUNT, hits);
+}
+
+static void NonDegenerate(benchmark::State& state, Workload workload) {
+
+    // the Degenerate workload breaks the assumption, its hit rate is not the one of Single
+
+    Pairs p = make_pairs(workload, PAIR_COUNT);
+    std::size_t hits = 0;
+    for (auto _ : state) {
+        hits = 0;
+        for (std::size_t i = 0; i < PAIR_COUNT; i++) {
+            hits += have_intersection(&p.t1[i * 9], &p.t2[i * 9], AssumeNonDegenerate());
+        }
+        benchmark::DoNotOptimize(hits);
+    }
+    set_counters(state, PAIR_COUNT, hits);
+}
+
+static void Segment(benchmark::State& state, Workload workload) {
+    Pairs p = make_pairs(workload, PAIR_COUNT);
+    std::size_t hits = 0;
+    Intersection result;
+    for (auto _ : state) {
+        hits = 0;
+        for (std::size_t i = 0; i < PAIR_COUNT; i++) {
+            hits += have_intersection(&p.t1[i * 9], &p.t2[i * 9], result);
+        }
+        benchmark::DoNotOptimize(hits);
+        benchmark::DoNotOptimize(result);
+    }
+    set_counters(state, PAIR_COUNT, hits);
+}
+
+static void Integer(benchmark::State& state, Workload workload) {
+
+    // the same pairs on a grid of step 1/4096, which keeps the far ones within MAX_INTEGER_COORDINATE
+
+    Pairs p = make_pairs(workload, PAIR_COUNT);
+    std::vector<std::int32_t> t1(PAIR_COUNT * 9), t2(PAIR_COUNT * 9);
+    for (std::size_t i = 0; i < PAIR_COUNT * 9; i++) {
+        t1[i] = static_cast<std::int32_t>(std::lround(p.t1[i] * 4096));
+        t2[i] = static_cast<std::int32_t>(std::lround(p.t2[i] * 4096));
+    }
+
+    std::size_t hits = 0;
+    for (auto _ : state) {
+        hits = 0;
+        for (std::size_t i = 0; i < PAIR_COUNT; i++) {
+            hits += have_intersection(&t1[i * 9], &t2[i * 9]);
+        }
+        benchmark::DoNotOptimize(hits);
+    }
+    set_counters(state, PAIR_COUNT, hits);
+}
+
+static void Kernels(benchmark::State& state, Workload workload) {
+
+    // range(0) is the Kernel, KERNEL_COUNT lets have_intersection_autotuned pick one for every batch
+
+    Pairs p = make_pairs(workload, PAIR_COUNT);
+    std::size_t hits = 0;
+    std::size_t k = static_cast<std::size_t>(state.range(0));
+    if (k == KERNEL_COUNT) {
+        std::vector<std::uint64_t> mask((PAIR_COUNT + 63) / 64);
+        AutotuneOptions options;
+        options.sample_size = PAIR_COUNT / 64;
+        Kernel kernel = Kernel::DevillersGuigue;
+        for (auto _ : state) {
+            kernel = have_intersection_autotuned(p.t1.data(), p.t2.data(), PAIR_COUNT, mask.data(), options);
+            benchmark::DoNotOptimize(mask.data());
+        }
+        hits = 0;
+        for (std::uint64_t m : mask) {
+            hits += std::bitset<64>(m).count();
+        }
+        set_counters(state, PAIR_COUNT, hits);
+        state.SetLabel(std::string("autotuned: ") + get_kernel_name(kernel));
+        return;
+    }
+
+    KernelFunction kernel = get_kernel(static_cast<Kernel>(k));
+    for (auto _ : state) {
+        hits = 0;
+        for (std::size_t i = 0; i < PAIR_COUNT; i++) {
+            hits += kernel(&p.t1[i * 9], &p.t2[i * 9]);
+        }
+        benchmark::DoNotOptimize(hits);
+    }
+    set_counters(state, PAIR_COUNT, hits);
+    state.SetLabel(get_kernel_name(static_cast<Kernel>(k)));
+}
+
+static void Prepared(benchmark::State& state, Workload workload) {
+
+    // the first triangle of every pair is prepared once, outside of the timed loop
+
+    Pairs p = make_pairs(workload, PAIR_COUNT);
+    std::vector<PreparedTriangle> prepared;
+    prepared.reserve(PAIR_COUNT);
+    for (std::size_t i = 0; i < PAIR_COUNT; i++) {
+        prepared.emplace_back(&p.t1[i * 9]);
+    }
+
+    std::size_t hits = 0;
+    for (auto _ : state) {
+        hits = 0;
+        for (std::size_t i = 0; i < PAIR_COUNT; i++) {
+            hits += have_intersection(prepared[i], &p.t2[i * 9]);
+        }
+        benchmark::DoNotOptimize(hits);
+    }
+    set_counters(state, PAIR_COUNT, hits);
+}
+
+template <class Batch>
+static void run_batch(benchmark::State& state, Workload workload, bool assume_non_degenerate = false) {
+
+    // the coordinates are rounded to the scalar type of the batch
+
+    using scalar = std::decay_t<decltype(*Batch::coords[0])>;
+    Pairs p = make_pairs(workload, PAIR_COUNT);
+    SimdIsa isa = static_cast<SimdIsa>(state.range(0));
+    if (isa > get_simd_isa()) {
+        isa = get_simd_isa();
+    }
+
+    std::vector<scalar> soa1(PAIR_COUNT * 9), soa2(PAIR_COUNT * 9);
+    Batch b1, b2;
+    for (int k = 0; k < 9; k++) {
+        for (std::size_t i = 0; i < PAIR_COUNT; i++) {
+            soa1[k * PAIR_COUNT + i] = static_cast<scalar>(p.t1[i * 9 + k]);
+            soa2[k * PAIR_COUNT + i] = static_cast<scalar>(p.t2[i * 9 + k]);
+        }
+        b1.coords[k] = &soa1[k * PAIR_COUNT];
+        b2.coords[k] = &soa2[k * PAIR_COUNT];
+    }
+
+    std::vector<std::uint64_t> mask((PAIR_COUNT + 63) / 64);
+    for (auto _ : state) {
+        if (assume_non_degenerate) {
+            have_intersection_batch(b1, b2, PAIR_COUNT, mask.data(), isa, AssumeNonDegenerate());
+        } else {
+            have_intersection_batch(b1, b2, PAIR_COUNT, mask.data(), isa);
+        }
+        benchmark::DoNotOptimize(mask.data());
+        benchmark::ClobberMemory();
+    }
+
+    std::size_t hits = 0;
+    for (std::uint64_t m : mask) {
+        hits += std::bitset<64>(m).count();
+    }
+    set_counters(state, PAIR_COUNT, hits);
+    state.SetLabel(isa == SimdIsa::Scalar ? "scalar" : isa == SimdIsa::Avx2 ? "avx2" : "avx512");
+}
+
+static void Batch(benchmark::State& state, Workload workload) {
+    run_batch<TriangleBatch>(state, workload);
+}
+
+static void NonDegenerateBatch(benchmark::State& state, Workload workload) {
+    run_batch<TriangleBatch>(state, workload, true);
+}
+
+static void FloatBatch(benchmark::State& state, Workload workload) {
+    run_batch<FloatTriangleBatch>(state, workload);
+}
+
+static void MeshQuery(benchmark::State& state) {
+
+    // two soups of small triangles in the same box, hierarchies built outside of the timed loop
+
+    std::size_t n = static_cast<std::size_t>(state.range(0));
+    std::vector<double> m1 = make_soup(n, 100, 1, 1);
+    std::vector<double> m2 = make_soup(n, 100, 1, 2);
+    Bvh b1(m1.data(), n), b2(m2.data(), n);
+    ParallelOptions options;
+    options.max_threads = static_cast<unsigned>(state.range(1));
+
+    std::size_t hits = 0;
+    for (auto _ : state) {
+        std::vector<TrianglePair> pairs = intersect_meshes(b1, b2, options);
+        hits = pairs.size();
+        benchmark::DoNotOptimize(pairs.data());
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * n));
+    state.counters["pairs"] = static_cast<double>(hits);
+}
+
+static void MeshAnyHit(benchmark::State& state) {
+
+    // the same soups: intersecting pairs are everywhere, the first one ends the query
+
+    std::size_t n = static_cast<std::size_t>(state.range(0));
+    std::vector<double> m1 = make_soup(n, 100, 1, 1);
+    std::vector<double> m2 = make_soup(n, 100, 1, 2);
+    Bvh b1(m1.data(), n), b2(m2.data(), n);
+    ParallelOptions options;
+    options.max_threads = static_cast<unsigned>(state.range(1));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(have_intersection(b1, b2, options));
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * n));
+}
+
+static void MeshCount(benchmark::State& state) {
+    std::size_t n = static_cast<std::size_t>(state.range(0));
+    std::vector<double> m1 = make_soup(n, 100, 1, 1);
+    std::vector<double> m2 = make_soup(n, 100, 1, 2);
+    Bvh b1(m1.data(), n), b2(m2.data(), n);
+    ParallelOptions options;
+    options.max_threads = static_cast<unsigned>(state.range(1));
+
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(count_intersections(b1, b2, options));
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * n));
+}
+
+static void MeshClearance(benchmark::State& state) {
+
+    // the second soup moved next to the first one, range(1) = 1: have_proximity within 0.5, 0: get_closest_pair
+
+    std::size_t n = static_cast<std::size_t>(state.range(0));
+    std::vector<double> m1 = make_soup(n, 100, 1, 1);
+    std::vector<double> m2 = make_soup(n, 100, 1, 2);
+    for (std::size_t k = 0; k < m2.size(); k += 3) {
+        m2[k] += 102;
+    }
+    Bvh b1(m1.data(), n), b2(m2.data(), n);
+
+    double distance = 0;
+    for (auto _ : state) {
+        if (state.range(1)) {
+            benchmark::DoNotOptimize(have_proximity(b1, b2, 0.5));
+        } else {
+            distance = get_closest_pair(b1, b2).distance;
+            benchmark::DoNotOptimize(distance);
+        }
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * n));
+    state.counters["distance"] = distance;
+}
+
+static void MeshSinks(benchmark::State& state) {
+
+    // dense soups with many intersecting pairs on one thread, range(0) = 0: the sorted vector, 1: an ArenaSink, 2: a counting CallbackSink
+
+    const std::size_t n = 1 << 16;
+    std::vector<double> m1 = make_soup(n, 25, 1, 1);
+    std::vector<double> m2 = make_soup(n, 25, 1, 2);
+    Bvh b1(m1.data(), n), b2(m2.data(), n);
+
+    QueryArena arena;
+    ArenaSink arena_sink;
+    std::size_t hits = 0;
+    auto callback = make_callback_sink([&] (const TrianglePair*, std::size_t count, unsigned) { hits += count; });
+    for (auto _ : state) {
+        if (state.range(0) == 0) {
+            std::vector<TrianglePair> pairs = intersect_meshes(b1, b2);
+            hits = pairs.size();
+            benchmark::DoNotOptimize(pairs.data());
+        } else if (state.range(0) == 1) {
+            arena_sink.clear();
+            intersect_meshes(b1, b2, arena_sink, arena);
+            hits = arena_sink.size();
+        } else {
+            hits = 0;
+            intersect_meshes(b1, b2, callback, arena);
+        }
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * n));
+    state.counters["pairs"] = static_cast<double>(hits);
+}
+
+static void PipelineRequests(benchmark::State& state) {
+
+    // 16 requests of candidate pairs, range(0) = 1: all submitted to a BatchPipeline, 0: intersect_pairs one after another
+
+    const std::size_t n = 1 << 14;
+    std::vector<double> m1 = make_soup(n, 100, 1, 1);
+    std::vector<double> m2 = make_soup(n, 100, 1, 1);
+    for (std::size_t i = 0; i < n; i++) {
+        m2[i * 9 + 2] += 0.5;
+        m2[i * 9 + 5] -= 0.5;
+        m2[i * 9 + 6] += 0.25;
+    }
+
+    // every triangle against its tilted copy and against a random one
+    std::vector<TrianglePair> candidates;
+    for (std::uint32_t i = 0; i < n; i++) {
+        candidates.emplace_back(i, i);
+        candidates.emplace_back(i, static_cast<std::uint32_t>((i * 2654435761u) % n));
+    }
+
+    BatchPipeline pipeline;
+    std::size_t hits = 0;
+    for (auto _ : state) {
+        hits = 0;
+        if (state.range(0)) {
+            std::vector<std::future<std::vector<TrianglePair>>> requests;
+            for (int r = 0; r < 16; r++) {
+                requests.push_back(pipeline.submit(m1.data(), m2.data(), candidates));
+            }
+            for (auto& request : requests) {
+                hits += request.get().size();
+            }
+        } else {
+            for (int r = 0; r < 16; r++) {
+                hits += intersect_pairs(m1.data(), m2.data(), candidates, ParallelOptions { 1 }).size();
+            }
+        }
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * 16 * candidates.size()));
+    state.counters["hits"] = static_cast<double>(hits);
+}
+
+static void MeshBuild(benchmark::State& state) {
+    std::size_t n = static_cast<std::size_t>(state.range(0));
+    std::vector<double> m = make_soup(n, 100, 1, 1);
+    for (auto _ : state) {
+        Bvh bvh(m.data(), n);
+        benchmark::DoNotOptimize(bvh.nodes().data());
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * n));
+}
+
+static void SceneQuery(benchmark::State& state) {
+
+    // single triangles against a fixed soup, one query per iteration
+
+    std::size_t n = static_cast<std::size_t>(state.range(0));
+    std::vector<double> m = make_soup(n, 100, 1, 1);
+    std::vector<double> queries = make_soup(1024, 100, 1, 2);
+    StaticScene scene(m.data(), n);
+
+    std::vector<std::uint32_t> hits;
+    std::size_t q = 0;
+    for (auto _ : state) {
+        hits.clear();
+        scene.get_all_hits(&queries[q * 9], hits);
+        benchmark::DoNotOptimize(hits.data());
+        q = (q + 1) % 1024;
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()));
+}
+
+static void CompactSceneQuery(benchmark::State& state) {
+
+    // SceneQuery on the quantized layout
+
+    std::size_t n = static_cast<std::size_t>(state.range(0));
+    std::vector<double> m = make_soup(n, 100, 1, 1);
+    std::vector<double> queries = make_soup(1024, 100, 1, 2);
+    CompactScene scene(m.data(), n);
+
+    std::vector<std::uint32_t> hits;
+    std::size_t q = 0;
+    for (auto _ : state) {
+        hits.clear();
+        scene.get_all_hits(&queries[q * 9], hits);
+        benchmark::DoNotOptimize(hits.data());
+        q = (q + 1) % 1024;
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations()));
+    state.counters["bytes_per_triangle"] = static_cast<double>(scene.get_memory_size()) / static_cast<double>(n);
+}
+
+static void SceneRays(benchmark::State& state) {
+
+    // range(0) = 1: a pinhole camera, one origin and neighbouring directions, 0: random rays
+
+    const std::size_t n = 1 << 16, ray_count = 1 << 12;
+    std::vector<double> m = make_soup(n, 100, 1, 1);
+    StaticScene scene(m.data(), n);
+    SimdIsa isa = static_cast<SimdIsa>(state.range(1));
+    if (isa > get_simd_isa()) {
+        isa = get_simd_isa();
+    }
+
+    std::mt19937 gen(3);
+    std::uniform_real_distribution<double> position(0, 100);
+    std::uniform_real_distribution<double> direction(-1, 1);
+    std::vector<Ray> rays(ray_count);
+    for (std::size_t i = 0; i < ray_count; i++) {
+        Ray& r = rays[i];
+        if (state.range(0)) {
+            r = { { 50, 50, -10 }, { (i % 64) / 64.0 - 0.5, (i / 64) / 64.0 - 0.5, 1 }, 1e30 };
+        } else {
+            r = { { position(gen), position(gen), position(gen) }, { direction(gen), direction(gen), direction(gen) }, 1e30 };
+        }
+    }
+
+    std::vector<RayHit> hits(ray_count);
+    for (auto _ : state) {
+        scene.get_nearest_hits(rays.data(), ray_count, hits.data(), isa);
+        benchmark::DoNotOptimize(hits.data());
+    }
+
+    std::size_t hit_count = 0;
+    for (const RayHit& h : hits) {
+        hit_count += h.triangle != StaticScene::NO_HIT;
+    }
+    set_counters(state, ray_count, hit_count);
+    state.SetLabel(isa == SimdIsa::Scalar ? "scalar" : isa == SimdIsa::Avx2 ? "avx2" : "avx512");
+}
+
+static void ClassifyPoints(benchmark::State& state) {
+
+    // points against a closed grid of boxes
+
+    std::vector<double> m;
+    for (int i = 0; i < 16; i++) {
+        for (int j = 0; j < 16; j++) {
+            double min[3] = { i * 2.0, j * 2.0, 0 }, max[3] = { i * 2.0 + 1, j * 2.0 + 1, 1.0 + (i + j) % 3 };
+            for (int axis = 0; axis < 3; axis++) {
+                int a = (axis + 1) % 3, b = (axis + 2) % 3;
+                for (int side = 0; side < 2; side++) {
+                    double c[4][3];
+                    for (int k = 0; k < 4; k++) {
+                        c[k][axis] = side ? max[axis] : min[axis];
+                        c[k][a] = (k == 1 || k == 2) ? max[a] : min[a];
+                        c[k][b] = k >= 2 ? max[b] : min[b];
+                    }
+                    for (int k : { 0, 1, 2, 0, 2, 3 }) {
+                        m.insert(m.end(), c[k], c[k] + 3);
+                    }
+                }
+            }
+        }
+    }
+    StaticScene scene(m.data(), m.size() / 9);
+    SimdIsa isa = static_cast<SimdIsa>(state.range(0));
+    if (isa > get_simd_isa()) {
+        isa = get_simd_isa();
+    }
+
+    // range(1) = 1: voxel centres in row order, 0: random points
+
+    const std::size_t n = 1 << 12;
+    std::mt19937 gen(4);
+    std::uniform_real_distribution<double> position(0, 32);
+    std::vector<double> points(n * 3);
+    for (std::size_t i = 0; i < n; i++) {
+        if (state.range(1)) {
+            points[i * 3] = (i % 64 + 0.5) / 2;
+            points[i * 3 + 1] = (i / 64 + 0.5) / 2;
+            points[i * 3 + 2] = 1.5;
+        } else {
+            points[i * 3] = position(gen);
+            points[i * 3 + 1] = position(gen);
+            points[i * 3 + 2] = position(gen) / 8;
+        }
+    }
+
+    std::vector<std::uint64_t> inside((n + 63) / 64);
+    for (auto _ : state) {
+        scene.classify_points(points.data(), n, inside.data(), isa);
+        benchmark::DoNotOptimize(inside.data());
+    }
+
+    std::size_t inside_count = 0;
+    for (std::uint64_t w : inside) {
+        inside_count += std::bitset<64>(w).count();
+    }
+    set_counters(state, n, inside_count);
+    state.SetLabel(isa == SimdIsa::Scalar ? "scalar" : isa == SimdIsa::Avx2 ? "avx2" : "avx512");
+}
+
+static void SelfIntersection(benchmark::State& state) {
+
+    // a regular grid surface: every triangle shares edges and vertices with its neighbours
+
+    std::size_t side = static_cast<std::size_t>(state.range(0));
+    std::vector<double> vertices;
+    std::vector<std::uint32_t> indices;
+    for (std::size_t i = 0; i <= side; i++) {
+        for (std::size_t j = 0; j <= side; j++) {
+            vertices.insert(vertices.end(), { static_cast<double>(i), static_cast<double>(j), static_cast<double>((i * 7 + j * 3) % 5) * 0.1 });
+        }
+    }
+    for (std::size_t i = 0; i < side; i++) {
+        for (std::size_t j = 0; j < side; j++) {
+            std::uint32_t a = static_cast<std::uint32_t>(i * (side + 1) + j);
+            std::uint32_t b = a + 1, c = a + static_cast<std::uint32_t>(side + 1), d = c + 1;
+            indices.insert(indices.end(), { a, c, b, b, c, d });
+        }
+    }
+
+    IndexedMesh mesh { vertices.data(), vertices.size() / 3, indices.data(), indices.size() / 3 };
+    for (auto _ : state) {
+        std::vector<TrianglePair> pairs = find_self_intersections(mesh);
+        benchmark::DoNotOptimize(pairs.data());
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * mesh.triangle_count));
+}
+
+static void ValidationUpdate(benchmark::State& state) {
+
+    // the grid surface of SelfIntersection, one vertex in the middle goes up through its neighbours and back per update
+
+    std::size_t side = static_cast<std::size_t>(state.range(0));
+    std::vector<double> vertices;
+    std::vector<std::uint32_t> indices;
+    for (std::size_t i = 0; i <= side; i++) {
+        for (std::size_t j = 0; j <= side; j++) {
+            vertices.insert(vertices.end(), { static_cast<double>(i), static_cast<double>(j), static_cast<double>((i * 7 + j * 3) % 5) * 0.1 });
+        }
+    }
+    for (std::size_t i = 0; i < side; i++) {
+        for (std::size_t j = 0; j < side; j++) {
+            std::uint32_t a = static_cast<std::uint32_t>(i * (side + 1) + j);
+            std::uint32_t b = a + 1, c = a + static_cast<std::uint32_t>(side + 1), d = c + 1;
+            indices.insert(indices.end(), { a, c, b, b, c, d });
+        }
+    }
+
+    IndexedMesh mesh { vertices.data(), vertices.size() / 3, indices.data(), indices.size() / 3 };
+    ValidationSession session(mesh);
+    std::uint32_t v = static_cast<std::uint32_t>((side / 2) * (side + 1) + side / 2);
+    for (auto _ : state) {
+        vertices[v * 3] += 1.5;
+        ValidationSession::Changes changes = session.update(mesh, &v, 1, nullptr, 0);
+        benchmark::DoNotOptimize(changes.added.data());
+        vertices[v * 3] -= 1.5;
+        changes = session.update(mesh, &v, 1, nullptr, 0);
+        benchmark::DoNotOptimize(changes.removed.data());
+    }
+    state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * 2));
+}
+
+#define TRIANGLE_INTERSECTION_WORKLOADS(bench) \
+    BENCHMARK_CAPTURE(bench, Far, Workload::Far) ARGS; \
+    BENCHMARK_CAPTURE(bench, Crossing, Workload::Crossing) ARGS; \
+    BENCHMARK_CAPTURE(bench, NearMiss, Workload::NearMiss) ARGS; \
+    BENCHMARK_CAPTURE(bench, Coplanar, Workload::Coplanar) ARGS; \
+    BENCHMARK_CAPTURE(bench, Degenerate, Workload::Degenerate) ARGS; \
+    BENCHMARK_CAPTURE(bench, Mixed, Workload::Mixed) ARGS
+
+#define ARGS
+TRIANGLE_INTERSECTION_WORKLOADS(Single);
+TRIANGLE_INTERSECTION_WORKLOADS(NonDegenerate);
+TRIANGLE_INTERSECTION_WORKLOADS(Segment);
+TRIANGLE_INTERSECTION_WORKLOADS(Integer);
+TRIANGLE_INTERSECTION_WORKLOADS(Prepared);
+#undef ARGS
+
+#define ARGS ->DenseRange(0, static_cast<int>(KERNEL_COUNT))
+TRIANGLE_INTERSECTION_WORKLOADS(Kernels);
+#undef ARGS
+
+// instruction sets missing on the machine fall back to the best available one, see the label
+#define ARGS ->Arg(static_cast<int>(SimdIsa::Scalar))->Arg(static_cast<int>(SimdIsa::Avx2))->Arg(static_cast<int>(SimdIsa::Avx512))
+TRIANGLE_INTERSECTION_WORKLOADS(Batch);
+TRIANGLE_INTERSECTION_WORKLOADS(NonDegenerateBatch);
+TRIANGLE_INTERSECTION_WORKLOADS(FloatBatch);
+#undef ARGS
+
+BENCHMARK(MeshQuery)->Args({ 1 << 12, 1 })->Args({ 1 << 16, 1 })->Args({ 1 << 16, 0 })->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(MeshAnyHit)->Args({ 1 << 16, 1 })->Args({ 1 << 16, 0 })->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(MeshCount)->Args({ 1 << 16, 1 })->Args({ 1 << 16, 0 })->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(MeshClearance)->Args({ 1 << 16, 1 })->Args({ 1 << 16, 0 })->Unit(benchmark::kMicrosecond);
+BENCHMARK(MeshSinks)->Arg(0)->Arg(1)->Arg(2)->Unit(benchmark::kMillisecond);
+BENCHMARK(PipelineRequests)->Arg(1)->Arg(0)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(MeshBuild)->Arg(1 << 12)->Arg(1 << 16)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(SceneQuery)->Arg(1 << 12)->Arg(1 << 18);
+BENCHMARK(CompactSceneQuery)->Arg(1 << 12)->Arg(1 << 18);
+BENCHMARK(SceneRays)->ArgsProduct({ { 1, 0 }, { static_cast<int>(SimdIsa::Scalar), static_cast<int>(SimdIsa::Avx2), static_cast<int>(SimdIsa::Avx512) } });
+BENCHMARK(ClassifyPoints)->ArgsProduct({ { static_cast<int>(SimdIsa::Scalar), static_cast<int>(SimdIsa::Avx2), static_cast<int>(SimdIsa::Avx512) }, { 1, 0 } });
+BENCHMARK(SelfIntersection)->Arg(32)->Arg(128)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(ValidationUpdate)->Arg(128)->Arg(512)->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace triangle_intersection {
+    struct Aabb {
+        double min[3];
+        double max[3];
+    };
+
+    bool have_overlap(const Aabb& b1, const Aabb& b2) noexcept;
+    Aabb get_box(const double t[9]) noexcept;
+
+    /*
+    Bounding volume hierarchy over a triangle soup stored as count * 9 doubles
+    (the layout used by have_intersection). The triangles are not copied and must outlive the hierarchy.
+    Built top-down with binned SAH splits, large subtrees are built in parallel
+    */
+    class Bvh {
+    public:
+        struct Node {
+            Aabb box;
+            std::uint32_t first; // left child for inner nodes (the right one follows it), first entry of indices() for leaves
+            std::uint32_t count; // number of triangles in a leaf, 0 for inner nodes
+
+            bool is_leaf() const noexcept { return count != 0; }
+        };
+
+        Bvh(const double* triangles, std::size_t count);
+
+        const double* triangles() const noexcept { return triangles_; }
+        std::size_t size() const noexcept { return boxes_.size(); }
+
+        // nodes()[0] is the root, empty for an empty soup
+        const std::vector<Node>& nodes() const noexcept { return nodes_; }
+        // triangle indices in leaf order
+        const std::vector<std::uint32_t>& indices() const noexcept { return indices_; }
+        const Aabb& get_triangle_box(std::size_t i) const noexcept { return boxes_[i]; }
+
+        /*
+        After the coordinates of the given triangles changed in place, updates their boxes and the boxes
+        of the nodes above them, O(count * depth). The tree keeps its shape: it stays correct however far
+        the triangles move, but queries slow down when they move far, build a new hierarchy then
+        */
+        void refit(const std::uint32_t* triangles, std::size_t count);
+
+    private:
+        const double* triangles_;
+        std::vector<Aabb> boxes_;
+        std::vector<Node> nodes_;
+        std::vector<std::uint32_t> indices_;
+        std::vector<std::uint32_t> parents_; // of every node, filled by the first refit
+        std::vector<std::uint32_t> leaves_;  // leaf of every triangle, filled by the first refit
+    };
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "intersection.hpp"
+
+namespace triangle_intersection {
+    /*
+    The single-triangle queries of StaticScene over a compressed layout, for scenes whose size makes
+    the queries wait on memory. Nodes keep float boxes rounded outwards (32 bytes), leaves hold up to
+    LEAF_SIZE triangles with every coordinate quantized to 16 bits within the box of the leaf (18 bytes),
+    and the soup itself is not copied: like Bvh, the scene reads the caller's triangles, which must outlive it.
+    A candidate is decoded into boxes around its vertices that surely contain them. It is rejected when its box
+    misses the query or, both being regular triangles, when the plane of the query surely separates them.
+    Only the remaining candidates read their doubles from the soup for the exact test. The hits are those of StaticScene.
+    Coordinates must be finite and within the float range
+    */
+    class CompactScene {
+    public:
+        struct alignas(32) Node {
+            float min[3];
+            float max[3];
+            std::uint32_t offset;  // right child for inner nodes, first triangle of the leaf
+            std::uint16_t count;   // number of triangles in a leaf, 0 for inner nodes
+            std::uint16_t regular; // the first regular triangles of a leaf are neither degenerate nor flat
+
+            bool is_leaf() const noexcept { return count != 0; }
+        };
+
+        // coordinate k of a vertex is min[k] + q * (max[k] - min[k]) / 65535 of its leaf, rounded down
+        struct QuantizedTriangle {
+            std::uint16_t coords[9];
+        };
+
+        // subtrees of the hierarchy with at most LEAF_SIZE triangles become one leaf
+        static constexpr std::uint32_t LEAF_SIZE = 8;
+        static constexpr int MAX_DEPTH = 128;
+
+        // triangles holds count * 9 doubles and is read by every query
+        CompactScene(const double* triangles, std::size_t count);
+
+        std::size_t size() const noexcept { return ids_.size(); }
+        // bytes of the scene and of the soup it reads, its footprint against StaticScene
+        std::size_t get_memory_size() const noexcept;
+
+        // as in StaticScene
+        bool have_any_hit(const double t[9]) const noexcept;
+        std::size_t get_hits(const double t[9], std::uint32_t* hits, std::size_t max_hits) const noexcept;
+        void get_all_hits(const double t[9], std::vector<std::uint32_t>& hits) const;
+
+        const std::vector<Node>& nodes() const noexcept { return nodes_; }
+
+    private:
+        template <class Visit>
+        void traverse(const double t[9], Visit& visit) const;
+
+        const double* soup_;
+        std::vector<Node> nodes_;
+        std::vector<QuantizedTriangle> triangles_;
+        std::vector<std::uint32_t> ids_;
+    };
+}
@@ -0,0 +1,381 @@
+#pragma once
+
+#include <algorithm>
+#include "kernel.hpp"
+
+namespace triangle_intersection {
+    namespace geometry {
+        // clipped polygons stay below this, a triangle cut by three lines has at most 6 vertices
+        constexpr int POLYGON_SIZE = 9;
+
+        TRIANGLE_INTERSECTION_INLINE void copy_point(const double p[3], double q[3]) {
+            q[0] = p[0];
+            q[1] = p[1];
+            q[2] = p[2];
+        }
+
+        // q = p1 + a * (p2 - p1)
+        TRIANGLE_INTERSECTION_INLINE void interpolate(const double p1[3], const double p2[3], double a, double q[3]) {
+            for (int i = 0; i < 3; i++) {
+                q[i] = p1[i] + a * (p2[i] - p1[i]);
+            }
+        }
+
+        TRIANGLE_INTERSECTION_INLINE bool is_same_point(const double p1[3], const double p2[3]) {
+            return p1[0] == p2[0] && p1[1] == p2[1] && p1[2] == p2[2];
+        }
+
+        TRIANGLE_INTERSECTION_INLINE void add_point(Intersection& result, const double p[3]) {
+            for (std::size_t i = 0; i < result.count; i++) {
+                if (is_same_point(result.points[i], p)) {
+                    return;
+                }
+            }
+            copy_point(p, result.points[result.count++]);
+        }
+
+        TRIANGLE_INTERSECTION_INLINE void set_kind(Intersection& result) {
+            result.kind = result.count == 0 ? Intersection::Kind::None
+                : result.count == 1 ? Intersection::Kind::Point
+                : result.count == 2 ? Intersection::Kind::Segment
+                : Intersection::Kind::Polygon;
+        }
+
+        TRIANGLE_INTERSECTION_INLINE void set_segment(Intersection& result, const double p1[3], const double p2[3]) {
+            result.count = 0;
+            add_point(result, p1);
+            add_point(result, p2);
+            set_kind(result);
+        }
+
+        // the vertices of t (projected along k) counterclockwise
+        template <class Predicates>
+        void get_counterclockwise(const double* const t[3], int k, const double* ccw[3], double ccw_2d[6]) {
+            ccw[0] = t[0];
+            ccw[1] = t[1];
+            ccw[2] = t[2];
+            project_t_2d(ccw, ccw_2d, k);
+            if (Predicates::orient2d(ccw_2d, ccw_2d + 2, ccw_2d + 4) < 0) {
+                std::swap(ccw[1], ccw[2]);
+                project_t_2d(ccw, ccw_2d, k);
+            }
+        }
+
+        // positive on the left of the edge a -> b of the projection
+        template <class Predicates>
+        double get_side(const double a[2], const double b[2], const double p[3], int k) {
+            double p_2d[2];
+            project_p_2d(p, p_2d, k);
+            return Predicates::orient2d(a, b, p_2d);
+        }
+
+        /*
+        Sutherland-Hodgman: keeps the part of the polygon inside the counterclockwise triangle t,
+        both in the plane projected along k
+        */
+        template <class Predicates>
+        int clip_polygon(const double* const t[3], int k, double polygon[POLYGON_SIZE][3], int n) {
+            const double* ccw[3];
+            double ccw_2d[6];
+            get_counterclockwise<Predicates>(t, k, ccw, ccw_2d);
+
+            double clipped[POLYGON_SIZE][3];
+            for (int e = 0; e < 3 && n > 0; e++) {
+                const double* a = ccw_2d + 2 * e;
+                const double* b = ccw_2d + 2 * ((e + 1) % 3);
+
+                double side[POLYGON_SIZE];
+                for (int i = 0; i < n; i++) {
+                    side[i] = get_side<Predicates>(a, b, polygon[i], k);
+                }
+
+                int m = 0;
+                for (int i = 0; i < n && m < POLYGON_SIZE - 1; i++) {
+                    int j = (i + 1) % n;
+                    if (side[i] >= 0) {
+                        copy_point(polygon[i], clipped[m++]);
+                    }
+                    if ((side[i] > 0 && side[j] < 0) || (side[i] < 0 && side[j] > 0)) {
+                        interpolate(polygon[i], polygon[j], side[i] / (side[i] - side[j]), clipped[m++]);
+                    }
+                }
+
+                for (int i = 0; i < m; i++) {
+                    copy_point(clipped[i], polygon[i]);
+                }
+                n = m;
+            }
+
+            return n;
+        }
+
+        // the part of the segment s inside the triangle t, both in the plane projected along k
+        template <class Predicates>
+        void clip_segment(const double* const t[3], int k, const double* const s[2], Intersection& result) {
+            const double* ccw[3];
+            double ccw_2d[6];
+            get_counterclockwise<Predicates>(t, k, ccw, ccw_2d);
+
+            double first = 0, last = 1;
+            for (int e = 0; e < 3; e++) {
+                const double* a = ccw_2d + 2 * e;
+                const double* b = ccw_2d + 2 * ((e + 1) % 3);
+                double side0 = get_side<Predicates>(a, b, s[0], k);
+                double side1 = get_side<Predicates>(a, b, s[1], k);
+
+                if (side0 < 0 && side1 >= 0) {
+                    first = std::max(first, side0 / (side0 - side1));
+                } else if (side1 < 0 && side0 >= 0) {
+                    last = std::min(last, side0 / (side0 - side1));
+                }
+            }
+
+            if (first > last) {
+                // the kernel found a hit, the rounded parameters crossed over
+                first = last = (first + last) / 2;
+            }
+
+            double p1[3], p2[3];
+            interpolate(s[0], s[1], first, p1);
+            interpolate(s[0], s[1], last, p2);
+            set_segment(result, first == 0 ? s[0] : p1, last == 1 ? s[1] : p2);
+        }
+
+        /*
+        A point where the coplanar triangles t1 and t2 touch, projected along k, for contacts too thin for the clip:
+        a vertex of one triangle inside or on the other, or else a crossing of two edges. False when they do not touch
+        */
+        template <class Predicates>
+        bool get_touching_point(const double* const t1[3], const double* const t2[3], int k, double p[3]) {
+            for (int order = 0; order < 2; order++) {
+                const double* const* a = order == 0 ? t1 : t2;
+                const double* const* b = order == 0 ? t2 : t1;
+                const double* ccw[3];
+                double ccw_2d[6];
+                get_counterclockwise<Predicates>(b, k, ccw, ccw_2d);
+
+                for (int i = 0; i < 3; i++) {
+                    bool inside = true;
+                    for (int e = 0; e < 3 && inside; e++) {
+                        inside = get_side<Predicates>(ccw_2d + 2 * e, ccw_2d + 2 * ((e + 1) % 3), a[i], k) >= 0;
+                    }
+                    if (inside) {
+                        copy_point(a[i], p);
+                        return true;
+                    }
+                }
+            }
+
+            for (int i = 0; i < 3; i++) {
+                const double* s1[2] = { t1[i], t1[(i + 1) % 3] };
+                double s1_2d[4];
+                project_p_2d(s1[0], s1_2d, k);
+                project_p_2d(s1[1], s1_2d + 2, k);
+                for (int j = 0; j < 3; j++) {
+                    const double* s2[2] = { t2[j], t2[(j + 1) % 3] };
+                    double s2_2d[4];
+                    project_p_2d(s2[0], s2_2d, k);
+                    project_p_2d(s2[1], s2_2d + 2, k);
+
+                    double side0 = Predicates::orient2d(s2_2d, s2_2d + 2, s1_2d);
+                    double side1 = Predicates::orient2d(s2_2d, s2_2d + 2, s1_2d + 2);
+                    double side2 = Predicates::orient2d(s1_2d, s1_2d + 2, s2_2d);
+                    double side3 = Predicates::orient2d(s1_2d, s1_2d + 2, s2_2d + 2);
+                    if (((side0 < 0 && side1 > 0) || (side0 > 0 && side1 < 0)) && ((side2 < 0 && side3 > 0) || (side2 > 0 && side3 < 0))) {
+                        interpolate(s1[0], s1[1], side0 / (side0 - side1), p);
+                        return true;
+                    }
+                }
+            }
+
+            return false;
+        }
+
+        // the points where t meets the plane its vertices have the orientations d against, one or two
+        TRIANGLE_INTERSECTION_INLINE int get_plane_crossing(const double* const t[3], const double d[3], double p[2][3]) {
+            int n = 0;
+            for (int i = 0; i < 3 && n < 2; i++) {
+                if (d[i] == 0) {
+                    copy_point(t[i], p[n++]);
+                }
+            }
+            for (int i = 0; i < 3 && n < 2; i++) {
+                int j = (i + 1) % 3;
+                if ((d[i] > 0 && d[j] < 0) || (d[i] < 0 && d[j] > 0)) {
+                    interpolate(t[i], t[j], d[i] / (d[i] - d[j]), p[n++]);
+                }
+            }
+
+            return n;
+        }
+    }
+
+    TRIANGLE_INTERSECTION_INLINE void clear_output(SegmentOutput& output) {
+        output.result.kind = Intersection::Kind::None;
+        output.result.count = 0;
+    }
+
+    TRIANGLE_INTERSECTION_INLINE bool report_point(SegmentOutput& output, bool hit, const double p[3]) {
+        if (hit) {
+            geometry::set_segment(output.result, p, p);
+        }
+
+        return hit;
+    }
+
+    TRIANGLE_INTERSECTION_INLINE bool report_s_s(SegmentOutput& output, bool hit, const double* const s1[2], const double* const s2[2]) {
+        if (!hit) {
+            return false;
+        }
+
+        // same parameters as have_intersection_s_s
+
+        double dir1[3] = { s1[1][0] - s1[0][0], s1[1][1] - s1[0][1], s1[1][2] - s1[0][2] };
+        double dir2[3] = { s2[1][0] - s2[0][0], s2[1][1] - s2[0][1], s2[1][2] - s2[0][2] };
+        double v[3] = { s1[0][0] - s2[0][0], s1[0][1] - s2[0][1], s1[0][2] - s2[0][2] };
+
+        double a = dot_product(dir1, dir1);
+        double b = dot_product(dir1, dir2);
+        double c = dot_product(dir2, dir2);
+        double det = a * c - b * b;
+
+        if (det >= EPS) {
+            double coef1 = (b * dot_product(dir2, v) - c * dot_product(dir1, v)) / det;
+            double p[3];
+            geometry::interpolate(s1[0], s1[1], coef1, p);
+            geometry::set_segment(output.result, p, p);
+            return true;
+        }
+
+        // overlapping collinear segments, the overlap is taken along s1
+        double w0[3] = { s2[0][0] - s1[0][0], s2[0][1] - s1[0][1], s2[0][2] - s1[0][2] };
+        double w1[3] = { s2[1][0] - s1[0][0], s2[1][1] - s1[0][1], s2[1][2] - s1[0][2] };
+        double u0 = dot_product(w0, dir1) / a;
+        double u1 = dot_product(w1, dir1) / a;
+
+        double first = std::max(0.0, std::min(u0, u1));
+        double last = std::min(1.0, std::max(u0, u1));
+        if (first > last) {
+            first = last = (first + last) / 2;
+        }
+
+        double p1[3], p2[3];
+        geometry::interpolate(s1[0], s1[1], first, p1);
+        geometry::interpolate(s1[0], s1[1], last, p2);
+        geometry::set_segment(output.result, first == u0 ? s2[0] : first == u1 ? s2[1] : first == 0 ? s1[0] : p1,
+                    last == u0 ? s2[0] : last == u1 ? s2[1] : last == 1 ? s1[1] : p2);
+        return true;
+    }
+
+    template <class Predicates>
+    bool report_t_s(SegmentOutput& output, bool hit, const double* const t[3], const double* const s[2]) {
+        if (!hit) {
+            return false;
+        }
+
+        // same parameters as have_intersection_t_s
+
+        double edge1[3] = { t[1][0] - t[0][0], t[1][1] - t[0][1], t[1][2] - t[0][2] };
+        double edge2[3] = { t[2][0] - t[0][0], t[2][1] - t[0][1], t[2][2] - t[0][2] };
+        double dir[3] = { s[1][0] - s[0][0], s[1][1] - s[0][1], s[1][2] - s[0][2] };
+
+        double v1[3];
+        cross_product(dir, edge2, v1);
+        double det = dot_product(edge1, v1);
+
+        if (std::abs(det) < EPS) {
+            // the segment lies in the plane of the triangle
+            geometry::clip_segment<Predicates>(t, get_dominant_axis(t), s, output.result);
+            return true;
+        }
+
+        double v2[3] = { s[0][0] - t[0][0], s[0][1] - t[0][1], s[0][2] - t[0][2] };
+        double v3[3];
+        cross_product(v2, edge1, v3);
+        double r = std::min(1.0, std::max(0.0, dot_product(edge2, v3) / det));
+
+        double p[3];
+        geometry::interpolate(s[0], s[1], r, p);
+        geometry::set_segment(output.result, r == 0 ? s[0] : r == 1 ? s[1] : p, r == 0 ? s[0] : r == 1 ? s[1] : p);
+        return true;
+    }
+
+    TRIANGLE_INTERSECTION_INLINE bool report_interval(SegmentOutput& output, bool hit, const double* const t1[3], const double* const t2[3], const double d1[3], const double d2[3]) {
+        if (!hit) {
+            return false;
+        }
+
+        /*
+        Both triangles meet the line common to the two planes along an interval
+        whose ends are crossing points of their edges, the result is the overlap
+        */
+
+        double p1[2][3], p2[2][3];
+        int n1 = geometry::get_plane_crossing(t1, d1, p1);
+        int n2 = geometry::get_plane_crossing(t2, d2, p2);
+
+        double e1[3] = { t1[1][0] - t1[0][0], t1[1][1] - t1[0][1], t1[1][2] - t1[0][2] };
+        double e2[3] = { t1[2][0] - t1[0][0], t1[2][1] - t1[0][1], t1[2][2] - t1[0][2] };
+        double e3[3] = { t2[1][0] - t2[0][0], t2[1][1] - t2[0][1], t2[1][2] - t2[0][2] };
+        double e4[3] = { t2[2][0] - t2[0][0], t2[2][1] - t2[0][1], t2[2][2] - t2[0][2] };
+        double normal1[3], normal2[3], line[3];
+        cross_product(e1, e2, normal1);
+        cross_product(e3, e4, normal2);
+        cross_product(normal1, normal2, line);
+
+        const double* ends1[2] = { p1[0], p1[n1 - 1] };
+        const double* ends2[2] = { p2[0], p2[n2 - 1] };
+        if (dot_product(ends1[0], line) > dot_product(ends1[1], line)) {
+            std::swap(ends1[0], ends1[1]);
+        }
+        if (dot_product(ends2[0], line) > dot_product(ends2[1], line)) {
+            std::swap(ends2[0], ends2[1]);
+        }
+
+        const double* first = dot_product(ends1[0], line) >= dot_product(ends2[0], line) ? ends1[0] : ends2[0];
+        const double* last = dot_product(ends1[1], line) <= dot_product(ends2[1], line) ? ends1[1] : ends2[1];
+        if (dot_product(first, line) > dot_product(last, line)) {
+            // the intervals touch, the rounded crossing points missed each other
+            last = first;
+        }
+
+        geometry::set_segment(output.result, first, last);
+        return true;
+    }
+
+    template <class Predicates>
+    bool report_coplanar_t_t(SegmentOutput& output, bool hit, const double* const t1[3], const double* const t2[3], int k) {
+        if (!hit) {
+            return false;
+        }
+
+        const double* s[2];
+        if (is_flat<Predicates>(t2)) {
+            get_longest_side(t2, s);
+            geometry::clip_segment<Predicates>(t1, k, s, output.result);
+            return true;
+        }
+
+        double polygon[geometry::POLYGON_SIZE][3];
+        for (int i = 0; i < 3; i++) {
+            geometry::copy_point(t1[i], polygon[i]);
+        }
+        int n = geometry::clip_polygon<Predicates>(t2, k, polygon, 3);
+
+        Intersection& result = output.result;
+        result.count = 0;
+        for (int i = 0; i < n && result.count < 6; i++) {
+            geometry::add_point(result, polygon[i]);
+        }
+
+        double p[3];
+        if (result.count == 0 && geometry::get_touching_point<Predicates>(t1, t2, k, p)) {
+            // touching at rounding level, the clip lost the contact
+            geometry::add_point(result, p);
+        }
+
+        geometry::set_kind(result);
+        return true;
+    }
+
+}
@@ -0,0 +1,448 @@
+#pragma once
+
+#include "kernel.hpp"
+
+// header-only builds have no branch statistics, the library defines the probes in stats_private.hpp
+#ifndef TRIANGLE_INTERSECTION_PROBE
+#define TRIANGLE_INTERSECTION_PROBE static_cast<void>(0)
+#define TRIANGLE_INTERSECTION_EXIT(branch, value) (value)
+#endif
+
+namespace triangle_intersection {
+    TRIANGLE_INTERSECTION_INLINE bool have_intersection(double t1[9], double t2[9]) noexcept {
+        const double* v1[3] = { t1, t1 + 3, t1 + 6 };
+        const double* v2[3] = { t2, t2 + 3, t2 + 6 };
+
+        return have_intersection(v1, v2);
+    }
+
+    TRIANGLE_INTERSECTION_INLINE bool have_intersection(const VertexView& vertices1, const std::uint32_t triangle1[3],
+                                                        const VertexView& vertices2, const std::uint32_t triangle2[3]) noexcept {
+        const double* t1[3] = {
+            vertices1.data + triangle1[0] * vertices1.stride,
+            vertices1.data + triangle1[1] * vertices1.stride,
+            vertices1.data + triangle1[2] * vertices1.stride
+        };
+        const double* t2[3] = {
+            vertices2.data + triangle2[0] * vertices2.stride,
+            vertices2.data + triangle2[1] * vertices2.stride,
+            vertices2.data + triangle2[2] * vertices2.stride
+        };
+
+        return have_intersection(t1, t2);
+    }
+
+    TRIANGLE_INTERSECTION_INLINE bool have_intersection(const double* const t1[3], const double* const t2[3]) noexcept {
+        return have_intersection<RobustPredicates>(t1, t2);
+    }
+
+    TRIANGLE_INTERSECTION_INLINE bool have_intersection(const double t1[9], const double t2[9], Intersection& result) noexcept {
+        const double* v1[3] = { t1, t1 + 3, t1 + 6 };
+        const double* v2[3] = { t2, t2 + 3, t2 + 6 };
+
+        SegmentOutput output;
+        bool hit = have_intersection<RobustPredicates>(v1, v2, output);
+        result = output.result;
+        return hit;
+    }
+
+    template <class Predicates>
+    bool have_intersection(const double* const t1[3], const double* const t2[3]) noexcept {
+        BoolOutput output;
+        return have_intersection<Predicates>(t1, t2, output);
+    }
+
+    template <class Predicates, class Output>
+    bool have_intersection(const double* const v1[3], const double* const v2[3], Output& output) noexcept {
+        return have_intersection_kernel<Predicates, true>(v1, v2, output);
+    }
+
+    template <class Predicates, class Output>
+    bool have_intersection(const double* const v1[3], const double* const v2[3], Output& output, AssumeNonDegenerate) noexcept {
+        return have_intersection_kernel<Predicates, false>(v1, v2, output);
+    }
+
+    TRIANGLE_INTERSECTION_INLINE bool have_intersection(const double t1[9], const double t2[9], AssumeNonDegenerate) noexcept {
+        const double* v1[3] = { t1, t1 + 3, t1 + 6 };
+        const double* v2[3] = { t2, t2 + 3, t2 + 6 };
+
+        BoolOutput output;
+        return have_intersection_kernel<RobustPredicates, false>(v1, v2, output);
+    }
+
+    template <class Predicates, bool CheckDegenerate, class Output>
+    bool have_intersection_kernel(const double* const v1[3], const double* const v2[3], Output& output) noexcept {
+        TRIANGLE_INTERSECTION_PROBE;
+
+        try {
+            clear_output(output);
+
+            const double* t1[3] = { v1[0], v1[1], v1[2] };
+            const double* t2[3] = { v2[0], v2[1], v2[2] };
+
+            // CheckDegenerate is constant per instantiation, without it the point and segment tests compile away
+
+            if (CheckDegenerate && is_point(t1)) {
+                if (is_point(t2)) {
+                    return TRIANGLE_INTERSECTION_EXIT(PointPoint, report_point(output, have_intersection_p_p(t1[0], t2[0]), t1[0]));
+                }
+                if (is_segment(t2)) {
+                    return TRIANGLE_INTERSECTION_EXIT(PointSegment, report_point(output, have_intersection_s_p(t2, t1[0]), t1[0]));
+                }
+                return TRIANGLE_INTERSECTION_EXIT(PointTriangle, report_point(output, have_intersection_t_p(t2, t1[0]), t1[0]));
+            }
+
+            if (CheckDegenerate && is_point(t2)) {
+                if (is_segment(t1)) {
+                    return TRIANGLE_INTERSECTION_EXIT(PointSegment, report_point(output, have_intersection_s_p(t1, t2[0]), t2[0]));
+                }
+                return TRIANGLE_INTERSECTION_EXIT(PointTriangle, report_point(output, have_intersection_t_p(t1, t2[0]), t2[0]));
+            }
+
+            if (CheckDegenerate && is_segment(t1)) {
+                if (is_segment(t2)) {
+                    return TRIANGLE_INTERSECTION_EXIT(SegmentSegment, report_s_s(output, have_intersection_s_s(t1, t2), t1, t2));
+                }
+                return TRIANGLE_INTERSECTION_EXIT(SegmentTriangle, report_t_s<Predicates>(output, have_intersection_t_s(t2, t1), t2, t1));
+            }
+
+            if (CheckDegenerate && is_segment(t2)) {
+                return TRIANGLE_INTERSECTION_EXIT(SegmentTriangle, report_t_s<Predicates>(output, have_intersection_t_s(t1, t2), t1, t2));
+            }
+
+            double d1[3] = { 
+                Predicates::orient3d(t2[0], t2[1], t2[2], t1[0]), 
+                Predicates::orient3d(t2[0], t2[1], t2[2], t1[1]), 
+                Predicates::orient3d(t2[0], t2[1], t2[2], t1[2])
+            };
+
+            if (d1[0] == 0 && d1[1] == 0 && d1[2] == 0) {
+
+                /*
+                A flat triangle has no plane: every point gives a zero determinant.
+                is_segment can miss one by rounding, the test against its longest side handles it
+                */
+
+                const double* s[2];
+                if (is_flat<Predicates>(t2)) {
+                    get_longest_side(t2, s);
+                    return TRIANGLE_INTERSECTION_EXIT(SegmentTriangle, report_t_s<Predicates>(output, have_intersection_t_s(t1, s), t1, s));
+                }
+                if (is_flat<Predicates>(t1)) {
+                    get_longest_side(t1, s);
+                    return TRIANGLE_INTERSECTION_EXIT(SegmentTriangle, report_t_s<Predicates>(output, have_intersection_t_s(t2, s), t2, s));
+                }
+
+                int k = get_dominant_axis(t1);
+                return TRIANGLE_INTERSECTION_EXIT(Coplanar, report_coplanar_t_t<Predicates>(output, have_intersection_coplanar_t_t<Predicates>(t1, t2, k), t1, t2, k));
+            }
+
+            if ((d1[0] < 0 && d1[1] < 0 && d1[2] < 0) || (d1[0] > 0 && d1[1] > 0 && d1[2] > 0)) {
+                return TRIANGLE_INTERSECTION_EXIT(FirstPlaneReject, false);
+            }
+
+            double d2[3] = {
+                Predicates::orient3d(t1[0], t1[1], t1[2], t2[0]), 
+                Predicates::orient3d(t1[0], t1[1], t1[2], t2[1]),
+                Predicates::orient3d(t1[0], t1[1], t1[2], t2[2])
+            };
+
+            if ((d2[0] < 0 && d2[1] < 0 && d2[2] < 0) || (d2[0] > 0 && d2[1] > 0 && d2[2] > 0)) {
+                return TRIANGLE_INTERSECTION_EXIT(SecondPlaneReject, false);
+            }
+
+            if (d2[0] == 0 && d2[1] == 0 && d2[2] == 0 && is_flat<Predicates>(t1)) {
+                // t1 is not in the plane of t2, only a flat t1 gives three zeros
+                const double* s[2];
+                get_longest_side(t1, s);
+                return TRIANGLE_INTERSECTION_EXIT(SegmentTriangle, report_t_s<Predicates>(output, have_intersection_t_s(t2, s), t2, s));
+            }
+
+            // d1 and d2 follow the vertex order before reordering
+            const double* u1[3] = { t1[0], t1[1], t1[2] };
+            const double* u2[3] = { t2[0], t2[1], t2[2] };
+            reorder_points(t1, t2, d1, d2);
+
+            double d[2] = {
+                Predicates::orient3d(t1[0], t1[1], t2[0], t2[1]),
+                Predicates::orient3d(t1[0], t1[2], t2[2], t2[0])
+            };
+
+            return TRIANGLE_INTERSECTION_EXIT(Interval, report_interval(output, d[0] >= 0 && d[1] >= 0, u1, u2, d1, d2));
+        } catch (...) {
+            clear_output(output);
+            return TRIANGLE_INTERSECTION_EXIT(Error, false);
+        }
+    }
+
+    TRIANGLE_INTERSECTION_INLINE bool have_intersection_t_s(const double* const t[3], const double* const s[2]) {
+        double edge1[3] = { t[1][0] - t[0][0], t[1][1] - t[0][1], t[1][2] - t[0][2] };
+        double edge2[3] = { t[2][0] - t[0][0], t[2][1] - t[0][1], t[2][2] - t[0][2] };
+
+        return have_intersection_t_s(t, edge1, edge2, s);
+    }
+
+    TRIANGLE_INTERSECTION_INLINE bool have_intersection_t_s(const double* const t[3], const double edge1[3], const double edge2[3], const double* const s[2]) {
+        double dir[3] = {
+            s[1][0] - s[0][0],
+            s[1][1] - s[0][1],
+            s[1][2] - s[0][2]
+        };
+
+        double v1[3];
+        cross_product(dir, edge2, v1);
+
+        double det = dot_product(edge1, v1);
+        if (std::abs(det) < EPS) {
+            double cp[3];
+            cross_product(edge1, edge2, cp);
+            
+            if (std::abs(dot_product(dir, cp)) >= EPS) {
+                return false;
+            }
+
+            const double* st1[2] = { t[0], t[1] };
+            const double* st2[2] = { t[1], t[2] };
+            const double* st3[2] = { t[0], t[2] };
+
+            return have_intersection_s_s(st1, s) || have_intersection_s_s(st2, s) || have_intersection_s_s(st3, s);
+        }
+
+        double invDet = 1.0 / det;
+
+        double v2[3] = {
+            s[0][0] - t[0][0],
+            s[0][1] - t[0][1],
+            s[0][2] - t[0][2]
+        };
+
+        double u = dot_product(v2, v1) * invDet;
+        if (u < -EPS || u > 1 + EPS) {
+            return false;
+        }
+
+        double v3[3];
+        cross_product(v2, edge1, v3);
+
+        double v = dot_product(dir, v3) * invDet;
+        if (v < -EPS || u + v > 1 + EPS) {
+            return false;
+        }
+
+        double r = dot_product(edge2, v3) * invDet;
+
+        if (r < -EPS || r > 1 + EPS) {
+            return false;
+        }
+
+        // r in [0, 1]: the crossing point lies on the segment
+        return true;
+    }
+    
+    TRIANGLE_INTERSECTION_INLINE void get_line_parameters(const double* const s1[2], const double* const s2[2], double& coef1, double& coef2) {
+        double dir1[3] = { s1[1][0] - s1[0][0], s1[1][1] - s1[0][1], s1[1][2] - s1[0][2] };
+        double dir2[3] = { s2[1][0] - s2[0][0], s2[1][1] - s2[0][1], s2[1][2] - s2[0][2] };
+        double v[3] = { s1[0][0] - s2[0][0], s1[0][1] - s2[0][1], s1[0][2] - s2[0][2] };
+
+        double a = dot_product(dir1, dir1); // always >= 0
+        double b = dot_product(dir1, dir2);
+        double c = dot_product(dir2, dir2); // always >= 0
+        double d = dot_product(dir1, v);
+        double e = dot_product(dir2, v);
+        double det = a * c - b * b;
+
+        if (det < EPS) {
+            // lines are almost parallel
+            coef1 = 0.0;
+            coef2 = (b > c ? d / b : e / c);
+        } else {
+            coef1 = (b * e - c * d) / det;
+            coef2 = (a * e - b * d) / det;
+        }
+    }
+
+    TRIANGLE_INTERSECTION_INLINE bool have_intersection_s_s(const double* const s1[2], const double* const s2[2]) {
+        double coef1, coef2;
+        get_line_parameters(s1, s2, coef1, coef2);
+
+        if (coef1 < 0 || coef1 > 1 || coef2 < 0 || coef2 > 1) {
+            return false;
+        }
+
+        double dir1[3] = { s1[1][0] - s1[0][0], s1[1][1] - s1[0][1], s1[1][2] - s1[0][2] };
+        double dir2[3] = { s2[1][0] - s2[0][0], s2[1][1] - s2[0][1], s2[1][2] - s2[0][2] };
+        double v[3] = { s1[0][0] - s2[0][0], s1[0][1] - s2[0][1], s1[0][2] - s2[0][2] };
+
+        double dist[3] = {
+            v[0] + coef1 * dir1[0] - coef2 * dir2[0],
+            v[1] + coef1 * dir1[1] - coef2 * dir2[1],
+            v[2] + coef1 * dir1[2] - coef2 * dir2[2]
+        };
+
+        return dot_product(dist, dist) <= EPS * EPS;
+    }
+
+    TRIANGLE_INTERSECTION_INLINE bool have_intersection_t_p(const double* const t[3], const double p[3]) {
+        double v1[3] = { t[1][0] - t[0][0], t[1][1] - t[0][1], t[1][2] - t[0][2] };
+        double v2[3] = { t[2][0] - t[0][0], t[2][1] - t[0][1], t[2][2] - t[0][2] };
+        double u[3] = { p[0] - t[0][0], p[1] - t[0][1], p[2] - t[0][2] };
+
+        double cp[3];
+        cross_product(v1, v2, cp);
+        
+        if (std::abs(dot_product(u, cp)) >= EPS) {
+            return false;
+        }
+
+        int k = get_dominant_axis(t);
+        double t1[6];
+        project_t_2d(t, t1, k);
+        double p1[2];
+        project_p_2d(p, p1, k);
+
+        return have_intersection_t_p_2d(t1, p1);
+    }
+
+    TRIANGLE_INTERSECTION_INLINE bool have_intersection_s_p(const double* const s[2], const double p[3]) {
+        return get_length(s[0], s[1]) == get_length(s[0], p) + get_length(p, s[1]); 
+    }
+
+    TRIANGLE_INTERSECTION_INLINE bool have_intersection_p_p(const double p1[3], const double p2[3]) {
+        return p1[0] == p2[0] && p1[1] == p2[1] && p1[2] == p2[2];
+    }
+    
+    template <class Predicates>
+    bool have_intersection_coplanar_t_t(const double* const t1[3], const double* const t2[3], int k) {
+        double t11[6], t21[6];
+        project_t_2d(t1, t11, k);
+        project_t_2d(t2, t21, k);
+
+        make_couterclockwise_2d<Predicates>(t11);
+        make_couterclockwise_2d<Predicates>(t21);
+
+        double p1[2] = { t11[0], t11[1] };
+        double q1[2] = { t11[2], t11[3] };
+        double r1[2] = { t11[4], t11[5] };
+        double p2[2] = { t21[0], t21[1] };
+        double q2[2] = { t21[2], t21[3] };
+        double r2[2] = { t21[4], t21[5] };
+
+        double d[3] = {
+            Predicates::orient2d(p2, q2, p1),
+            Predicates::orient2d(q2, r2, p1),
+            Predicates::orient2d(r2, p2, p1)
+        };
+
+        int count_zero = 0;
+        int count_pos = 0;
+        for (auto d : d) {
+            if (d == 0) {
+                count_zero++;
+            } else if (d > 0) {
+                count_pos++;
+            }
+        };
+
+        if (count_pos == 3) {
+            return true;
+        }
+
+        if (count_zero == 2) {
+            return true;
+        }
+
+        if (count_pos == 2 && count_zero == 1) {
+            return true;
+        }
+
+        if (count_pos == 0) {
+            // a counterclockwise triangle always has an edge seeing p1 on its positive side unless it is flat
+            const double* s[2];
+            get_longest_side(t2, s);
+            return have_intersection_t_s(t1, s);
+        }
+
+        while (!((d[0] > 0 && d[1] >= 0 && d[2] <= 0) || (d[0] > 0 && d[1] <= 0 && d[2] <= 0))) {
+            std::swap(q2[0], p2[0]);
+            std::swap(q2[1], p2[1]);
+            std::swap(d[1], d[0]);
+
+            std::swap(r2[0], q2[0]);
+            std::swap(r2[1], q2[1]);
+            std::swap(d[2], d[1]);
+        }
+
+        if (d[0] > 0 && d[1] >= 0 && d[2] <= 0) {
+            if (Predicates::orient2d(r2, p2, q1) >= 0) {
+                if (Predicates::orient2d(r2, p1, q1) < 0
+                    || Predicates::orient2d(p1, p2, q1) >= 0
+                    || Predicates::orient2d(p1, p2, r1) < 0) {
+                    return true;
+                }
+
+                return Predicates::orient2d(q1, r1, p2) >= 0;
+            } else {
+                if (Predicates::orient2d(r2, p2, r1) < 0
+                    || Predicates::orient2d(q1, r1, r2) < 0) {
+                    return false;
+                }
+
+                return Predicates::orient2d(p1, p1, r1) <= 0;
+            }
+        }
+        
+        if (Predicates::orient2d(r2, p2, q1) >= 0) {
+            if (Predicates::orient2d(q2, r2, q1) >= 0) {
+                if (Predicates::orient2d(p1, p2, q1) >= 0) {
+                    return Predicates::orient2d(p1, q2, q1) <= 0;
+                } else {
+                    if (Predicates::orient2d(p1, p2, r1) < 0) {
+                        return false;
+                    }
+                    return Predicates::orient2d(r2, p2, r1) >= 0;
+                }
+            } else {
+                if (Predicates::orient2d(p1, q2, q1) > 0
+                    || Predicates::orient2d(q2, r2, r1) < 0) {
+                    return false;
+                }
+
+                return Predicates::orient2d(q1, r1, q2) >= 0;
+            }
+        }
+
+        if (Predicates::orient2d(r2, p2, r1) < 0) {
+            return false;
+        }
+
+        if (Predicates::orient2d(q1, r1, r2) >= 0) {
+            return Predicates::orient2d(r1, p1, p2) >= 0;
+        }
+
+        if (Predicates::orient2d(q1, r1, q2) >= 0) {
+            return Predicates::orient2d(q2, r2, r1) >= 0;
+        }
+
+        return false;
+    }
+
+    TRIANGLE_INTERSECTION_INLINE bool have_intersection_s_s_2d(const double s1[4], const double s2[4]) {
+        double d1[2] = {
+            get_determinant_2d(s1, s1 + 2, s2),
+            get_determinant_2d(s1, s1 + 2, s2 + 2)
+        };
+        double d2[2] = {
+            get_determinant_2d(s2, s2 + 2, s1),
+            get_determinant_2d(s2, s2 + 2, s1 + 2)
+        };
+
+        return ((d1[0] > 0 && d1[1] < 0) || (d1[0] < 0 && d1[1] > 0))
+               && ((d2[0] > 0 && d2[1] < 0) || (d2[0] < 0 && d2[1] > 0));
+    }
+    
+    TRIANGLE_INTERSECTION_INLINE bool have_intersection_t_p_2d(const double t[6], const double p[2]) {
+        return is_same_side(t, t + 2, t + 4, p) 
+            && is_same_side(t + 2, t + 4, t, p) 
+            && is_same_side(t + 4, t, t + 2, p);
+    }
+}
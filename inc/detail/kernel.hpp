@@ -0,0 +1,143 @@
+#pragma once
+
+#include <cfloat>
+#include <cmath>
+#include <utility>
+#include "../intersection.hpp"
+
+/*
+Internals of the scalar kernel, shared by the compiled library and the header-only form.
+With TRIANGLE_INTERSECTION_HEADER_ONLY the definitions are included by intersection.hpp and marked inline,
+otherwise they are compiled once into the library. Either every translation unit of a program
+defines TRIANGLE_INTERSECTION_HEADER_ONLY or none does
+*/
+
+#ifdef TRIANGLE_INTERSECTION_HEADER_ONLY
+#define TRIANGLE_INTERSECTION_INLINE inline
+#else
+#define TRIANGLE_INTERSECTION_INLINE
+#endif
+
+// functions writing through a pointer are only constexpr from C++14 on
+#if __cplusplus >= 201402L || (defined(_MSVC_LANG) && _MSVC_LANG >= 201402L)
+#define TRIANGLE_INTERSECTION_CONSTEXPR constexpr
+#else
+#define TRIANGLE_INTERSECTION_CONSTEXPR inline
+#endif
+
+namespace triangle_intersection {
+    constexpr double EPS = 1e-12;
+
+    /*
+    Relative error bounds (times the sum of the magnitudes of the products) of get_determinant_2d,
+    get_determinant_3d and of the plane evaluations of prepared triangles, with some slack.
+    Below them the sign is recomputed exactly. EXPANSION_SIZE is the longest expansion
+    the exact orient3d can produce
+    */
+    constexpr double ORIENT2D_ERROR_BOUND = 3 * DBL_EPSILON;
+    constexpr double ORIENT3D_ERROR_BOUND = 6 * DBL_EPSILON;
+    constexpr double PLANE_ERROR_BOUND = 8 * DBL_EPSILON;
+    constexpr int EXPANSION_SIZE = 192;
+
+    /*
+    Triangles and segments are passed as arrays of vertex pointers, reordering them only permutes the pointers.
+    None of these functions writes to the vertices
+    */
+
+    // body of every have_intersection on vertex pointers, CheckDegenerate false for AssumeNonDegenerate
+    template <class Predicates, bool CheckDegenerate, class Output>
+    bool have_intersection_kernel(const double* const t1[3], const double* const t2[3], Output& output) noexcept;
+
+    bool have_intersection_t_p(const double* const t[3], const double p[3]);
+    bool have_intersection_t_s(const double* const t[3], const double* const s[2]);
+    bool have_intersection_t_s(const double* const t[3], const double edge1[3], const double edge2[3], const double* const s[2]);
+    bool have_intersection_s_s(const double* const s1[2], const double* const s2[2]);
+    /*
+    Closest points of the lines through s1 and s2: s1[0] + coef1 * (s1[1] - s1[0]) and s2[0] + coef2 * (s2[1] - s2[0]).
+    For nearly parallel lines coef1 is 0 and coef2 the foot of s1[0], not finite when s2 is a point
+    */
+    void get_line_parameters(const double* const s1[2], const double* const s2[2], double& coef1, double& coef2);
+    bool have_intersection_s_p(const double* const s[2], const double p[3]);
+    bool have_intersection_p_p(const double p1[3], const double p2[3]);
+    // k is the axis dropped when projecting, get_dominant_axis(t1)
+    template <class Predicates>
+    bool have_intersection_coplanar_t_t(const double* const t1[3], const double* const t2[3], int k);
+
+    /*
+    Geometry of SegmentOutput, recorded at the exits of the kernel when hit is true.
+    The BoolOutput overloads only return hit and compile away
+    */
+
+    inline void clear_output(BoolOutput&) {}
+    inline bool report_point(BoolOutput&, bool hit, const double*) { return hit; }
+    inline bool report_s_s(BoolOutput&, bool hit, const double* const*, const double* const*) { return hit; }
+    template <class Predicates>
+    bool report_t_s(BoolOutput&, bool hit, const double* const*, const double* const*) { return hit; }
+    inline bool report_interval(BoolOutput&, bool hit, const double* const*, const double* const*, const double*, const double*) { return hit; }
+    template <class Predicates>
+    bool report_coplanar_t_t(BoolOutput&, bool hit, const double* const*, const double* const*, int) { return hit; }
+
+    void clear_output(SegmentOutput& output);
+    bool report_point(SegmentOutput& output, bool hit, const double p[3]);
+    bool report_s_s(SegmentOutput& output, bool hit, const double* const s1[2], const double* const s2[2]);
+    template <class Predicates>
+    bool report_t_s(SegmentOutput& output, bool hit, const double* const t[3], const double* const s[2]);
+    // d1: orientations of the vertices of t1 against the plane of t2, d2 the converse
+    bool report_interval(SegmentOutput& output, bool hit, const double* const t1[3], const double* const t2[3], const double d1[3], const double d2[3]);
+    template <class Predicates>
+    bool report_coplanar_t_t(SegmentOutput& output, bool hit, const double* const t1[3], const double* const t2[3], int k);
+
+    void reorder_points(const double* t1[3], const double* t2[3], const double d1[3], const double d2[3]);
+    int get_lone_vertex(const double d[3], int& side);
+    void rotate_points(const double* t[3], int first);
+    bool is_point(const double* const t[3]);
+    bool is_segment(const double* t[3]);
+    // all three vertices on a line, exactly with RobustPredicates
+    template <class Predicates>
+    bool is_flat(const double* const t[3]);
+    void get_longest_side(const double* const t[3], const double* s[2]);
+
+    template <class Predicates>
+    void make_couterclockwise_2d(double t[6]);
+    int get_dominant_axis(const double* const t[3]);
+    void project_t_2d(const double* const t1[3], double t2[6], int drop);
+    void project_p_2d(const double p1[3], double p2[2], int drop);
+    bool have_intersection_s_s_2d(const double s1[4], const double s2[4]);
+    bool have_intersection_t_p_2d(const double t[6], const double p[2]);
+
+    /*
+    Arithmetic helpers, defined here so that they inline into every loop of the kernel and of its callers
+    */
+
+    constexpr double dot_product(const double v1[3], const double v2[3]) {
+        return v1[0] * v2[0] + v1[1] * v2[1] + v1[2] * v2[2];
+    }
+
+    TRIANGLE_INTERSECTION_CONSTEXPR void cross_product(const double v1[3], const double v2[3], double cp[3]) {
+        cp[0] = v1[1] * v2[2] - v1[2] * v2[1];
+        cp[1] = v1[2] * v2[0] - v1[0] * v2[2];
+        cp[2] = v1[0] * v2[1] - v1[1] * v2[0];
+    }
+
+    constexpr double get_determinant_3d(const double p1[3], const double p2[3], const double p3[3], const double p4[3]) {
+        return ((p1[0] - p4[0]) * (p2[1] - p4[1]) * (p3[2] - p4[2])) + ((p1[1] - p4[1]) * (p2[2] - p4[2]) * (p3[0] - p4[0]))
+            + ((p1[2] - p4[2]) * (p2[0] - p4[0]) * (p3[1] - p4[1])) - ((p1[2] - p4[2]) * (p2[1] - p4[1]) * (p3[0] - p4[0]))
+            - ((p1[1] - p4[1]) * (p2[0] - p4[0]) * (p3[2] - p4[2])) - ((p1[0] - p4[0]) * (p2[2] - p4[2]) * (p3[1] - p4[1]));
+    }
+
+    constexpr double get_determinant_2d(const double p1[2], const double p2[2], const double p3[2]) {
+        return (p1[0] - p3[0]) * (p2[1] - p3[1]) - (p1[1] - p3[1]) * (p2[0] - p3[0]);
+    }
+
+    TRIANGLE_INTERSECTION_CONSTEXPR bool is_same_side(const double sp1[2], const double sp2[2], const double p1[2], const double p2[2]) {
+        double d1 = get_determinant_2d(sp1, sp2, p1);
+        double d2 = get_determinant_2d(sp1, sp2, p2);
+
+        return (d1 < 0 && d2 < 0) || (d1 > 0 && d2 > 0);
+    }
+
+    inline double get_length(const double p1[3], const double p2[3]) {
+        // L == sqrt((x2 - x1) ^ 2 + (y2 - y1) ^ 2 + (z2 - z1) ^ 2)
+        return std::sqrt(std::pow(p2[0] - p1[0], 2.0) + std::pow(p2[1] - p1[1], 2.0) + std::pow(p2[2] - p1[2], 2.0));
+    }
+}
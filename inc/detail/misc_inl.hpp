@@ -0,0 +1,190 @@
+#pragma once
+
+#include "kernel.hpp"
+
+namespace triangle_intersection {
+    TRIANGLE_INTERSECTION_INLINE int get_lone_vertex(const double d[3], int& side) {
+
+        /*
+        Returns the index of the vertex lying alone on its side of the other plane.
+        A vertex on the plane counts as lying on the side opposite to the two others,
+        side receives the sign of that side
+        */
+
+        if (d[0] > 0) {
+            if (d[1] > 0) {
+                side = -1;
+                return 2;
+            }
+            side = d[2] > 0 ? -1 : 1;
+            return d[2] > 0 ? 1 : 0;
+        }
+
+        if (d[0] < 0) {
+            if (d[1] < 0) {
+                side = 1;
+                return 2;
+            }
+            side = d[2] < 0 ? 1 : -1;
+            return d[2] < 0 ? 1 : 0;
+        }
+
+        if (d[1] < 0) {
+            side = d[2] >= 0 ? -1 : 1;
+            return d[2] >= 0 ? 1 : 0;
+        }
+
+        if (d[1] > 0) {
+            side = d[2] > 0 ? -1 : 1;
+            return d[2] > 0 ? 0 : 1;
+        }
+
+        side = d[2] > 0 ? 1 : -1;
+        return 2;
+    }
+
+    TRIANGLE_INTERSECTION_INLINE void rotate_points(const double* t[3], int first) {
+        if (first == 1) {
+            // p, q, r -> q, r, p
+            std::swap(t[1], t[0]);
+            std::swap(t[2], t[1]);
+        } else if (first == 2) {
+            // p, q, r -> r, p, q
+            std::swap(t[1], t[0]);
+            std::swap(t[2], t[0]);
+        }
+    }
+
+    TRIANGLE_INTERSECTION_INLINE void reorder_points(const double* t1[3], const double* t2[3], const double d1[3], const double d2[3]) {
+        int side1, side2;
+        rotate_points(t1, get_lone_vertex(d1, side1));
+        rotate_points(t2, get_lone_vertex(d2, side2));
+
+        // the orientation of each triangle is picked from the side the lone vertex of the other one lies on
+        if (side2 > 0) {
+            std::swap(t1[1], t1[2]);
+        }
+
+        if (side1 > 0) {
+            std::swap(t2[1], t2[2]);
+        }
+    }
+
+    TRIANGLE_INTERSECTION_INLINE bool is_point(const double* const t[3]) {
+        return t[0][0] == t[1][0] && t[0][0] == t[2][0] && t[0][1] == t[1][1] && t[0][1] == t[2][1] && t[0][2] == t[1][2] && t[0][2] == t[2][2];
+    }
+
+    TRIANGLE_INTERSECTION_INLINE bool is_segment(const double* t[3]) {
+        
+        /* 
+        This function also reorders the points if necessary 
+        to have the segment endpoints stored at the neginning of the array 
+        */
+
+        double l1 = get_length(t[0], t[1]);
+        double l2 = get_length(t[0], t[2]);
+        double l3 = get_length(t[1], t[2]);
+
+        if (l2 == l1 + l3) {
+            std::swap(t[1], t[2]);
+
+            return true;
+        }
+
+        if (l3 == l1 + l2) {
+            std::swap(t[0], t[2]);
+
+            return true;
+        }
+
+        if (l1 == l2 + l3) {
+            return true;
+        }
+
+        /*
+        The length sums are rounded and miss some collinear triangles,
+        an exactly null normal catches them. The longest side holds the endpoints
+        */
+
+        double edge1[3] = { t[1][0] - t[0][0], t[1][1] - t[0][1], t[1][2] - t[0][2] };
+        double edge2[3] = { t[2][0] - t[0][0], t[2][1] - t[0][1], t[2][2] - t[0][2] };
+        double normal[3];
+        cross_product(edge1, edge2, normal);
+
+        if (normal[0] != 0 || normal[1] != 0 || normal[2] != 0) {
+            return false;
+        }
+
+        if (l2 >= l1 && l2 >= l3) {
+            std::swap(t[1], t[2]);
+        } else if (l3 >= l1) {
+            std::swap(t[0], t[2]);
+        }
+
+        return true;
+    }
+
+    template <class Predicates>
+    bool is_flat(const double* const t[3]) {
+        for (int drop = 0; drop < 3; drop++) {
+            double t2[6];
+            project_t_2d(t, t2, drop);
+            if (Predicates::orient2d(t2, t2 + 2, t2 + 4) != 0) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    TRIANGLE_INTERSECTION_INLINE void get_longest_side(const double* const t[3], const double* s[2]) {
+        double l[3] = { get_length(t[0], t[1]), get_length(t[1], t[2]), get_length(t[2], t[0]) };
+        int i = l[0] >= l[1] && l[0] >= l[2] ? 0 : l[1] >= l[2] ? 1 : 2;
+        s[0] = t[i];
+        s[1] = t[(i + 1) % 3];
+    }
+
+    template <class Predicates>
+    void make_couterclockwise_2d(double t[6]) {
+        if (Predicates::orient2d(t, t + 2, t + 4) < 0) {
+            std::swap(t[2], t[4]);
+            std::swap(t[3], t[5]);
+        }
+    }
+
+    TRIANGLE_INTERSECTION_INLINE int get_dominant_axis(const double* const t[3]) {
+        double n[3] = {
+            (t[1][1] - t[0][1]) * (t[2][2] - t[0][2]) - (t[1][2] - t[0][2]) * (t[2][1] - t[0][1]),
+            (t[1][2] - t[0][2]) * (t[2][0] - t[0][0]) - (t[1][0] - t[0][0]) * (t[2][2] - t[0][2]),
+            (t[1][0] - t[0][0]) * (t[2][1] - t[0][1]) - (t[1][1] - t[0][1]) * (t[2][0] - t[0][0])
+        };
+
+        if (std::abs(n[0]) > std::abs(n[1])) {
+            return std::abs(n[0]) > std::abs(n[2]) ? 0 : 2;
+        } 
+
+        return std::abs(n[1]) > std::abs(n[2]) ? 1 : 2;
+    };
+
+    TRIANGLE_INTERSECTION_INLINE void project_t_2d(const double* const t1[3], double t2[6], int drop) {
+        int j = 0;
+        for (int i = 0; i < 9; i++) {
+            if (i % 3 == drop) {
+                continue;
+            }
+            t2[j] = t1[i / 3][i % 3];
+            j++;
+        }
+    }
+    
+    TRIANGLE_INTERSECTION_INLINE void project_p_2d(const double p1[3], double p2[2], int drop) {
+        if (drop == 0) {
+            p2[0] = p1[1];
+            p2[1] = p1[2];
+        } else  {
+            p2[0] = p1[0];
+            p2[1] = drop == 1 ? p1[2] : p1[1];
+        }
+    }
+    
+}
@@ -0,0 +1,310 @@
+#pragma once
+
+#include "kernel.hpp"
+
+namespace triangle_intersection {
+    namespace expansion {
+
+        /*
+        Expansion arithmetic: a value is held exactly as a sum of doubles sorted by increasing magnitude,
+        no two of them overlapping. Every function drops zero components but keeps at least one,
+        the last component carries the sign of the sum
+        */
+
+        TRIANGLE_INTERSECTION_INLINE void two_sum(double a, double b, double& x, double& y) {
+            x = a + b;
+            double bv = x - a;
+            double av = x - bv;
+            y = (a - av) + (b - bv);
+        }
+
+        TRIANGLE_INTERSECTION_INLINE void fast_two_sum(double a, double b, double& x, double& y) {
+            // |a| >= |b|
+            x = a + b;
+            y = b - (x - a);
+        }
+
+        TRIANGLE_INTERSECTION_INLINE void two_product(double a, double b, double& x, double& y) {
+            x = a * b;
+            y = std::fma(a, b, -x);
+        }
+
+        TRIANGLE_INTERSECTION_INLINE int grow_expansion(const double* e, int n, double b, double* h) {
+            int k = 0;
+            double q = b;
+            for (int i = 0; i < n; i++) {
+                double sum, error;
+                two_sum(q, e[i], sum, error);
+                q = sum;
+                if (error != 0) {
+                    h[k++] = error;
+                }
+            }
+            if (q != 0 || k == 0) {
+                h[k++] = q;
+            }
+            return k;
+        }
+
+        // h = e + f, h must hold n + m components and must not be e or f
+        TRIANGLE_INTERSECTION_INLINE int add_expansions(const double* e, int n, const double* f, int m, double* h) {
+            double buffer[2][EXPANSION_SIZE];
+            const double* current = e;
+            int length = n;
+            for (int i = 0; i < m; i++) {
+                double* next = i == m - 1 ? h : buffer[i % 2];
+                length = grow_expansion(current, length, f[i], next);
+                current = next;
+            }
+            if (m == 0) {
+                for (int i = 0; i < n; i++) {
+                    h[i] = e[i];
+                }
+            }
+            return length;
+        }
+
+        TRIANGLE_INTERSECTION_INLINE int scale_expansion(const double* e, int n, double b, double* h) {
+            int k = 0;
+            double q, error;
+            two_product(e[0], b, q, error);
+            if (error != 0) {
+                h[k++] = error;
+            }
+            for (int i = 1; i < n; i++) {
+                double high, low, sum;
+                two_product(e[i], b, high, low);
+                two_sum(q, low, sum, error);
+                if (error != 0) {
+                    h[k++] = error;
+                }
+                fast_two_sum(high, sum, q, error);
+                if (error != 0) {
+                    h[k++] = error;
+                }
+            }
+            if (q != 0 || k == 0) {
+                h[k++] = q;
+            }
+            return k;
+        }
+
+        // h = e * f, h must hold 2 * n * m components
+        TRIANGLE_INTERSECTION_INLINE int multiply_expansions(const double* e, int n, const double* f, int m, double* h) {
+            double term[EXPANSION_SIZE], sum[2][EXPANSION_SIZE];
+            int length = 1;
+            sum[0][0] = 0;
+            for (int i = 0; i < m; i++) {
+                int term_length = scale_expansion(e, n, f[i], term);
+                double* next = i == m - 1 ? h : sum[(i + 1) % 2];
+                length = add_expansions(sum[i % 2], length, term, term_length, next);
+            }
+            return length;
+        }
+
+        // exact a - b as an expansion of one or two components
+        TRIANGLE_INTERSECTION_INLINE int subtract(double a, double b, double h[2]) {
+            double x = a - b;
+            double bv = a - x;
+            double av = x + bv;
+            double y = (a - av) + (bv - b);
+            if (y == 0) {
+                h[0] = x;
+                return 1;
+            }
+            h[0] = y;
+            h[1] = x;
+            return 2;
+        }
+
+        struct Difference {
+            double v[2];
+            int n;
+        };
+
+        TRIANGLE_INTERSECTION_INLINE int get_triple_product(const Difference& a, const Difference& b, const Difference& c, double sign, double* h) {
+            double ab[8], scaled[2];
+            int length = multiply_expansions(a.v, a.n, b.v, b.n, ab);
+            for (int i = 0; i < c.n; i++) {
+                scaled[i] = c.v[i] * sign;
+            }
+            return multiply_expansions(ab, length, scaled, c.n, h);
+        }
+
+        /*
+        The plain evaluation is exact when no difference, product or sum in it rounds,
+        the common case for coordinates on a coarse grid. det receives it, false when something rounds
+        */
+
+        TRIANGLE_INTERSECTION_INLINE bool is_exact_sum(const double* terms, int n, double& sum) {
+            sum = terms[0];
+            for (int i = 1; i < n; i++) {
+                double error;
+                two_sum(sum, terms[i], sum, error);
+                if (error != 0) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        TRIANGLE_INTERSECTION_INLINE bool is_exact_product(double a, double b, double& product) {
+            double error;
+            two_product(a, b, product, error);
+            return error == 0;
+        }
+
+        TRIANGLE_INTERSECTION_INLINE bool is_exact_determinant_3d(const double p1[3], const double p2[3], const double p3[3], const double p4[3], double& det) {
+            const double* rows[3] = { p1, p2, p3 };
+            double m[3][3];
+            for (int i = 0; i < 3; i++) {
+                for (int j = 0; j < 3; j++) {
+                    double h[2];
+                    if (subtract(rows[i][j], p4[j], h) != 1) {
+                        return false;
+                    }
+                    m[i][j] = h[0];
+                }
+            }
+
+            const int columns[6][3] = { { 0, 1, 2 }, { 1, 2, 0 }, { 2, 0, 1 }, { 2, 1, 0 }, { 1, 0, 2 }, { 0, 2, 1 } };
+            double terms[6];
+            for (int i = 0; i < 6; i++) {
+                double product;
+                if (!is_exact_product(m[0][columns[i][0]], m[1][columns[i][1]], product)
+                    || !is_exact_product(product, m[2][columns[i][2]], terms[i])) {
+                    return false;
+                }
+                if (i >= 3) {
+                    terms[i] = -terms[i];
+                }
+            }
+
+            return is_exact_sum(terms, 6, det);
+        }
+
+        TRIANGLE_INTERSECTION_INLINE bool is_exact_determinant_2d(const double p1[2], const double p2[2], const double p3[2], double& det) {
+            const double* rows[2] = { p1, p2 };
+            double m[2][2];
+            for (int i = 0; i < 2; i++) {
+                for (int j = 0; j < 2; j++) {
+                    double h[2];
+                    if (subtract(rows[i][j], p3[j], h) != 1) {
+                        return false;
+                    }
+                    m[i][j] = h[0];
+                }
+            }
+
+            double terms[2];
+            if (!is_exact_product(m[0][0], m[1][1], terms[0]) || !is_exact_product(m[0][1], m[1][0], terms[1])) {
+                return false;
+            }
+            terms[1] = -terms[1];
+
+            return is_exact_sum(terms, 2, det);
+        }
+
+        TRIANGLE_INTERSECTION_INLINE double get_exact_determinant_3d(const double p1[3], const double p2[3], const double p3[3], const double p4[3]) {
+            Difference m[3][3];
+            const double* rows[3] = { p1, p2, p3 };
+            for (int i = 0; i < 3; i++) {
+                for (int j = 0; j < 3; j++) {
+                    m[i][j].n = subtract(rows[i][j], p4[j], m[i][j].v);
+                }
+            }
+
+            // same six terms as get_determinant_3d
+            const int terms[6][3] = { { 0, 1, 2 }, { 1, 2, 0 }, { 2, 0, 1 }, { 2, 1, 0 }, { 1, 0, 2 }, { 0, 2, 1 } };
+
+            double sum[2][EXPANSION_SIZE], term[32];
+            int length = 1;
+            sum[0][0] = 0;
+            for (int i = 0; i < 6; i++) {
+                int term_length = get_triple_product(m[0][terms[i][0]], m[1][terms[i][1]], m[2][terms[i][2]], i < 3 ? 1.0 : -1.0, term);
+                length = add_expansions(sum[i % 2], length, term, term_length, sum[(i + 1) % 2]);
+            }
+
+            return sum[0][length - 1];
+        }
+
+        TRIANGLE_INTERSECTION_INLINE double get_exact_determinant_2d(const double p1[2], const double p2[2], const double p3[2]) {
+            Difference m[2][2];
+            const double* rows[2] = { p1, p2 };
+            for (int i = 0; i < 2; i++) {
+                for (int j = 0; j < 2; j++) {
+                    m[i][j].n = subtract(rows[i][j], p3[j], m[i][j].v);
+                }
+            }
+
+            double left[8], right[8], negated[2], h[16];
+            int left_length = multiply_expansions(m[0][0].v, m[0][0].n, m[1][1].v, m[1][1].n, left);
+            for (int i = 0; i < m[1][0].n; i++) {
+                negated[i] = -m[1][0].v[i];
+            }
+            int right_length = multiply_expansions(m[0][1].v, m[0][1].n, negated, m[1][0].n, right);
+            int length = add_expansions(left, left_length, right, right_length, h);
+
+            return h[length - 1];
+        }
+    }
+
+    TRIANGLE_INTERSECTION_INLINE double FastPredicates::orient2d(const double a[2], const double b[2], const double c[2]) noexcept {
+        return get_determinant_2d(a, b, c);
+    }
+
+    TRIANGLE_INTERSECTION_INLINE double FastPredicates::orient3d(const double a[3], const double b[3], const double c[3], const double d[3]) noexcept {
+        return get_determinant_3d(a, b, c, d);
+    }
+
+    TRIANGLE_INTERSECTION_INLINE double RobustPredicates::orient2d(const double a[2], const double b[2], const double c[2]) noexcept {
+
+        // same operations as get_determinant_2d, the magnitude of the two products bounds the rounding error
+
+        double m[2][2] = {
+            { a[0] - c[0], a[1] - c[1] },
+            { b[0] - c[0], b[1] - c[1] }
+        };
+
+        double left = m[0][0] * m[1][1];
+        double right = m[0][1] * m[1][0];
+        double det = left - right;
+
+        if (std::abs(det) > ORIENT2D_ERROR_BOUND * (std::abs(left) + std::abs(right))
+            || expansion::is_exact_determinant_2d(a, b, c, det)) {
+            return det;
+        }
+
+        return expansion::get_exact_determinant_2d(a, b, c);
+    }
+
+    TRIANGLE_INTERSECTION_INLINE double RobustPredicates::orient3d(const double a[3], const double b[3], const double c[3], const double d[3]) noexcept {
+
+        // same operations as get_determinant_3d, the magnitude of the six products bounds the rounding error
+
+        double m[3][3] = {
+            { a[0] - d[0], a[1] - d[1], a[2] - d[2] },
+            { b[0] - d[0], b[1] - d[1], b[2] - d[2] },
+            { c[0] - d[0], c[1] - d[1], c[2] - d[2] }
+        };
+
+        double terms[6] = {
+            m[0][0] * m[1][1] * m[2][2],
+            m[0][1] * m[1][2] * m[2][0],
+            m[0][2] * m[1][0] * m[2][1],
+            m[0][2] * m[1][1] * m[2][0],
+            m[0][1] * m[1][0] * m[2][2],
+            m[0][0] * m[1][2] * m[2][1]
+        };
+
+        double det = terms[0] + terms[1] + terms[2] - terms[3] - terms[4] - terms[5];
+        double magnitude = std::abs(terms[0]) + std::abs(terms[1]) + std::abs(terms[2])
+                         + std::abs(terms[3]) + std::abs(terms[4]) + std::abs(terms[5]);
+
+        if (std::abs(det) > ORIENT3D_ERROR_BOUND * magnitude || expansion::is_exact_determinant_3d(a, b, c, d, det)) {
+            return det;
+        }
+
+        return expansion::get_exact_determinant_3d(a, b, c, d);
+    }
+}
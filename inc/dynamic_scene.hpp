@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <unordered_set>
+#include <vector>
+#include "bvh.hpp"
+#include "mesh.hpp"
+
+namespace triangle_intersection {
+    /*
+    Meshes that move a little between steps, checked against each other after every step.
+    Sweep and prune: the box endpoints stay sorted along each axis. update() moves only the endpoints
+    of the triangles that moved, by insertion, and every swap of a min and a max endpoint adds or removes
+    a box overlap. The narrow phase only runs on overlapping pairs with a moved triangle, so the cost
+    of a step follows the motion rather than the size of the scene. When a large part of the scene
+    moved (or was just added) the lists are sorted and swept again from scratch instead.
+    Triangles get consecutive ids in the order they are added, pairs are (i, j) with i < j.
+    Triangles of the same mesh are never tested against each other
+    */
+    class DynamicScene {
+    public:
+        struct Changes {
+            std::vector<TrianglePair> added;   // pairs that started to intersect, sorted
+            std::vector<TrianglePair> removed; // pairs that stopped intersecting, sorted
+        };
+
+        explicit DynamicScene(const ParallelOptions& options = ParallelOptions());
+
+        // Copies count * 9 doubles, returns the mesh id. The mesh is part of the next update
+        std::uint32_t add_mesh(const double* triangles, std::size_t count);
+        // New coordinates for the count * 9 doubles of a mesh, or of one triangle, for the next update
+        void move_mesh(std::uint32_t mesh, const double* triangles);
+        void move_triangle(std::uint32_t id, const double t[9]);
+
+        // Brings the overlaps and intersections up to date, returns what changed since the last update
+        Changes update();
+
+        std::size_t size() const noexcept { return meshes_of_.size(); }
+        std::uint32_t get_first_triangle(std::uint32_t mesh) const noexcept { return first_triangles_[mesh]; }
+        const double* triangles() const noexcept { return triangles_.data(); }
+        // as of the last update, sorted
+        std::vector<TrianglePair> get_intersections() const;
+        std::size_t get_overlap_count() const noexcept { return overlaps_.size(); }
+
+    private:
+        struct Endpoint {
+            double value;
+            std::uint32_t id; // 2 * triangle, + 1 for the max endpoint
+        };
+
+        bool sort_endpoint(int axis, std::uint32_t id, std::vector<std::uint64_t>& separated);
+        void on_swap(std::uint32_t moving, std::uint32_t other, bool moving_left, std::vector<std::uint64_t>& separated);
+        void rebuild(std::vector<std::uint64_t>& separated);
+        void add_overlap(std::uint32_t i, std::uint32_t j);
+        bool remove_overlap(std::uint32_t i, std::uint32_t j);
+
+        ParallelOptions options_;
+        std::vector<double> triangles_;
+        std::vector<Aabb> boxes_;
+        std::vector<std::uint32_t> meshes_of_;
+        std::vector<std::uint32_t> first_triangles_;
+        std::vector<Endpoint> endpoints_[3];
+        std::vector<std::uint32_t> positions_[3];   // index in endpoints_ of every endpoint id
+        std::vector<std::uint32_t> moved_;
+        std::vector<bool> is_moved_;
+        std::vector<std::vector<std::uint32_t>> partners_; // overlapping triangles
+        std::unordered_set<std::uint64_t> overlaps_;
+        std::unordered_set<std::uint64_t> intersections_;
+    };
+}
@@ -1,3 +1,203 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "predicates.hpp"
+
 namespace triangle_intersection {
+    // t1 and t2 are left unchanged
     bool have_intersection(double t1[9], double t2[9]) noexcept;
-}
\ No newline at end of file
+
+    // Triangles given by three vertex pointers, the vertices are never written to
+    bool have_intersection(const double* const t1[3], const double* const t2[3]) noexcept;
+
+    /*
+    Kernel with an explicit predicate policy, RobustPredicates or FastPredicates.
+    The other overloads use RobustPredicates: the orientation signs the decisions are based on are exact.
+    FastPredicates skips the error filter and may misjudge pairs within rounding error of touching
+    */
+    template <class Predicates>
+    bool have_intersection(const double* const t1[3], const double* const t2[3]) noexcept;
+
+    /*
+    Where two triangles meet: a point, a segment or, for coplanar triangles, a convex polygon
+    with its vertices in order around it. Touching triangles give the point or segment they share.
+    Coplanar triangles found touching within rounding error that share no exact point come with count 0
+    */
+    struct Intersection {
+        enum class Kind {
+            None,
+            Point,
+            Segment,
+            Polygon
+        };
+
+        Kind kind;
+        std::size_t count;   // points used: 0, 1, 2 or 3 to 6
+        double points[6][3];
+    };
+
+    /*
+    Output policies of the kernel. BoolOutput only gives the answer, the kernel is the plain one.
+    SegmentOutput also fills result, from the determinants the test already computed:
+    the crossing points of the edges with the other plane, clipped to the overlap of the two intervals,
+    or the clipped polygon for coplanar triangles. The points are rounded, the answer is not
+    */
+    struct BoolOutput {};
+
+    struct SegmentOutput {
+        Intersection result;
+    };
+
+    template <class Predicates, class Output>
+    bool have_intersection(const double* const t1[3], const double* const t2[3], Output& output) noexcept;
+
+    // SegmentOutput with RobustPredicates, result.kind is None when the triangles do not meet
+    bool have_intersection(const double t1[9], const double t2[9], Intersection& result) noexcept;
+
+    /*
+    Degeneracy policy for meshes already cleaned of points and segments. Every other overload first checks
+    both triangles for coinciding vertices and for collinear ones (three square roots per triangle);
+    the overloads taking AssumeNonDegenerate leave those checks out at compile time and go straight to
+    the plane tests. Passing a point or segment anyway gives an unspecified answer, a point lying
+    on the other triangle may be reported as missing it
+    */
+    struct AssumeNonDegenerate {};
+
+    template <class Predicates, class Output>
+    bool have_intersection(const double* const t1[3], const double* const t2[3], Output& output, AssumeNonDegenerate) noexcept;
+
+    // RobustPredicates and BoolOutput
+    bool have_intersection(const double t1[9], const double t2[9], AssumeNonDegenerate) noexcept;
+
+    // Vertex buffer shared by many triangles: vertex i starts at data + i * stride
+    struct VertexView {
+        const double* data;
+        std::size_t stride;
+    };
+
+    // Triangles given by vertex indices into vertex buffers, the buffers are never written to
+    bool have_intersection(const VertexView& vertices1, const std::uint32_t triangle1[3],
+                           const VertexView& vertices2, const std::uint32_t triangle2[3]) noexcept;
+
+    enum class TriangleKind {
+        Point,
+        Segment,
+        Triangle
+    };
+
+    /*
+    Per-triangle data the kernel would otherwise recompute for every pair.
+    Prepare a triangle once when it is tested against many others.
+    For segments the endpoints are stored first in vertices.
+    Plane evaluations replace the orientation determinants of the first sign tests. With RobustPredicates
+    their sign is checked against an error bound, so the results equal the unprepared kernel.
+    With FastPredicates they may differ from it where it is within rounding error of touching
+    */
+    struct PreparedTriangle {
+        explicit PreparedTriangle(const double t[9]) noexcept;
+        explicit PreparedTriangle(const double* const t[3]) noexcept;
+
+        double vertices[9];
+        double edges[2][3]; // q - p, r - p
+        double normal[3];   // edges[0] x edges[1]
+        double offset;      // normal . p
+        double normal_magnitude[3]; // bounds on the terms of the normal components, for the error bound of plane evaluations
+        double offset_magnitude;    // normal_magnitude . |p|
+        TriangleKind kind;
+        int dominant_axis;  // largest component of normal
+    };
+
+    bool have_intersection(const PreparedTriangle& t1, const PreparedTriangle& t2) noexcept;
+    bool have_intersection(const PreparedTriangle& t1, const double t2[9]) noexcept;
+
+    template <class Predicates>
+    bool have_intersection(const PreparedTriangle& t1, const PreparedTriangle& t2) noexcept;
+
+    /*
+    Structure-of-arrays view of a batch of triangles:
+    coords[k][i] is the k-th value of the i-th triangle in the double[9] layout used by have_intersection
+    */
+    struct TriangleBatch {
+        const double* coords[9];
+    };
+
+    // Same view over float coordinates
+    struct FloatTriangleBatch {
+        const float* coords[9];
+    };
+
+    enum class SimdIsa {
+        Scalar,
+        Avx2,
+        Avx512
+    };
+
+    // Widest instruction set the batch kernel can use on this machine
+    SimdIsa get_simd_isa() noexcept;
+
+    /*
+    Tests the pairs (t1[i], t2[i]) for i < n and sets bit i % 64 of mask[i / 64] for every intersecting pair.
+    mask must hold (n + 63) / 64 words, all of them are overwritten
+    */
+    void have_intersection_batch(const TriangleBatch& t1, const TriangleBatch& t2, std::size_t n, std::uint64_t* mask) noexcept;
+    void have_intersection_batch(const TriangleBatch& t1, const TriangleBatch& t2, std::size_t n, std::uint64_t* mask, SimdIsa isa) noexcept;
+
+    /*
+    Float triangles, the answer is always the one of have_intersection on the widened coordinates.
+    The vector lanes of the batch run the sign tests in float, twice as many lanes per vector as in double,
+    with error bounds that also cover underflow. Pairs they cannot decide, degenerate and coplanar ones
+    among them, are widened and tested by the double kernel, as are single pairs and the pairs of the scalar tail
+    */
+    bool have_intersection(const float t1[9], const float t2[9]) noexcept;
+    void have_intersection_batch(const FloatTriangleBatch& t1, const FloatTriangleBatch& t2, std::size_t n, std::uint64_t* mask) noexcept;
+    void have_intersection_batch(const FloatTriangleBatch& t1, const FloatTriangleBatch& t2, std::size_t n, std::uint64_t* mask, SimdIsa isa) noexcept;
+
+    /*
+    Degenerate and regular pairs. get_degenerate_pairs sets bit i % 64 of degenerate[i / 64] for every pair
+    where t1[i] or t2[i] is a point or a segment and returns how many there are. The vector lanes use a tolerance
+    rather than the exact tests, so a few nearly degenerate pairs may be marked too; for every unmarked pair
+    AssumeNonDegenerate gives the answer of have_intersection.
+    A batch with no marked pairs (or a mesh cleaned beforehand) can then run without any degeneracy test.
+    The batches above already skip those tests in the scalar kernel for the lanes the vector test found regular
+    */
+    std::size_t get_degenerate_pairs(const TriangleBatch& t1, const TriangleBatch& t2, std::size_t n, std::uint64_t* degenerate, SimdIsa isa) noexcept;
+    std::size_t get_degenerate_pairs(const FloatTriangleBatch& t1, const FloatTriangleBatch& t2, std::size_t n, std::uint64_t* degenerate, SimdIsa isa) noexcept;
+    void have_intersection_batch(const TriangleBatch& t1, const TriangleBatch& t2, std::size_t n, std::uint64_t* mask, SimdIsa isa,
+                                 AssumeNonDegenerate) noexcept;
+    void have_intersection_batch(const FloatTriangleBatch& t1, const FloatTriangleBatch& t2, std::size_t n, std::uint64_t* mask, SimdIsa isa,
+                                 AssumeNonDegenerate) noexcept;
+
+    /*
+    Distance between two triangles, 0 when they meet. The closest points are searched among the vertices
+    against the other triangle, the edges against the edges of the other triangle and the points where
+    an edge crosses the other triangle. Points and segments are accepted. The distance is rounded, unlike the answers
+    of have_intersection: triangles within rounding error of touching may be a tiny distance apart.
+    p1 and p2 receive a closest point on t1 and on t2
+    */
+    double get_distance(const double t1[9], const double t2[9]) noexcept;
+    double get_distance(const double t1[9], const double t2[9], double p1[3], double p2[3]) noexcept;
+
+    /*
+    Integer triangles, for meshes on a grid. Every orientation is an exact int64 determinant:
+    no tolerances, no square roots and no exact fallback, degenerate triangles included,
+    and touching counts as intersecting. The coordinates must lie within
+    [-MAX_INTEGER_COORDINATE, MAX_INTEGER_COORDINATE], the products of the 3x3 determinants
+    then stay below 2^62
+    */
+    constexpr std::int32_t MAX_INTEGER_COORDINATE = 1 << 19;
+
+    bool have_intersection(const std::int32_t t1[9], const std::int32_t t2[9]) noexcept;
+}
+
+/*
+Header-only mode: with TRIANGLE_INTERSECTION_HEADER_ONLY defined, the scalar double kernel and the predicates
+are defined inline here, so that calls can be inlined into the caller without link-time optimization.
+Everything else (prepared triangles, batches, float and integer triangles, meshes) still needs the library
+*/
+#ifdef TRIANGLE_INTERSECTION_HEADER_ONLY
+#include "detail/predicates_inl.hpp"
+#include "detail/misc_inl.hpp"
+#include "detail/geometry_inl.hpp"
+#include "detail/intersection_inl.hpp"
+#endif
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include "intersection.hpp"
+
+namespace triangle_intersection {
+    /*
+    Interchangeable narrow-phase kernels behind one signature. Every kernel gives the answer of have_intersection:
+    the alternatives to Devillers-Guigue only decide the pairs their floating-point test clears by more than
+    its error bound, degenerate, coplanar and touching pairs among the others go to Devillers-Guigue.
+    Which one is fastest depends on the data, mostly on how many pairs a plane test rejects
+    */
+    enum class Kernel {
+        DevillersGuigue, // have_intersection
+        Moller,          // plane distances, then the overlap of the two intervals on the line where the planes meet
+        SeparatingAxis   // plane distances, then the nine edge cross products as separating axes (Shen, Heng and Tang)
+    };
+
+    constexpr std::size_t KERNEL_COUNT = 3;
+
+    using KernelFunction = bool (*)(const double t1[9], const double t2[9]);
+
+    KernelFunction get_kernel(Kernel kernel) noexcept;
+    const char* get_kernel_name(Kernel kernel) noexcept;
+    bool have_intersection(const double t1[9], const double t2[9], Kernel kernel) noexcept;
+
+    struct AutotuneOptions {
+        std::size_t sample_size = 2048; // pairs timed per kernel, spread evenly over the batch
+        int rounds = 3;                 // the fastest round of each kernel counts
+    };
+
+    /*
+    Times every kernel on a sample of the pairs (t1 + 9i, t2 + 9i), i < n, and returns the fastest.
+    Returns DevillersGuigue without timing anything when n is below sample_size
+    */
+    Kernel autotune(const double* t1, const double* t2, std::size_t n, const AutotuneOptions& options = AutotuneOptions());
+
+    /*
+    Tests the pairs (t1 + 9i, t2 + 9i), i < n, with the kernel autotune picks on them and sets bit i % 64
+    of mask[i / 64] for every intersecting pair. mask must hold (n + 63) / 64 words.
+    Tuning is skipped for batches shorter than 8 samples, it would cost more than it saves. Returns the kernel used
+    */
+    Kernel have_intersection_autotuned(const double* t1, const double* t2, std::size_t n, std::uint64_t* mask,
+                                       const AutotuneOptions& options = AutotuneOptions());
+}
@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "bvh.hpp"
+#include "sink.hpp"
+
+namespace triangle_intersection {
+    struct ParallelOptions {
+        unsigned max_threads = 0; // 0: one thread per hardware thread
+    };
+
+    /*
+    Returns all intersecting pairs between two triangle soups (count * 9 doubles each), sorted.
+    Only triangles whose boxes overlap reach the narrow phase.
+    The overloads without options run on the calling thread,
+    the result does not depend on the number of threads
+    */
+    std::vector<TrianglePair> intersect_meshes(const Bvh& mesh1, const Bvh& mesh2);
+    std::vector<TrianglePair> intersect_meshes(const Bvh& mesh1, const Bvh& mesh2, const ParallelOptions& options);
+    std::vector<TrianglePair> intersect_meshes(const double* mesh1, std::size_t count1, const double* mesh2, std::size_t count2);
+
+    /*
+    intersect_meshes handing the pairs to sink as they are confirmed, unsorted, with the traversal stacks
+    and candidate buffers of arena. On one thread the query runs without the scheduler and allocates nothing
+    once arena and sink have grown to its size
+    */
+    void intersect_meshes(const Bvh& mesh1, const Bvh& mesh2, PairSink& sink, QueryArena& arena);
+    void intersect_meshes(const Bvh& mesh1, const Bvh& mesh2, PairSink& sink, QueryArena& arena, const ParallelOptions& options);
+
+    /*
+    Mesh-level queries over the same traversal, without storing pairs.
+    have_intersection stops every thread as soon as one intersecting pair is confirmed,
+    count_intersections returns the size intersect_meshes would return
+    */
+    bool have_intersection(const Bvh& mesh1, const Bvh& mesh2);
+    bool have_intersection(const Bvh& mesh1, const Bvh& mesh2, const ParallelOptions& options);
+    std::size_t count_intersections(const Bvh& mesh1, const Bvh& mesh2);
+    std::size_t count_intersections(const Bvh& mesh1, const Bvh& mesh2, const ParallelOptions& options);
+
+    /*
+    Clearance queries, with get_distance between triangles. Node pairs whose boxes lie farther apart than
+    the tolerance, or than the closest pair found so far, are skipped, and the nearer children are visited first.
+    have_proximity returns as soon as one pair lies within tolerance of each other,
+    get_closest_pair searches for the closest pair no farther apart than max_distance
+    */
+    struct ClosestPair {
+        TrianglePair pair;
+        double distance; // infinity when no pair qualifies
+    };
+
+    bool have_proximity(const Bvh& mesh1, const Bvh& mesh2, double tolerance);
+    ClosestPair get_closest_pair(const Bvh& mesh1, const Bvh& mesh2);
+    ClosestPair get_closest_pair(const Bvh& mesh1, const Bvh& mesh2, double max_distance);
+
+    // Returns the sorted subset of candidates (indices into triangles1 and triangles2) that intersect
+    std::vector<TrianglePair> intersect_pairs(const double* triangles1, const double* triangles2,
+                                              const std::vector<TrianglePair>& candidates, const ParallelOptions& options);
+    // The same for count candidates, the intersecting ones go to sink
+    void intersect_pairs(const double* triangles1, const double* triangles2, const TrianglePair* candidates, std::size_t count,
+                         PairSink& sink, QueryArena& arena, const ParallelOptions& options);
+
+    struct IndexedMesh {
+        const double* vertices;       // vertex i starts at vertices + i * vertex_stride
+        std::size_t vertex_count;
+        const std::uint32_t* indices; // triangle_count * 3 vertex indices
+        std::size_t triangle_count;
+        std::size_t vertex_stride = 3;
+    };
+
+    /*
+    Returns the sorted pairs (i, j), i < j, of intersecting triangles of a mesh.
+    Triangles sharing an edge are reported only when they fold onto each other,
+    triangles sharing a vertex only when they intersect anywhere else than at that vertex
+    */
+    std::vector<TrianglePair> find_self_intersections(const IndexedMesh& mesh);
+    // The same pairs handed to sink as worker 0, unsorted. The soup and hierarchy of mesh are still allocated
+    void find_self_intersections(const IndexedMesh& mesh, PairSink& sink);
+}
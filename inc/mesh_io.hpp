@@ -0,0 +1,82 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "intersection.hpp"
+
+namespace triangle_intersection {
+    enum class MeshFormat {
+        Stl, // binary STL: a triangle soup of float vertices
+        Ply  // binary PLY (either byte order): float or double vertices, triangle faces
+    };
+
+    /*
+    A binary STL or PLY file mapped into memory. Opening only reads the header (and, for PLY,
+    checks that every face is a triangle), the triangles are decoded from the mapping when they are read,
+    nothing is parsed or copied up front. Open files are read-only and may be read from several threads.
+    Throws std::runtime_error when the file cannot be mapped or is not a supported binary mesh
+    */
+    class MappedMesh {
+    public:
+        explicit MappedMesh(const std::string& path);
+        MappedMesh(MappedMesh&& other) noexcept;
+        MappedMesh& operator=(MappedMesh&& other) noexcept;
+        MappedMesh(const MappedMesh&) = delete;
+        MappedMesh& operator=(const MappedMesh&) = delete;
+        ~MappedMesh();
+
+        MeshFormat format() const noexcept { return format_; }
+        std::size_t triangle_count() const noexcept { return triangle_count_; }
+        // STL files store three vertices per triangle
+        std::size_t vertex_count() const noexcept { return vertex_count_; }
+
+        // triangle i in the double[9] layout of have_intersection
+        void get_triangle(std::size_t i, double t[9]) const noexcept;
+        // triangles first to first + count - 1, count * 9 doubles
+        void get_triangles(std::size_t first, std::size_t count, double* out) const noexcept;
+        void get_vertex(std::size_t i, double v[3]) const noexcept;
+        // vertex indices of triangle i, 3i to 3i + 2 for STL
+        void get_indices(std::size_t i, std::uint32_t indices[3]) const noexcept;
+
+        /*
+        View of the vertices straight into the mapping, only possible for little-endian PLY files
+        whose x, y, z are consecutive doubles with 8-byte aligned records. False otherwise
+        */
+        bool get_vertex_view(VertexView& view) const noexcept;
+
+    private:
+        struct Layout {
+            std::size_t offset;        // first record
+            std::size_t stride;        // bytes per record
+            std::size_t fields[3];     // offsets in a record: x, y, z or the three indices
+            int size;                  // bytes per field
+        };
+
+        void unmap() noexcept;
+        void parse_stl();
+        void parse_ply();
+        double read_coordinate(const unsigned char* p) const noexcept;
+        std::uint32_t read_index(const unsigned char* p) const noexcept;
+
+        const unsigned char* data_ = nullptr;
+        std::size_t size_ = 0;
+        void* handle_ = nullptr; // mapping handle on Windows
+        MeshFormat format_ = MeshFormat::Stl;
+        bool swap_bytes_ = false;
+        std::size_t triangle_count_ = 0;
+        std::size_t vertex_count_ = 0;
+        Layout vertices_ {};
+        Layout faces_ {};
+    };
+
+    // All triangles as count * 9 doubles, the soup layout of Bvh and intersect_meshes
+    std::vector<double> load_triangles(const MappedMesh& mesh);
+
+    /*
+    Vertices (3 doubles each) and indices of an indexed mesh, for find_self_intersections.
+    STL vertices are welded: exactly equal vertices get the same index
+    */
+    void load_indexed_mesh(const MappedMesh& mesh, std::vector<double>& vertices, std::vector<std::uint32_t>& indices);
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <future>
+#include <memory>
+#include <vector>
+#include "intersection.hpp"
+#include "mesh.hpp"
+
+namespace triangle_intersection {
+    /*
+    Asynchronous batches for processes that serve requests: submit() hands a job to a pool of worker threads
+    and returns a future at once. Every job is cut into chunks of CHUNK_SIZE pairs that go through three stages:
+    gather (the broad phase of mesh queries, copying the coordinates of candidate pairs), test (have_intersection_batch)
+    and emit (collecting the hits of the chunk). The workers run the later stages first and gather only while
+    fewer than max_chunks_in_flight chunks are between gather and emit, so the stages of different chunks and jobs
+    overlap without the memory in flight growing. submit() blocks while more than max_queued work waits to be gathered.
+    Jobs are gathered in submission order. The inputs of a job must stay valid until its future is ready.
+    The answers are those of the blocking functions. Jobs return std::future rather than a coroutine type,
+    the library builds as C++11
+    */
+    class BatchPipeline {
+    public:
+        static constexpr std::size_t CHUNK_SIZE = 256;
+
+        struct Options {
+            unsigned threads = 0;                  // 0: one per hardware thread
+            std::size_t max_chunks_in_flight = 0;  // 0: 4 per thread
+            std::size_t max_queued = 1 << 22;      // pairs of batches and triangles of mesh queries not yet gathered
+        };
+
+        BatchPipeline();
+        explicit BatchPipeline(const Options& options);
+        // Waits for every submitted job
+        ~BatchPipeline();
+
+        BatchPipeline(const BatchPipeline&) = delete;
+        BatchPipeline& operator=(const BatchPipeline&) = delete;
+
+        // The mask of have_intersection_batch, (n + 63) / 64 words
+        std::future<std::vector<std::uint64_t>> submit(const TriangleBatch& t1, const TriangleBatch& t2, std::size_t n);
+        // intersect_pairs
+        std::future<std::vector<TrianglePair>> submit(const double* triangles1, const double* triangles2, std::vector<TrianglePair> candidates);
+        // intersect_meshes
+        std::future<std::vector<TrianglePair>> submit(const Bvh& mesh1, const Bvh& mesh2);
+
+        unsigned get_thread_count() const noexcept;
+
+    private:
+        struct State;
+
+        std::unique_ptr<State> state_;
+    };
+}
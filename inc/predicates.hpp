@@ -0,0 +1,28 @@
+#pragma once
+
+namespace triangle_intersection {
+    /*
+    Orientation predicates, the policies the intersection kernels are templated on.
+    orient3d(a, b, c, d) is the determinant of (a - d, b - d, c - d): positive when d lies below the plane
+    through a, b, c (the side from which a, b, c appear clockwise), orient2d(a, b, c) is the determinant
+    of (a - c, b - c): positive when a, b, c are counterclockwise.
+    Only the sign of the results is meaningful
+    */
+
+    // Plain double determinants, the sign may be wrong for nearly degenerate inputs
+    struct FastPredicates {
+        static double orient2d(const double a[2], const double b[2], const double c[2]) noexcept;
+        static double orient3d(const double a[3], const double b[3], const double c[3], const double d[3]) noexcept;
+    };
+
+    /*
+    Exact signs (as long as nothing overflows or underflows), after Shewchuk, "Adaptive Precision
+    Floating-Point Arithmetic and Fast Robust Geometric Predicates". The double determinant is
+    returned whenever its error bound proves the sign, otherwise the determinant is recomputed
+    exactly with expansion arithmetic
+    */
+    struct RobustPredicates {
+        static double orient2d(const double a[2], const double b[2], const double c[2]) noexcept;
+        static double orient3d(const double a[3], const double b[3], const double c[3], const double d[3]) noexcept;
+    };
+}
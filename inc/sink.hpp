@@ -0,0 +1,134 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <utility>
+#include <vector>
+
+namespace triangle_intersection {
+    // (index in the first mesh, index in the second mesh)
+    using TrianglePair = std::pair<std::uint32_t, std::uint32_t>;
+
+    /*
+    Receives the pairs of a multi-pair query as they are confirmed, in no particular order, instead of a sorted vector.
+    start() is called once before anything else with the number of workers of the query, put() then gets the hits
+    of one tested chunk at a time from worker 0 (the calling thread) to worker_count - 1. Different workers may call put()
+    at the same time, one worker never does. finish() is called once the query is done, also when it failed
+    */
+    class PairSink {
+    public:
+        virtual ~PairSink() {}
+
+        virtual void start(unsigned worker_count) { (void)worker_count; }
+        virtual void put(const TrianglePair* pairs, std::size_t count, unsigned worker) = 0;
+        virtual void finish() {}
+    };
+
+    // Calls f(pairs, count, worker) for every chunk, concurrently from the workers of a query on several threads
+    template <class F>
+    class CallbackSink : public PairSink {
+    public:
+        explicit CallbackSink(F f) : f_(std::move(f)) {}
+
+        void put(const TrianglePair* pairs, std::size_t count, unsigned worker) override { f_(pairs, count, worker); }
+
+    private:
+        F f_;
+    };
+
+    template <class F>
+    CallbackSink<F> make_callback_sink(F f) {
+        return CallbackSink<F>(std::move(f));
+    }
+
+    /*
+    Fixed-capacity ring between a query and a consumer on another thread. put() waits while the ring is full,
+    pop() waits while it is empty and returns 0 once the query finished and every pair was read.
+    The ring is allocated by the constructor; reset() readies it for the next query
+    */
+    class RingSink : public PairSink {
+    public:
+        explicit RingSink(std::size_t capacity);
+
+        void start(unsigned worker_count) override;
+        void put(const TrianglePair* pairs, std::size_t count, unsigned worker) override;
+        void finish() override;
+
+        // Moves up to max_count pairs to pairs
+        std::size_t pop(TrianglePair* pairs, std::size_t max_count);
+        void reset();
+
+    private:
+        std::vector<TrianglePair> ring_;
+        std::size_t head_ = 0; // next pair to pop
+        std::size_t size_ = 0;
+        bool finished_ = false;
+        std::mutex mutex_;
+        std::condition_variable not_full_;
+        std::condition_variable not_empty_;
+    };
+
+    /*
+    Per-worker lists of blocks of BLOCK_SIZE pairs. Every worker appends to its own list without locking, and the pairs
+    stay in the blocks they were written to: the result is read block by block instead of being merged into one array.
+    The pairs of successive queries add up until clear(), which keeps the blocks for the next query:
+    once the sink has grown to the size of the results it allocates nothing
+    */
+    class ArenaSink : public PairSink {
+    public:
+        static constexpr std::size_t BLOCK_SIZE = 4096;
+
+        void start(unsigned worker_count) override;
+        void put(const TrianglePair* pairs, std::size_t count, unsigned worker) override;
+
+        std::size_t size() const noexcept;
+        // f(pairs, count) for every block holding pairs
+        template <class F>
+        void for_each_block(F f) const;
+        // the pairs sorted, as the vector overloads return them
+        std::vector<TrianglePair> get_sorted() const;
+        void clear() noexcept;
+
+    private:
+        struct Worker {
+            std::vector<std::vector<TrianglePair>> blocks;
+            std::size_t used = 0; // blocks holding pairs, the others are kept for later
+        };
+
+        std::vector<Worker> workers_;
+    };
+
+    template <class F>
+    void ArenaSink::for_each_block(F f) const {
+        for (const Worker& w : workers_) {
+            for (std::size_t b = 0; b < w.used; b++) {
+                f(w.blocks[b].data(), w.blocks[b].size());
+            }
+        }
+    }
+
+    /*
+    Scratch memory of mesh queries kept from one query to the next: the traversal stack and the candidate buffers
+    of every worker. A query on one thread with an arena that already served a query as large allocates nothing,
+    given a sink that does not allocate either. Queries on several threads still allocate to start their threads.
+    An arena serves one query at a time
+    */
+    class QueryArena {
+    public:
+        QueryArena();
+        ~QueryArena();
+
+        QueryArena(const QueryArena&) = delete;
+        QueryArena& operator=(const QueryArena&) = delete;
+
+        // defined by the library
+        struct Scratch;
+        Scratch& get_scratch(unsigned worker);
+
+    private:
+        std::vector<std::unique_ptr<Scratch>> scratch_;
+    };
+}
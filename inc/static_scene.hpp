@@ -0,0 +1,95 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "bvh.hpp"
+#include "intersection.hpp"
+
+namespace triangle_intersection {
+    /*
+    A ray from origin along direction, its hits have a distance in [0, max_distance] in units of direction.
+    The segment p -> q is the ray from p along q - p with max_distance 1
+    */
+    struct Ray {
+        double origin[3];
+        double direction[3];
+        double max_distance;
+    };
+
+    struct RayHit {
+        double distance;        // max_distance of the ray when it misses
+        std::uint32_t triangle; // index in the soup, StaticScene::NO_HIT when the ray misses
+    };
+
+    /*
+    A fixed triangle soup indexed once and queried with single triangles from any number of threads.
+    The hierarchy is flattened in depth-first order into cache-line nodes (the left child follows its parent)
+    and the triangles are copied in leaf order, so a query walks memory mostly forward.
+    Queries only read the scene, take no locks and allocate nothing (get_all_hits appends to a vector
+    the caller may reuse). Each query triangle is prepared once and tested with the prepared kernel,
+    hits are triangle indices of the soup
+    */
+    class StaticScene {
+    public:
+        struct alignas(64) Node {
+            double min[3];
+            double max[3];
+            std::uint32_t offset; // right child for inner nodes, first triangle of the leaf in triangles()
+            std::uint32_t count;  // number of triangles in a leaf, 0 for inner nodes
+
+            bool is_leaf() const noexcept { return count != 0; }
+        };
+
+        static constexpr std::uint32_t NO_HIT = 0xffffffff;
+        // traversal stack, Bvh builds at most 48 SAH levels plus 32 median splits, deeper trees throw std::length_error
+        static constexpr int MAX_DEPTH = 128;
+
+        // Copies count * 9 doubles
+        StaticScene(const double* triangles, std::size_t count);
+
+        std::size_t size() const noexcept { return ids_.size(); }
+
+        bool have_any_hit(const double t[9]) const noexcept;
+        /*
+        Stops after max_hits hits, returns their number, the hits are sorted.
+        Which ones are found first follows the layout of the scene, not the triangle indices
+        */
+        std::size_t get_hits(const double t[9], std::uint32_t* hits, std::size_t max_hits) const noexcept;
+        // Appends every hit, sorted
+        void get_all_hits(const double t[9], std::vector<std::uint32_t>& hits) const;
+
+        /*
+        Nearest hit of every ray. The rays are traced in packets of 8 (AVX2) or 16 (AVX-512): every box
+        and triangle test covers the whole packet, so rays sharing an origin or a direction share most
+        of the traversal, incoherent rays are traced faster one by one (SimdIsa::Scalar).
+        The triangle test is the Moller-Trumbore test of have_intersection_t_s, edges included with
+        the same tolerance, rays parallel to a triangle miss it. Ties go to the lowest triangle index
+        */
+        void get_nearest_hits(const Ray* rays, std::size_t n, RayHit* hits) const noexcept;
+        void get_nearest_hits(const Ray* rays, std::size_t n, RayHit* hits, SimdIsa isa) const noexcept;
+
+        /*
+        Point-in-mesh test against a closed mesh: sets bit i % 64 of inside[i / 64] when point i
+        (3 doubles) is enclosed, that is when a ray from it crosses the surface an odd number of times.
+        inside must hold (n + 63) / 64 words. The rays are traced in packets like get_nearest_hits,
+        rays passing within tolerance of an edge or a vertex are cast again along other directions.
+        Points on the surface may come out either way
+        */
+        void classify_points(const double* points, std::size_t n, std::uint64_t* inside) const noexcept;
+        void classify_points(const double* points, std::size_t n, std::uint64_t* inside, SimdIsa isa) const noexcept;
+
+        const std::vector<Node>& nodes() const noexcept { return nodes_; }
+        // leaf order, triangle i of the layout is triangle get_id(i) of the soup
+        const double* triangles() const noexcept { return triangles_.data(); }
+        std::uint32_t get_id(std::size_t i) const noexcept { return ids_[i]; }
+
+    private:
+        template <class Visit>
+        void traverse(const double t[9], Visit& visit) const;
+
+        std::vector<Node> nodes_;
+        std::vector<double> triangles_;
+        std::vector<std::uint32_t> ids_;
+    };
+}
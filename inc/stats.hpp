@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace triangle_intersection {
+    // The exit branches of have_intersection
+    enum class Branch {
+        PointPoint,
+        PointSegment,
+        PointTriangle,
+        SegmentSegment,
+        SegmentTriangle,
+        Coplanar,
+        FirstPlaneReject,  // triangle 1 entirely on one side of the plane of triangle 2
+        SecondPlaneReject, // triangle 2 entirely on one side of the plane of triangle 1
+        Interval,          // full test, the answer comes from the interval overlap
+        Error              // an exception was caught
+    };
+
+    constexpr std::size_t BRANCH_COUNT = 10;
+
+    struct BranchStats {
+        std::uint64_t count[BRANCH_COUNT];
+        std::uint64_t ticks[BRANCH_COUNT]; // time spent in the calls that left through the branch, see have_branch_timers
+
+        std::uint64_t get_count(Branch b) const noexcept { return count[static_cast<std::size_t>(b)]; }
+        std::uint64_t get_ticks(Branch b) const noexcept { return ticks[static_cast<std::size_t>(b)]; }
+    };
+
+    /*
+    Per-branch counters of the scalar kernel (single pairs, prepared triangles, the pairs the batch kernel
+    hands to the scalar code and thus the mesh queries). Pairs decided by the vector lanes of
+    have_intersection_batch are not counted.
+    The counters only exist when the library is built with TRIANGLE_INTERSECTION_STATS,
+    the timers with TRIANGLE_INTERSECTION_STATS_TIMERS. Otherwise the kernel is unchanged
+    and the functions below report zeros.
+    Every thread counts into its own thread-local block, nothing is shared on the hot path.
+    Ticks are TSC cycles on x86-64, counter ticks on arm64 and nanoseconds elsewhere
+    */
+    bool have_branch_stats() noexcept;
+    bool have_branch_timers() noexcept;
+
+    // sum over all threads, including the ones that already exited
+    BranchStats get_branch_stats();
+    BranchStats get_thread_branch_stats();
+    // Restarts every count from 0. Threads may run the kernel meanwhile, their calls in flight count on either side
+    void reset_branch_stats();
+
+    const char* get_branch_name(Branch b) noexcept;
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "bvh.hpp"
+#include "mesh.hpp"
+
+namespace triangle_intersection {
+    /*
+    Content hash of an indexed mesh: the coordinates of every triangle corner and the indices, in triangle order.
+    Vertices no triangle uses do not count. Meant to recognize a mesh, not to resist tampering
+    */
+    std::uint64_t get_content_hash(const IndexedMesh& mesh) noexcept;
+
+    /*
+    Self-intersections of a mesh that is edited in small steps, with the rules of find_self_intersections.
+    The session keeps the intersecting pairs and a hierarchy over its own copy of the triangles between updates.
+    update() refits the hierarchy for the changed triangles and tests only the pairs that contain one,
+    so an edit costs in proportion to its size, not to the size of the mesh. When a large part of the mesh changed
+    the hierarchy is built again and every pair is tested instead.
+    The state saves to a small binary file keyed by the content hash of the mesh, and reloads without testing anything
+    */
+    class ValidationSession {
+    public:
+        struct Changes {
+            std::vector<TrianglePair> added;   // pairs that started to intersect, sorted
+            std::vector<TrianglePair> removed; // pairs that stopped intersecting, sorted
+        };
+
+        // Tests the whole mesh. The mesh is not referenced after the call
+        explicit ValidationSession(const IndexedMesh& mesh);
+
+        /*
+        Restores the session saved in path. Throws std::runtime_error when the file cannot be read,
+        is not a session file or was saved for a mesh with another content hash or triangle count
+        */
+        ValidationSession(const IndexedMesh& mesh, const std::string& path);
+
+        // the hierarchy points into the triangles of the session: moves keep them in place, copies would not
+        ValidationSession(ValidationSession&&) = default;
+        ValidationSession& operator=(ValidationSession&&) = default;
+        ValidationSession(const ValidationSession&) = delete;
+        ValidationSession& operator=(const ValidationSession&) = delete;
+
+        /*
+        Brings the pairs up to date with mesh, the edited version of the mesh of the last update.
+        changed_vertices lists the vertices that moved, changed_triangles the triangles whose indices changed.
+        Triangles appended to the mesh count as changed, and more vertices may be appended too;
+        triangles cannot be removed (std::invalid_argument). Returns what changed since the last update
+        */
+        Changes update(const IndexedMesh& mesh, const std::uint32_t* changed_vertices, std::size_t changed_vertex_count,
+                       const std::uint32_t* changed_triangles, std::size_t changed_triangle_count);
+
+        std::size_t size() const noexcept { return indices_.size() / 3; }
+        // as of the last update, sorted
+        std::vector<TrianglePair> get_intersections() const;
+        std::size_t get_intersection_count() const noexcept { return intersection_count_; }
+        // get_content_hash of the mesh as of the last update
+        std::uint64_t get_content_hash() const noexcept;
+
+        // Throws std::runtime_error when the file cannot be written
+        void save(const std::string& path) const;
+
+    private:
+        void index_vertices(std::size_t vertex_count);
+        void set_intersections(const std::vector<TrianglePair>& pairs, bool intersect);
+
+        std::vector<double> triangles_;
+        std::vector<std::uint32_t> indices_;
+        Bvh bvh_;
+        std::vector<std::vector<std::uint32_t>> vertex_triangles_; // triangles using each vertex
+        std::vector<std::vector<std::uint32_t>> partners_;         // intersecting triangles
+        std::size_t intersection_count_ = 0;
+    };
+}
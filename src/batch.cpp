@@ -0,0 +1,152 @@
+#include "intersection_private.hpp"
+
+namespace triangle_intersection {
+    SimdIsa get_simd_isa() noexcept {
+#if defined(TRIANGLE_INTERSECTION_SIMD_X86)
+        static const SimdIsa isa = __builtin_cpu_supports("avx512f") ? SimdIsa::Avx512
+            : __builtin_cpu_supports("avx2") ? SimdIsa::Avx2
+            : SimdIsa::Scalar;
+        return isa;
+#else
+        return SimdIsa::Scalar;
+#endif
+    }
+
+    void have_intersection_batch(const TriangleBatch& t1, const TriangleBatch& t2, std::size_t n, std::uint64_t* mask) noexcept {
+        have_intersection_batch(t1, t2, n, mask, get_simd_isa());
+    }
+
+    namespace {
+        template <class Batch>
+        void have_intersection_batch_t(const Batch& t1, const Batch& t2, std::size_t n, std::uint64_t* mask, SimdIsa isa,
+                                       bool check_degenerate) noexcept {
+            for (std::size_t i = 0; i < (n + 63) / 64; i++) {
+                mask[i] = 0;
+            }
+
+            if (isa > get_simd_isa()) {
+                isa = get_simd_isa();
+            }
+
+            std::size_t done = 0;
+#if defined(TRIANGLE_INTERSECTION_SIMD_X86)
+            if (isa == SimdIsa::Avx512) {
+                done = have_intersection_batch_avx512(t1, t2, n, mask, check_degenerate);
+            } else if (isa == SimdIsa::Avx2) {
+                done = have_intersection_batch_avx2(t1, t2, n, mask, check_degenerate);
+            }
+#endif
+
+            for (std::size_t i = done; i < n; i++) {
+                if (have_intersection_lane(t1, t2, i, check_degenerate)) {
+                    mask[i / 64] |= std::uint64_t(1) << (i % 64);
+                }
+            }
+        }
+
+        template <class Batch>
+        std::size_t get_degenerate_pairs_t(const Batch& t1, const Batch& t2, std::size_t n, std::uint64_t* degenerate, SimdIsa isa) noexcept {
+            for (std::size_t i = 0; i < (n + 63) / 64; i++) {
+                degenerate[i] = 0;
+            }
+
+            if (isa > get_simd_isa()) {
+                isa = get_simd_isa();
+            }
+
+            std::size_t done = 0;
+#if defined(TRIANGLE_INTERSECTION_SIMD_X86)
+            if (isa == SimdIsa::Avx512) {
+                done = get_degenerate_pairs_avx512(t1, t2, n, degenerate);
+            } else if (isa == SimdIsa::Avx2) {
+                done = get_degenerate_pairs_avx2(t1, t2, n, degenerate);
+            }
+#endif
+
+            // the exact tests of the scalar kernel, the vector lanes use conservative ones
+            for (std::size_t i = done; i < n; i++) {
+                double p1[9], p2[9];
+                for (int k = 0; k < 9; k++) {
+                    p1[k] = t1.coords[k][i];
+                    p2[k] = t2.coords[k][i];
+                }
+                const double* v1[3] = { p1, p1 + 3, p1 + 6 };
+                const double* v2[3] = { p2, p2 + 3, p2 + 6 };
+                if (is_point(v1) || is_point(v2) || is_segment(v1) || is_segment(v2)) {
+                    degenerate[i / 64] |= std::uint64_t(1) << (i % 64);
+                }
+            }
+
+            std::size_t count = 0;
+            for (std::size_t i = 0; i < (n + 63) / 64; i++) {
+                for (std::uint64_t bits = degenerate[i]; bits != 0; bits &= bits - 1) {
+                    count++;
+                }
+            }
+            return count;
+        }
+    }
+
+    void have_intersection_batch(const TriangleBatch& t1, const TriangleBatch& t2, std::size_t n, std::uint64_t* mask, SimdIsa isa) noexcept {
+        have_intersection_batch_t(t1, t2, n, mask, isa, true);
+    }
+
+    void have_intersection_batch(const TriangleBatch& t1, const TriangleBatch& t2, std::size_t n, std::uint64_t* mask, SimdIsa isa,
+                                 AssumeNonDegenerate) noexcept {
+        have_intersection_batch_t(t1, t2, n, mask, isa, false);
+    }
+
+    std::size_t get_degenerate_pairs(const TriangleBatch& t1, const TriangleBatch& t2, std::size_t n, std::uint64_t* degenerate, SimdIsa isa) noexcept {
+        return get_degenerate_pairs_t(t1, t2, n, degenerate, isa);
+    }
+
+    void have_intersection_batch(const FloatTriangleBatch& t1, const FloatTriangleBatch& t2, std::size_t n, std::uint64_t* mask) noexcept {
+        have_intersection_batch(t1, t2, n, mask, get_simd_isa());
+    }
+
+    void have_intersection_batch(const FloatTriangleBatch& t1, const FloatTriangleBatch& t2, std::size_t n, std::uint64_t* mask, SimdIsa isa) noexcept {
+        have_intersection_batch_t(t1, t2, n, mask, isa, true);
+    }
+
+    void have_intersection_batch(const FloatTriangleBatch& t1, const FloatTriangleBatch& t2, std::size_t n, std::uint64_t* mask, SimdIsa isa,
+                                 AssumeNonDegenerate) noexcept {
+        have_intersection_batch_t(t1, t2, n, mask, isa, false);
+    }
+
+    std::size_t get_degenerate_pairs(const FloatTriangleBatch& t1, const FloatTriangleBatch& t2, std::size_t n, std::uint64_t* degenerate, SimdIsa isa) noexcept {
+        return get_degenerate_pairs_t(t1, t2, n, degenerate, isa);
+    }
+
+    bool have_intersection(const float t1[9], const float t2[9]) noexcept {
+
+        // a single pair gains nothing from float arithmetic, the double kernel gives the answer directly
+
+        double p1[9], p2[9];
+        for (int k = 0; k < 9; k++) {
+            p1[k] = t1[k];
+            p2[k] = t2[k];
+        }
+
+        return have_intersection(p1, p2);
+    }
+
+    bool have_intersection_lane(const TriangleBatch& t1, const TriangleBatch& t2, std::size_t i, bool check_degenerate) {
+        double p1[9], p2[9];
+        for (int k = 0; k < 9; k++) {
+            p1[k] = t1.coords[k][i];
+            p2[k] = t2.coords[k][i];
+        }
+
+        return check_degenerate ? have_intersection(p1, p2) : have_intersection(p1, p2, AssumeNonDegenerate());
+    }
+
+    bool have_intersection_lane(const FloatTriangleBatch& t1, const FloatTriangleBatch& t2, std::size_t i, bool check_degenerate) {
+        double p1[9], p2[9];
+        for (int k = 0; k < 9; k++) {
+            p1[k] = t1.coords[k][i];
+            p2[k] = t2.coords[k][i];
+        }
+
+        return check_degenerate ? have_intersection(p1, p2) : have_intersection(p1, p2, AssumeNonDegenerate());
+    }
+}
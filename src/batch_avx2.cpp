@@ -0,0 +1,97 @@
+#include <immintrin.h>
+#include "batch_kernel.hpp"
+#include "ray_kernel.hpp"
+
+namespace triangle_intersection {
+    namespace {
+        struct Avx2 {
+            using scalar = double;
+            using vec = __m256d;
+            using mask = __m256d;
+            static constexpr std::size_t width = 4;
+
+            static vec load(const double* p) { return _mm256_loadu_pd(p); }
+            static void store(double* p, vec a) { _mm256_storeu_pd(p, a); }
+            static vec set1(double v) { return _mm256_set1_pd(v); }
+            static vec add(vec a, vec b) { return _mm256_add_pd(a, b); }
+            static vec sub(vec a, vec b) { return _mm256_sub_pd(a, b); }
+            static vec mul(vec a, vec b) { return _mm256_mul_pd(a, b); }
+            static vec div(vec a, vec b) { return _mm256_div_pd(a, b); }
+            static vec min(vec a, vec b) { return _mm256_min_pd(a, b); }
+            static vec max(vec a, vec b) { return _mm256_max_pd(a, b); }
+            static vec sqrt(vec a) { return _mm256_sqrt_pd(a); }
+            static vec abs(vec a) { return _mm256_andnot_pd(_mm256_set1_pd(-0.0), a); }
+
+            static mask lt(vec a, vec b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+            static mask gt(vec a, vec b) { return _mm256_cmp_pd(a, b, _CMP_GT_OQ); }
+            static mask le(vec a, vec b) { return _mm256_cmp_pd(a, b, _CMP_LE_OQ); }
+            static mask ge(vec a, vec b) { return _mm256_cmp_pd(a, b, _CMP_GE_OQ); }
+            static mask eq(vec a, vec b) { return _mm256_cmp_pd(a, b, _CMP_EQ_OQ); }
+
+            static mask and_(mask a, mask b) { return _mm256_and_pd(a, b); }
+            static mask or_(mask a, mask b) { return _mm256_or_pd(a, b); }
+            static mask andnot(mask a, mask b) { return _mm256_andnot_pd(b, a); }
+            static mask not_(mask a) { return _mm256_xor_pd(a, _mm256_castsi256_pd(_mm256_set1_epi64x(-1))); }
+            static bool none(mask a) { return _mm256_movemask_pd(a) == 0; }
+            static unsigned bits(mask a) { return static_cast<unsigned>(_mm256_movemask_pd(a)); }
+
+            static vec select(mask m, vec a, vec b) { return _mm256_blendv_pd(b, a, m); }
+        };
+
+        struct Avx2f {
+            using scalar = float;
+            using vec = __m256;
+            using mask = __m256;
+            static constexpr std::size_t width = 8;
+
+            static vec load(const float* p) { return _mm256_loadu_ps(p); }
+            static vec set1(float v) { return _mm256_set1_ps(v); }
+            static vec add(vec a, vec b) { return _mm256_add_ps(a, b); }
+            static vec sub(vec a, vec b) { return _mm256_sub_ps(a, b); }
+            static vec mul(vec a, vec b) { return _mm256_mul_ps(a, b); }
+            static vec sqrt(vec a) { return _mm256_sqrt_ps(a); }
+            static vec abs(vec a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a); }
+
+            static mask lt(vec a, vec b) { return _mm256_cmp_ps(a, b, _CMP_LT_OQ); }
+            static mask gt(vec a, vec b) { return _mm256_cmp_ps(a, b, _CMP_GT_OQ); }
+            static mask le(vec a, vec b) { return _mm256_cmp_ps(a, b, _CMP_LE_OQ); }
+            static mask ge(vec a, vec b) { return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+            static mask eq(vec a, vec b) { return _mm256_cmp_ps(a, b, _CMP_EQ_OQ); }
+
+            static mask and_(mask a, mask b) { return _mm256_and_ps(a, b); }
+            static mask or_(mask a, mask b) { return _mm256_or_ps(a, b); }
+            static mask andnot(mask a, mask b) { return _mm256_andnot_ps(b, a); }
+            static mask not_(mask a) { return _mm256_xor_ps(a, _mm256_castsi256_ps(_mm256_set1_epi32(-1))); }
+            static bool none(mask a) { return _mm256_movemask_ps(a) == 0; }
+            static unsigned bits(mask a) { return static_cast<unsigned>(_mm256_movemask_ps(a)); }
+
+            static vec select(mask m, vec a, vec b) { return _mm256_blendv_ps(b, a, m); }
+        };
+    }
+
+    std::size_t have_intersection_batch_avx2(const TriangleBatch& t1, const TriangleBatch& t2, std::size_t n, std::uint64_t* mask, bool check_degenerate) {
+        return check_degenerate ? simd::have_intersection_batch<Avx2, true>(t1, t2, n, mask)
+                                : simd::have_intersection_batch<Avx2, false>(t1, t2, n, mask);
+    }
+
+    std::size_t get_degenerate_pairs_avx2(const TriangleBatch& t1, const TriangleBatch& t2, std::size_t n, std::uint64_t* degenerate) {
+        return simd::get_degenerate_pairs<Avx2>(t1, t2, n, degenerate);
+    }
+
+    std::size_t have_intersection_batch_avx2(const FloatTriangleBatch& t1, const FloatTriangleBatch& t2, std::size_t n, std::uint64_t* mask, bool check_degenerate) {
+        return check_degenerate ? simd::have_intersection_batch<Avx2f, true>(t1, t2, n, mask)
+                                : simd::have_intersection_batch<Avx2f, false>(t1, t2, n, mask);
+    }
+
+    std::size_t get_degenerate_pairs_avx2(const FloatTriangleBatch& t1, const FloatTriangleBatch& t2, std::size_t n, std::uint64_t* degenerate) {
+        return simd::get_degenerate_pairs<Avx2f>(t1, t2, n, degenerate);
+    }
+
+    void get_nearest_hits_avx2(const RayScene& scene, const Ray* rays, std::size_t n, RayHit* hits) {
+        simd::get_nearest_hits<Avx2>(scene, rays, n, hits);
+    }
+
+    void count_crossings_avx2(const RayScene& scene, const Ray* rays, std::size_t n, std::uint32_t* crossings, std::uint64_t* uncertain) {
+        simd::count_crossings<Avx2>(scene, rays, n, crossings, uncertain);
+    }
+}
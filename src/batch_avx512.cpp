@@ -0,0 +1,97 @@
+#include <immintrin.h>
+#include "batch_kernel.hpp"
+#include "ray_kernel.hpp"
+
+namespace triangle_intersection {
+    namespace {
+        struct Avx512 {
+            using scalar = double;
+            using vec = __m512d;
+            using mask = __mmask8;
+            static constexpr std::size_t width = 8;
+
+            static vec load(const double* p) { return _mm512_loadu_pd(p); }
+            static void store(double* p, vec a) { _mm512_storeu_pd(p, a); }
+            static vec set1(double v) { return _mm512_set1_pd(v); }
+            static vec add(vec a, vec b) { return _mm512_add_pd(a, b); }
+            static vec sub(vec a, vec b) { return _mm512_sub_pd(a, b); }
+            static vec mul(vec a, vec b) { return _mm512_mul_pd(a, b); }
+            static vec div(vec a, vec b) { return _mm512_div_pd(a, b); }
+            static vec min(vec a, vec b) { return _mm512_min_pd(a, b); }
+            static vec max(vec a, vec b) { return _mm512_max_pd(a, b); }
+            static vec sqrt(vec a) { return _mm512_sqrt_pd(a); }
+            static vec abs(vec a) { return _mm512_abs_pd(a); }
+
+            static mask lt(vec a, vec b) { return _mm512_cmp_pd_mask(a, b, _CMP_LT_OQ); }
+            static mask gt(vec a, vec b) { return _mm512_cmp_pd_mask(a, b, _CMP_GT_OQ); }
+            static mask le(vec a, vec b) { return _mm512_cmp_pd_mask(a, b, _CMP_LE_OQ); }
+            static mask ge(vec a, vec b) { return _mm512_cmp_pd_mask(a, b, _CMP_GE_OQ); }
+            static mask eq(vec a, vec b) { return _mm512_cmp_pd_mask(a, b, _CMP_EQ_OQ); }
+
+            static mask and_(mask a, mask b) { return static_cast<mask>(a & b); }
+            static mask or_(mask a, mask b) { return static_cast<mask>(a | b); }
+            static mask andnot(mask a, mask b) { return static_cast<mask>(a & ~b); }
+            static mask not_(mask a) { return static_cast<mask>(~a); }
+            static bool none(mask a) { return a == 0; }
+            static unsigned bits(mask a) { return a; }
+
+            static vec select(mask m, vec a, vec b) { return _mm512_mask_blend_pd(m, b, a); }
+        };
+
+        struct Avx512f {
+            using scalar = float;
+            using vec = __m512;
+            using mask = __mmask16;
+            static constexpr std::size_t width = 16;
+
+            static vec load(const float* p) { return _mm512_loadu_ps(p); }
+            static vec set1(float v) { return _mm512_set1_ps(v); }
+            static vec add(vec a, vec b) { return _mm512_add_ps(a, b); }
+            static vec sub(vec a, vec b) { return _mm512_sub_ps(a, b); }
+            static vec mul(vec a, vec b) { return _mm512_mul_ps(a, b); }
+            static vec sqrt(vec a) { return _mm512_sqrt_ps(a); }
+            static vec abs(vec a) { return _mm512_abs_ps(a); }
+
+            static mask lt(vec a, vec b) { return _mm512_cmp_ps_mask(a, b, _CMP_LT_OQ); }
+            static mask gt(vec a, vec b) { return _mm512_cmp_ps_mask(a, b, _CMP_GT_OQ); }
+            static mask le(vec a, vec b) { return _mm512_cmp_ps_mask(a, b, _CMP_LE_OQ); }
+            static mask ge(vec a, vec b) { return _mm512_cmp_ps_mask(a, b, _CMP_GE_OQ); }
+            static mask eq(vec a, vec b) { return _mm512_cmp_ps_mask(a, b, _CMP_EQ_OQ); }
+
+            static mask and_(mask a, mask b) { return static_cast<mask>(a & b); }
+            static mask or_(mask a, mask b) { return static_cast<mask>(a | b); }
+            static mask andnot(mask a, mask b) { return static_cast<mask>(a & ~b); }
+            static mask not_(mask a) { return static_cast<mask>(~a); }
+            static bool none(mask a) { return a == 0; }
+            static unsigned bits(mask a) { return a; }
+
+            static vec select(mask m, vec a, vec b) { return _mm512_mask_blend_ps(m, b, a); }
+        };
+    }
+
+    std::size_t have_intersection_batch_avx512(const TriangleBatch& t1, const TriangleBatch& t2, std::size_t n, std::uint64_t* mask, bool check_degenerate) {
+        return check_degenerate ? simd::have_intersection_batch<Avx512, true>(t1, t2, n, mask)
+                                : simd::have_intersection_batch<Avx512, false>(t1, t2, n, mask);
+    }
+
+    std::size_t get_degenerate_pairs_avx512(const TriangleBatch& t1, const TriangleBatch& t2, std::size_t n, std::uint64_t* degenerate) {
+        return simd::get_degenerate_pairs<Avx512>(t1, t2, n, degenerate);
+    }
+
+    std::size_t have_intersection_batch_avx512(const FloatTriangleBatch& t1, const FloatTriangleBatch& t2, std::size_t n, std::uint64_t* mask, bool check_degenerate) {
+        return check_degenerate ? simd::have_intersection_batch<Avx512f, true>(t1, t2, n, mask)
+                                : simd::have_intersection_batch<Avx512f, false>(t1, t2, n, mask);
+    }
+
+    std::size_t get_degenerate_pairs_avx512(const FloatTriangleBatch& t1, const FloatTriangleBatch& t2, std::size_t n, std::uint64_t* degenerate) {
+        return simd::get_degenerate_pairs<Avx512f>(t1, t2, n, degenerate);
+    }
+
+    void get_nearest_hits_avx512(const RayScene& scene, const Ray* rays, std::size_t n, RayHit* hits) {
+        simd::get_nearest_hits<Avx512>(scene, rays, n, hits);
+    }
+
+    void count_crossings_avx512(const RayScene& scene, const Ray* rays, std::size_t n, std::uint32_t* crossings, std::uint64_t* uncertain) {
+        simd::count_crossings<Avx512>(scene, rays, n, crossings, uncertain);
+    }
+}
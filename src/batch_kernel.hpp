@@ -0,0 +1,300 @@
+#pragma once
+
+#include <limits>
+#include "intersection_private.hpp"
+
+/*
+Devillers-Guigue sign tests evaluated over W lanes at once, in double or in float.
+Ops wraps the intrinsics of one instruction set and scalar type:
+    scalar, vec, mask, width,
+    load, set1, add, sub, mul, sqrt, abs,
+    lt, gt, le, ge, eq (vec, vec -> mask),
+    and_, or_, andnot (a & ~b), not_, none, bits (mask -> lane bits),
+    select (mask, a, b -> mask ? a : b)
+
+The arithmetic is performed in the same order as the scalar code and every determinant goes through
+the error filter of RobustPredicates, so every lane that stays on the vector path gives exactly the scalar answer.
+Lanes holding points or segments and lanes with a determinant the filter cannot decide
+(coplanar triangles among them) are reported back to be tested by the scalar kernel.
+In float the filter also accounts for underflow, a decided lane has the exact signs of the float coordinates,
+so the answer is the one of the double kernel on the widened coordinates.
+This header must only be included by the translation units compiled for the corresponding instruction set.
+*/
+
+namespace triangle_intersection {
+    namespace simd {
+        template <class T>
+        struct Bounds;
+
+        template <>
+        struct Bounds<double> {
+            static constexpr double orient3d = ORIENT3D_ERROR_BOUND;
+            static constexpr double underflow = 0; // like RobustPredicates, underflow is ignored in double
+            static constexpr double underflow_scale = 1;
+            static constexpr double segment = EPS;
+            static constexpr double overflow = 1e300;
+        };
+
+        template <>
+        struct Bounds<float> {
+            static constexpr float orient3d = 6 * std::numeric_limits<float>::epsilon();
+            // absolute error of a product rounded to a subnormal, per unit of its factors
+            static constexpr float underflow = 8 * std::numeric_limits<float>::denorm_min();
+            // keeps the filter itself out of the subnormal range, where every operation is a microcode assist on x86
+            static constexpr float underflow_scale = 16777216.0f; // 2^24
+            // far above the float rounding error of the lengths, so every lane is_segment accepts in double is caught
+            static constexpr float segment = 16 * std::numeric_limits<float>::epsilon();
+            static constexpr float overflow = 1e37f;
+        };
+
+        template <class Ops>
+        typename Ops::vec get_determinant_3d(const typename Ops::vec p1[3], const typename Ops::vec p2[3],
+                                             const typename Ops::vec p3[3], const typename Ops::vec p4[3],
+                                             typename Ops::mask& uncertain) {
+
+            // uncertain receives the lanes RobustPredicates::orient3d would recompute exactly, and in float the undecided ones
+
+            typename Ops::vec m[3][3] = {
+                { Ops::sub(p1[0], p4[0]), Ops::sub(p1[1], p4[1]), Ops::sub(p1[2], p4[2]) },
+                { Ops::sub(p2[0], p4[0]), Ops::sub(p2[1], p4[1]), Ops::sub(p2[2], p4[2]) },
+                { Ops::sub(p3[0], p4[0]), Ops::sub(p3[1], p4[1]), Ops::sub(p3[2], p4[2]) }
+            };
+
+            typename Ops::vec terms[6] = {
+                Ops::mul(Ops::mul(m[0][0], m[1][1]), m[2][2]),
+                Ops::mul(Ops::mul(m[0][1], m[1][2]), m[2][0]),
+                Ops::mul(Ops::mul(m[0][2], m[1][0]), m[2][1]),
+                Ops::mul(Ops::mul(m[0][2], m[1][1]), m[2][0]),
+                Ops::mul(Ops::mul(m[0][1], m[1][0]), m[2][2]),
+                Ops::mul(Ops::mul(m[0][0], m[1][2]), m[2][1])
+            };
+
+            typename Ops::vec d = Ops::add(Ops::add(terms[0], terms[1]), terms[2]);
+            d = Ops::sub(Ops::sub(Ops::sub(d, terms[3]), terms[4]), terms[5]);
+
+            typename Ops::vec magnitude = Ops::abs(terms[0]);
+            for (int i = 1; i < 6; i++) {
+                magnitude = Ops::add(magnitude, Ops::abs(terms[i]));
+            }
+            using bounds = Bounds<typename Ops::scalar>;
+            if (bounds::underflow == 0) {
+                uncertain = Ops::not_(Ops::gt(Ops::abs(d), Ops::mul(Ops::set1(bounds::orient3d), magnitude)));
+                return d;
+            }
+
+            // |d| - orient3d * magnitude > underflow * (1 + sum of |m|), both sides scaled
+            typename Ops::vec factors = Ops::set1(1);
+            for (int i = 0; i < 3; i++) {
+                for (int j = 0; j < 3; j++) {
+                    factors = Ops::add(factors, Ops::abs(m[i][j]));
+                }
+            }
+            typename Ops::vec margin = Ops::sub(Ops::abs(d), Ops::mul(Ops::set1(bounds::orient3d), magnitude));
+            uncertain = Ops::not_(Ops::gt(Ops::mul(margin, Ops::set1(bounds::underflow_scale)),
+                                          Ops::mul(Ops::set1(bounds::underflow * bounds::underflow_scale), factors)));
+
+            return d;
+        }
+
+        template <class Ops>
+        typename Ops::vec get_length(const typename Ops::vec p1[3], const typename Ops::vec p2[3]) {
+            typename Ops::vec dx = Ops::sub(p2[0], p1[0]);
+            typename Ops::vec dy = Ops::sub(p2[1], p1[1]);
+            typename Ops::vec dz = Ops::sub(p2[2], p1[2]);
+            return Ops::sqrt(Ops::add(Ops::add(Ops::mul(dx, dx), Ops::mul(dy, dy)), Ops::mul(dz, dz)));
+        }
+
+        template <class Ops>
+        typename Ops::mask is_point(const typename Ops::vec t[9]) {
+            return Ops::and_(Ops::and_(Ops::and_(Ops::eq(t[0], t[3]), Ops::eq(t[0], t[6])), Ops::and_(Ops::eq(t[1], t[4]), Ops::eq(t[1], t[7]))),
+                             Ops::and_(Ops::eq(t[2], t[5]), Ops::eq(t[2], t[8])));
+        }
+
+        template <class Ops>
+        typename Ops::mask may_be_segment(const typename Ops::vec t[9]) {
+
+            /*
+            Conservative version of is_segment: the lengths are compared with a tolerance far above
+            the rounding error of the scalar code, so every lane is_segment could accept is reported.
+            Lanes with non-finite values are reported as well
+            */
+
+            typename Ops::vec l1 = get_length<Ops>(t, t + 3);
+            typename Ops::vec l2 = get_length<Ops>(t, t + 6);
+            typename Ops::vec l3 = get_length<Ops>(t + 3, t + 6);
+
+            typename Ops::vec sum = Ops::add(Ops::add(l1, l2), l3);
+            typename Ops::vec tolerance = Ops::mul(sum, Ops::set1(Bounds<typename Ops::scalar>::segment));
+
+            typename Ops::mask m = Ops::le(Ops::abs(Ops::sub(l2, Ops::add(l1, l3))), tolerance);
+            m = Ops::or_(m, Ops::le(Ops::abs(Ops::sub(l3, Ops::add(l1, l2))), tolerance));
+            m = Ops::or_(m, Ops::le(Ops::abs(Ops::sub(l1, Ops::add(l2, l3))), tolerance));
+            return Ops::or_(m, Ops::not_(Ops::le(sum, Ops::set1(Bounds<typename Ops::scalar>::overflow))));
+        }
+
+        template <class Ops>
+        typename Ops::mask is_rejected(const typename Ops::vec d[3]) {
+            typename Ops::vec zero = Ops::set1(0.0);
+            typename Ops::mask neg = Ops::and_(Ops::and_(Ops::lt(d[0], zero), Ops::lt(d[1], zero)), Ops::lt(d[2], zero));
+            typename Ops::mask pos = Ops::and_(Ops::and_(Ops::gt(d[0], zero), Ops::gt(d[1], zero)), Ops::gt(d[2], zero));
+            return Ops::or_(neg, pos);
+        }
+
+        template <class Ops>
+        void reorder_points(typename Ops::vec t[9], const typename Ops::vec d[3], typename Ops::mask& positive_side) {
+
+            // lane-wise version of get_lone_vertex and rotate_points
+
+            typename Ops::vec zero = Ops::set1(0.0);
+            typename Ops::mask g[3], l[3], z[3];
+            for (int i = 0; i < 3; i++) {
+                g[i] = Ops::gt(d[i], zero);
+                l[i] = Ops::lt(d[i], zero);
+                z[i] = Ops::not_(Ops::or_(g[i], l[i]));
+            }
+
+            typename Ops::mask lone2 = Ops::or_(Ops::or_(Ops::and_(g[0], g[1]), Ops::and_(l[0], l[1])), Ops::and_(z[0], z[1]));
+            typename Ops::mask lone1 = Ops::or_(
+                Ops::or_(Ops::and_(Ops::andnot(g[0], g[1]), g[2]), Ops::and_(Ops::andnot(l[0], l[1]), l[2])),
+                Ops::and_(z[0], Ops::or_(Ops::andnot(l[1], l[2]), Ops::andnot(g[1], g[2]))));
+
+            positive_side = Ops::or_(
+                Ops::or_(Ops::andnot(Ops::andnot(g[0], g[1]), g[2]), Ops::and_(l[0], Ops::or_(l[1], l[2]))),
+                Ops::and_(z[0], Ops::or_(Ops::or_(Ops::and_(l[1], l[2]), Ops::andnot(g[1], g[2])), Ops::and_(z[1], g[2]))));
+
+            for (int c = 0; c < 3; c++) {
+                typename Ops::vec p = t[c], q = t[3 + c], r = t[6 + c];
+                t[c] = Ops::select(lone1, q, Ops::select(lone2, r, p));
+                t[3 + c] = Ops::select(lone1, r, Ops::select(lone2, p, q));
+                t[6 + c] = Ops::select(lone1, p, Ops::select(lone2, q, r));
+            }
+        }
+
+        template <class Ops>
+        void swap_last_points(typename Ops::vec t[9], typename Ops::mask m) {
+            for (int c = 0; c < 3; c++) {
+                typename Ops::vec q = t[3 + c];
+                t[3 + c] = Ops::select(m, t[6 + c], q);
+                t[6 + c] = Ops::select(m, q, t[6 + c]);
+            }
+        }
+
+        template <class Ops>
+        typename Ops::mask may_be_degenerate(const typename Ops::vec t1[9], const typename Ops::vec t2[9]) {
+            return Ops::or_(Ops::or_(is_point<Ops>(t1), is_point<Ops>(t2)),
+                            Ops::or_(may_be_segment<Ops>(t1), may_be_segment<Ops>(t2)));
+        }
+
+        template <class Ops, class Batch>
+        void load_lanes(const Batch& b1, const Batch& b2, std::size_t first, typename Ops::vec t1[9], typename Ops::vec t2[9]) {
+            for (int k = 0; k < 9; k++) {
+                t1[k] = Ops::load(b1.coords[k] + first);
+                t2[k] = Ops::load(b2.coords[k] + first);
+            }
+        }
+
+        /*
+        degenerate receives the lanes that may hold a point or a segment, the other fallback lanes
+        are known to be regular and skip the degeneracy tests of the scalar kernel.
+        Without CheckDegenerate no lane is tested and degenerate is 0
+        */
+        template <class Ops, bool CheckDegenerate, class Batch>
+        void have_intersection_lanes(const Batch& b1, const Batch& b2, std::size_t first,
+                                     unsigned& hit, unsigned& fallback, unsigned& degenerate) {
+            typename Ops::vec t1[9], t2[9];
+            load_lanes<Ops>(b1, b2, first, t1, t2);
+
+            typename Ops::mask u[3];
+            typename Ops::vec d1[3] = {
+                get_determinant_3d<Ops>(t2, t2 + 3, t2 + 6, t1, u[0]),
+                get_determinant_3d<Ops>(t2, t2 + 3, t2 + 6, t1 + 3, u[1]),
+                get_determinant_3d<Ops>(t2, t2 + 3, t2 + 6, t1 + 6, u[2])
+            };
+
+            // coplanar lanes have three zero determinants and are among the uncertain ones
+            typename Ops::mask scalar = Ops::or_(Ops::or_(u[0], u[1]), u[2]);
+            degenerate = 0;
+            if (CheckDegenerate) {
+                typename Ops::mask m = may_be_degenerate<Ops>(t1, t2);
+                scalar = Ops::or_(scalar, m);
+                degenerate = Ops::bits(m);
+            }
+            hit = 0;
+
+            typename Ops::mask live = Ops::andnot(Ops::not_(scalar), is_rejected<Ops>(d1));
+            if (Ops::none(live)) {
+                fallback = Ops::bits(scalar);
+                return;
+            }
+
+            typename Ops::vec d2[3] = {
+                get_determinant_3d<Ops>(t1, t1 + 3, t1 + 6, t2, u[0]),
+                get_determinant_3d<Ops>(t1, t1 + 3, t1 + 6, t2 + 3, u[1]),
+                get_determinant_3d<Ops>(t1, t1 + 3, t1 + 6, t2 + 6, u[2])
+            };
+
+            typename Ops::mask uncertain = Ops::and_(live, Ops::or_(Ops::or_(u[0], u[1]), u[2]));
+            scalar = Ops::or_(scalar, uncertain);
+            live = Ops::andnot(Ops::andnot(live, uncertain), is_rejected<Ops>(d2));
+            if (Ops::none(live)) {
+                fallback = Ops::bits(scalar);
+                return;
+            }
+
+            typename Ops::mask side1, side2;
+            reorder_points<Ops>(t1, d1, side1);
+            reorder_points<Ops>(t2, d2, side2);
+            swap_last_points<Ops>(t1, side2);
+            swap_last_points<Ops>(t2, side1);
+
+            typename Ops::vec d[2] = {
+                get_determinant_3d<Ops>(t1, t1 + 3, t2, t2 + 3, u[0]),
+                get_determinant_3d<Ops>(t1, t1 + 6, t2 + 6, t2, u[1])
+            };
+
+            uncertain = Ops::and_(live, Ops::or_(u[0], u[1]));
+            live = Ops::andnot(live, uncertain);
+            fallback = Ops::bits(Ops::or_(scalar, uncertain));
+
+            typename Ops::vec zero = Ops::set1(0.0);
+            hit = Ops::bits(Ops::and_(live, Ops::and_(Ops::ge(d[0], zero), Ops::ge(d[1], zero))));
+        }
+
+        template <class Ops, bool CheckDegenerate, class Batch>
+        std::size_t have_intersection_batch(const Batch& t1, const Batch& t2, std::size_t n, std::uint64_t* mask) {
+
+            // processes the whole groups of Ops::width lanes, returns the number of pairs done
+
+            std::size_t count = n - n % Ops::width;
+            for (std::size_t i = 0; i < count; i += Ops::width) {
+                unsigned hit, fallback, degenerate;
+                have_intersection_lanes<Ops, CheckDegenerate>(t1, t2, i, hit, fallback, degenerate);
+
+                for (unsigned lane = 0; fallback != 0; lane++, fallback >>= 1, degenerate >>= 1) {
+                    if ((fallback & 1) != 0 && have_intersection_lane(t1, t2, i + lane, (degenerate & 1) != 0)) {
+                        hit |= 1u << lane;
+                    }
+                }
+
+                mask[i / 64] |= static_cast<std::uint64_t>(hit) << (i % 64);
+            }
+
+            return count;
+        }
+
+        template <class Ops, class Batch>
+        std::size_t get_degenerate_pairs(const Batch& t1, const Batch& t2, std::size_t n, std::uint64_t* degenerate) {
+
+            // whole groups of Ops::width lanes, like have_intersection_batch
+
+            std::size_t count = n - n % Ops::width;
+            for (std::size_t i = 0; i < count; i += Ops::width) {
+                typename Ops::vec v1[9], v2[9];
+                load_lanes<Ops>(t1, t2, i, v1, v2);
+                degenerate[i / 64] |= static_cast<std::uint64_t>(Ops::bits(may_be_degenerate<Ops>(v1, v2))) << (i % 64);
+            }
+
+            return count;
+        }
+    }
+}
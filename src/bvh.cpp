@@ -0,0 +1,225 @@
+#include <algorithm>
+#include <atomic>
+#include <future>
+#include <limits>
+#include <thread>
+#include "bvh.hpp"
+
+namespace triangle_intersection {
+    namespace {
+        constexpr int BIN_COUNT = 16;
+        constexpr std::uint32_t MAX_LEAF_SIZE = 4;
+        constexpr std::uint32_t PARALLEL_THRESHOLD = 1 << 14;
+        constexpr int MAX_SAH_DEPTH = 48;
+
+        Aabb get_empty_box() {
+            constexpr double inf = std::numeric_limits<double>::infinity();
+            return { { inf, inf, inf }, { -inf, -inf, -inf } };
+        }
+
+        void grow(Aabb& b, const Aabb& other) {
+            for (int i = 0; i < 3; i++) {
+                b.min[i] = std::min(b.min[i], other.min[i]);
+                b.max[i] = std::max(b.max[i], other.max[i]);
+            }
+        }
+
+        double get_half_area(const Aabb& b) {
+            double d[3] = { b.max[0] - b.min[0], b.max[1] - b.min[1], b.max[2] - b.min[2] };
+            return d[0] * d[1] + d[1] * d[2] + d[2] * d[0];
+        }
+
+        struct Builder {
+            Builder(const std::vector<Aabb>& boxes, std::vector<std::uint32_t>& indices, std::vector<Bvh::Node>& nodes, int max_spawn_depth)
+                : boxes(boxes), centroids(boxes.size() * 3), indices(indices), nodes(nodes), max_spawn_depth(max_spawn_depth) {}
+
+            const std::vector<Aabb>& boxes;
+            std::vector<double> centroids;
+            std::vector<std::uint32_t>& indices;
+            std::vector<Bvh::Node>& nodes;
+            std::atomic<std::uint32_t> node_count { 1 };
+            int max_spawn_depth;
+
+            void build(std::uint32_t node, std::uint32_t begin, std::uint32_t end, int depth);
+        };
+
+        void Builder::build(std::uint32_t node, std::uint32_t begin, std::uint32_t end, int depth) {
+            Aabb box = get_empty_box();
+            Aabb centroid_box = get_empty_box();
+            for (std::uint32_t i = begin; i < end; i++) {
+                grow(box, boxes[indices[i]]);
+                const double* c = &centroids[indices[i] * 3];
+                grow(centroid_box, { { c[0], c[1], c[2] }, { c[0], c[1], c[2] } });
+            }
+
+            std::uint32_t count = end - begin;
+            nodes[node] = { box, begin, count };
+            if (count <= MAX_LEAF_SIZE) {
+                return;
+            }
+
+            int best_axis = -1;
+            int best_bin = 0;
+            double best_cost = std::numeric_limits<double>::infinity();
+
+            auto get_bin = [&] (std::uint32_t t, int axis) {
+                double extent = centroid_box.max[axis] - centroid_box.min[axis];
+                int bin = static_cast<int>((centroids[t * 3 + axis] - centroid_box.min[axis]) / extent * BIN_COUNT);
+                return std::min(std::max(bin, 0), BIN_COUNT - 1);
+            };
+
+            if (depth < MAX_SAH_DEPTH) {
+                for (int axis = 0; axis < 3; axis++) {
+                    if (!(centroid_box.max[axis] > centroid_box.min[axis])) {
+                        continue;
+                    }
+
+                    Aabb bin_boxes[BIN_COUNT];
+                    std::uint32_t bin_counts[BIN_COUNT] = {};
+                    std::fill(bin_boxes, bin_boxes + BIN_COUNT, get_empty_box());
+                    for (std::uint32_t i = begin; i < end; i++) {
+                        int bin = get_bin(indices[i], axis);
+                        bin_counts[bin]++;
+                        grow(bin_boxes[bin], boxes[indices[i]]);
+                    }
+
+                    // cost of the right side for a split after bin i
+                    double right_cost[BIN_COUNT];
+                    Aabb right = get_empty_box();
+                    std::uint32_t right_count = 0;
+                    for (int i = BIN_COUNT - 1; i > 0; i--) {
+                        grow(right, bin_boxes[i]);
+                        right_count += bin_counts[i];
+                        right_cost[i - 1] = right_count == 0 ? -1 : get_half_area(right) * right_count;
+                    }
+
+                    Aabb left = get_empty_box();
+                    std::uint32_t left_count = 0;
+                    for (int i = 0; i < BIN_COUNT - 1; i++) {
+                        grow(left, bin_boxes[i]);
+                        left_count += bin_counts[i];
+                        if (left_count == 0 || right_cost[i] < 0) {
+                            continue;
+                        }
+
+                        double cost = get_half_area(left) * left_count + right_cost[i];
+                        if (cost < best_cost) {
+                            best_cost = cost;
+                            best_axis = axis;
+                            best_bin = i;
+                        }
+                    }
+                }
+            }
+
+            std::uint32_t* first = indices.data() + begin;
+            std::uint32_t* last = indices.data() + end;
+            std::uint32_t* middle;
+
+            if (best_axis >= 0) {
+                middle = std::partition(first, last, [&] (std::uint32_t t) { return get_bin(t, best_axis) <= best_bin; });
+            } else {
+                // all centroids coincide or the tree got too deep: median split on the widest axis
+                int axis = 0;
+                for (int i = 1; i < 3; i++) {
+                    if (centroid_box.max[i] - centroid_box.min[i] > centroid_box.max[axis] - centroid_box.min[axis]) {
+                        axis = i;
+                    }
+                }
+                middle = first + count / 2;
+                std::nth_element(first, middle, last, [&] (std::uint32_t a, std::uint32_t b) {
+                    return centroids[a * 3 + axis] < centroids[b * 3 + axis];
+                });
+            }
+
+            std::uint32_t split = begin + static_cast<std::uint32_t>(middle - first);
+            std::uint32_t children = node_count.fetch_add(2);
+            nodes[node].first = children;
+            nodes[node].count = 0;
+
+            if (count >= PARALLEL_THRESHOLD && depth < max_spawn_depth) {
+                std::future<void> left = std::async(std::launch::async, [this, children, begin, split, depth] { build(children, begin, split, depth + 1); });
+                build(children + 1, split, end, depth + 1);
+                left.get();
+            } else {
+                build(children, begin, split, depth + 1);
+                build(children + 1, split, end, depth + 1);
+            }
+        }
+    }
+
+    bool have_overlap(const Aabb& b1, const Aabb& b2) noexcept {
+        return b1.min[0] <= b2.max[0] && b2.min[0] <= b1.max[0]
+            && b1.min[1] <= b2.max[1] && b2.min[1] <= b1.max[1]
+            && b1.min[2] <= b2.max[2] && b2.min[2] <= b1.max[2];
+    }
+
+    Aabb get_box(const double t[9]) noexcept {
+        Aabb b;
+        for (int i = 0; i < 3; i++) {
+            b.min[i] = std::min(std::min(t[i], t[i + 3]), t[i + 6]);
+            b.max[i] = std::max(std::max(t[i], t[i + 3]), t[i + 6]);
+        }
+        return b;
+    }
+
+    Bvh::Bvh(const double* triangles, std::size_t count) : triangles_(triangles), boxes_(count), indices_(count) {
+        if (count == 0) {
+            return;
+        }
+
+        unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+        int max_spawn_depth = 0;
+        while ((1u << max_spawn_depth) < threads) {
+            max_spawn_depth++;
+        }
+
+        Builder builder(boxes_, indices_, nodes_, max_spawn_depth);
+        for (std::size_t i = 0; i < count; i++) {
+            boxes_[i] = get_box(triangles + i * 9);
+            for (int k = 0; k < 3; k++) {
+                builder.centroids[i * 3 + k] = (boxes_[i].min[k] + boxes_[i].max[k]) * 0.5;
+            }
+            indices_[i] = static_cast<std::uint32_t>(i);
+        }
+
+        nodes_.resize(2 * count - 1);
+        builder.build(0, 0, static_cast<std::uint32_t>(count), 0);
+        nodes_.resize(builder.node_count);
+    }
+    void Bvh::refit(const std::uint32_t* triangles, std::size_t count) {
+        if (parents_.empty() && !nodes_.empty()) {
+            parents_.assign(nodes_.size(), 0);
+            leaves_.resize(boxes_.size());
+            for (std::uint32_t n = 0; n < nodes_.size(); n++) {
+                const Node& node = nodes_[n];
+                if (node.is_leaf()) {
+                    for (std::uint32_t k = node.first; k < node.first + node.count; k++) {
+                        leaves_[indices_[k]] = n;
+                    }
+                } else {
+                    parents_[node.first] = parents_[node.first + 1] = n;
+                }
+            }
+        }
+
+        for (std::size_t i = 0; i < count; i++) {
+            std::uint32_t t = triangles[i];
+            boxes_[t] = get_box(triangles_ + std::size_t(t) * 9);
+
+            std::uint32_t n = leaves_[t];
+            Node& leaf = nodes_[n];
+            leaf.box = get_empty_box();
+            for (std::uint32_t k = leaf.first; k < leaf.first + leaf.count; k++) {
+                grow(leaf.box, boxes_[indices_[k]]);
+            }
+
+            while (n != 0) {
+                n = parents_[n];
+                Node& node = nodes_[n];
+                node.box = nodes_[node.first].box;
+                grow(node.box, nodes_[node.first + 1].box);
+            }
+        }
+    }
+}
@@ -0,0 +1,314 @@
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include "bvh.hpp"
+#include "compact_scene.hpp"
+#include "intersection_private.hpp"
+
+namespace triangle_intersection {
+    namespace {
+        constexpr std::uint32_t MAX_CODE = 65535;
+
+        float round_down(double x) {
+            float f = static_cast<float>(x);
+            return f > x ? std::nextafter(f, -std::numeric_limits<float>::infinity()) : f;
+        }
+
+        float round_up(double x) {
+            float f = static_cast<float>(x);
+            return f < x ? std::nextafter(f, std::numeric_limits<float>::infinity()) : f;
+        }
+
+        /*
+        Quantization grid of a leaf. Encoding and decoding evaluate the same expressions, so lower(q) <= x <= upper(q)
+        holds for the decoded bounds exactly as it was checked when x was encoded
+        */
+        struct Frame {
+            double min[3];
+            double max[3];
+            double scale[3];
+
+            explicit Frame(const CompactScene::Node& node) {
+                for (int k = 0; k < 3; k++) {
+                    min[k] = node.min[k];
+                    max[k] = node.max[k];
+                    scale[k] = (max[k] - min[k]) * (1.0 / MAX_CODE);
+                }
+            }
+
+            double get_lower(int k, std::uint32_t q) const {
+                return min[k] + q * scale[k];
+            }
+
+            double get_upper(int k, std::uint32_t q) const {
+                return q == MAX_CODE ? max[k] : min[k] + (q + 1) * scale[k];
+            }
+
+            std::uint16_t encode(int k, double x) const {
+                if (scale[k] == 0) {
+                    return 0;
+                }
+                double estimate = std::floor((x - min[k]) / scale[k]);
+                std::uint32_t q = estimate <= 0 ? 0 : estimate >= MAX_CODE ? MAX_CODE : static_cast<std::uint32_t>(estimate);
+                while (q > 0 && get_lower(k, q) > x) {
+                    q--;
+                }
+                while (q < MAX_CODE && get_upper(k, q) < x) {
+                    q++;
+                }
+                return static_cast<std::uint16_t>(q);
+            }
+        };
+
+        bool have_overlap(const CompactScene::Node& n, const Aabb& b) {
+            return n.min[0] <= b.max[0] && b.min[0] <= n.max[0]
+                && n.min[1] <= b.max[1] && b.min[1] <= n.max[1]
+                && n.min[2] <= b.max[2] && b.min[2] <= n.max[2];
+        }
+
+        bool is_regular(const PreparedTriangle& t) {
+            const double* v[3] = { t.vertices, t.vertices + 3, t.vertices + 6 };
+            return t.kind == TriangleKind::Triangle && !is_flat<RobustPredicates>(v);
+        }
+
+        /*
+        Cheaper sufficient test for queries: a normal component that clears its rounding error
+        is not zero, and the exact normal is zero for flat triangles only
+        */
+        bool is_surely_regular(const PreparedTriangle& t) {
+            if (t.kind != TriangleKind::Triangle) {
+                return false;
+            }
+            for (int k = 0; k < 3; k++) {
+                if (std::abs(t.normal[k]) > 2 * PLANE_ERROR_BOUND * t.normal_magnitude[k] + DBL_MIN) {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        /*
+        True when every point within the vertex bounds of the candidate lies strictly on one side of the plane of t.
+        The plane evaluation at the centre of a vertex box carries the error bound of PreparedTriangle,
+        normal_magnitude bounds the exact normal, so the value anywhere in the box is within radius of the centre
+        */
+        bool is_separated(const PreparedTriangle& t, const double lower[9], const double upper[9]) {
+            int side = 0;
+            for (int v = 0; v < 3; v++) {
+                double center[3];
+                double radius = 0;
+                double error = t.offset_magnitude;
+                for (int k = 0; k < 3; k++) {
+                    center[k] = (lower[v * 3 + k] + upper[v * 3 + k]) * 0.5;
+                    double half = std::max(upper[v * 3 + k] - center[k], center[k] - lower[v * 3 + k]);
+                    radius += t.normal_magnitude[k] * half;
+                    error += t.normal_magnitude[k] * std::abs(center[k]);
+                }
+                double margin = PLANE_ERROR_BOUND * error + radius * (1 + 64 * DBL_EPSILON);
+                double d = t.offset - dot_product(t.normal, center);
+
+                int s = d > margin ? 1 : d < -margin ? -1 : 0;
+                if (s == 0 || (v != 0 && s != side)) {
+                    return false;
+                }
+                side = s;
+            }
+            return true;
+        }
+
+        struct Flattener {
+            const Bvh& bvh;
+            std::vector<CompactScene::Node>& nodes;
+            std::vector<CompactScene::QuantizedTriangle>& triangles;
+            std::vector<std::uint32_t>& ids;
+            std::vector<std::uint32_t> counts; // triangles below every node of bvh
+
+            std::uint32_t measure(std::uint32_t node) {
+                const Bvh::Node& source = bvh.nodes()[node];
+                counts[node] = source.is_leaf() ? source.count : measure(source.first) + measure(source.first + 1);
+                return counts[node];
+            }
+
+            void collect(std::uint32_t node, std::vector<std::uint32_t>& leaf) const {
+                const Bvh::Node& source = bvh.nodes()[node];
+                if (source.is_leaf()) {
+                    leaf.insert(leaf.end(), bvh.indices().begin() + source.first, bvh.indices().begin() + source.first + source.count);
+                    return;
+                }
+                collect(source.first, leaf);
+                collect(source.first + 1, leaf);
+            }
+
+            void flatten(std::uint32_t node, int depth) {
+                if (depth >= CompactScene::MAX_DEPTH) {
+                    throw std::length_error("CompactScene: hierarchy too deep");
+                }
+
+                const Bvh::Node& source = bvh.nodes()[node];
+                std::size_t i = nodes.size();
+                nodes.emplace_back();
+                for (int k = 0; k < 3; k++) {
+                    nodes[i].min[k] = round_down(source.box.min[k]);
+                    nodes[i].max[k] = round_up(source.box.max[k]);
+                }
+
+                if (counts[node] > CompactScene::LEAF_SIZE) {
+                    nodes[i].count = nodes[i].regular = 0;
+                    flatten(source.first, depth + 1);
+                    nodes[i].offset = static_cast<std::uint32_t>(nodes.size());
+                    flatten(source.first + 1, depth + 1);
+                    return;
+                }
+
+                // the regular triangles first, the plane test only applies to them
+
+                std::vector<std::uint32_t> leaf;
+                collect(node, leaf);
+                const double* soup = bvh.triangles();
+                auto middle = std::stable_partition(leaf.begin(), leaf.end(), [&] (std::uint32_t t) { return is_regular(PreparedTriangle(soup + std::size_t(t) * 9)); });
+
+                nodes[i].offset = static_cast<std::uint32_t>(ids.size());
+                nodes[i].count = static_cast<std::uint16_t>(leaf.size());
+                nodes[i].regular = static_cast<std::uint16_t>(middle - leaf.begin());
+                Frame frame(nodes[i]);
+                for (std::uint32_t t : leaf) {
+                    CompactScene::QuantizedTriangle q;
+                    for (int c = 0; c < 9; c++) {
+                        q.coords[c] = frame.encode(c % 3, soup[std::size_t(t) * 9 + c]);
+                    }
+                    triangles.push_back(q);
+                    ids.push_back(t);
+                }
+            }
+        };
+    }
+
+    CompactScene::CompactScene(const double* triangles, std::size_t count) : soup_(triangles) {
+        if (count == 0) {
+            return;
+        }
+
+        Bvh bvh(triangles, count);
+        triangles_.reserve(count);
+        ids_.reserve(count);
+        Flattener flattener { bvh, nodes_, triangles_, ids_, std::vector<std::uint32_t>(bvh.nodes().size()) };
+        flattener.measure(0);
+        flattener.flatten(0, 0);
+        nodes_.shrink_to_fit();
+    }
+
+    std::size_t CompactScene::get_memory_size() const noexcept {
+        return nodes_.capacity() * sizeof(Node) + triangles_.capacity() * sizeof(QuantizedTriangle) + ids_.capacity() * sizeof(std::uint32_t)
+            + ids_.size() * 9 * sizeof(double);
+    }
+
+    template <class Visit>
+    void CompactScene::traverse(const double t[9], Visit& visit) const {
+        if (nodes_.empty()) {
+            return;
+        }
+
+        Aabb box = get_box(t);
+        PreparedTriangle prepared(t);
+        bool regular = is_surely_regular(prepared);
+        std::uint32_t stack[MAX_DEPTH];
+        int stack_size = 0;
+
+        if (!have_overlap(nodes_[0], box)) {
+            return;
+        }
+
+        std::uint32_t i = 0;
+        for (;;) {
+            const Node& node = nodes_[i];
+            if (node.is_leaf()) {
+                Frame frame(node);
+                for (std::uint32_t k = node.offset; k < node.offset + node.count; k++) {
+                    const QuantizedTriangle& q = triangles_[k];
+                    bool overlap = true;
+                    for (int axis = 0; axis < 3 && overlap; axis++) {
+                        std::uint32_t min = std::min({ q.coords[axis], q.coords[3 + axis], q.coords[6 + axis] });
+                        std::uint32_t max = std::max({ q.coords[axis], q.coords[3 + axis], q.coords[6 + axis] });
+                        overlap = frame.get_lower(axis, min) <= box.max[axis] && box.min[axis] <= frame.get_upper(axis, max);
+                    }
+                    if (!overlap) {
+                        continue;
+                    }
+
+                    if (regular && k < node.offset + node.regular) {
+                        double lower[9], upper[9];
+                        for (int c = 0; c < 9; c++) {
+                            lower[c] = frame.get_lower(c % 3, q.coords[c]);
+                            upper[c] = frame.get_upper(c % 3, q.coords[c]);
+                        }
+                        if (is_separated(prepared, lower, upper)) {
+                            continue;
+                        }
+                    }
+
+                    std::uint32_t id = ids_[k];
+                    if (have_intersection(prepared, soup_ + std::size_t(id) * 9) && !visit(id)) {
+                        return;
+                    }
+                }
+            } else {
+                bool left = have_overlap(nodes_[i + 1], box);
+                bool right = have_overlap(nodes_[node.offset], box);
+                if (left) {
+                    if (right) {
+                        stack[stack_size++] = node.offset;
+                    }
+                    i++;
+                    continue;
+                }
+                if (right) {
+                    i = node.offset;
+                    continue;
+                }
+            }
+
+            if (stack_size == 0) {
+                return;
+            }
+            i = stack[--stack_size];
+        }
+    }
+
+    bool CompactScene::have_any_hit(const double t[9]) const noexcept {
+        bool hit = false;
+        auto visit = [&] (std::uint32_t) {
+            hit = true;
+            return false;
+        };
+
+        traverse(t, visit);
+        return hit;
+    }
+
+    std::size_t CompactScene::get_hits(const double t[9], std::uint32_t* hits, std::size_t max_hits) const noexcept {
+        std::size_t count = 0;
+        auto visit = [&] (std::uint32_t id) {
+            hits[count++] = id;
+            return count < max_hits;
+        };
+
+        if (max_hits != 0) {
+            traverse(t, visit);
+        }
+        std::sort(hits, hits + count);
+        return count;
+    }
+
+    void CompactScene::get_all_hits(const double t[9], std::vector<std::uint32_t>& hits) const {
+        std::size_t first = hits.size();
+        auto visit = [&] (std::uint32_t id) {
+            hits.push_back(id);
+            return true;
+        };
+
+        traverse(t, visit);
+        std::sort(hits.begin() + static_cast<std::ptrdiff_t>(first), hits.end());
+    }
+}
@@ -0,0 +1,272 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+#include "narrow_phase.hpp"
+
+namespace triangle_intersection {
+    namespace {
+        constexpr double INFINITE_DISTANCE = std::numeric_limits<double>::infinity();
+
+        // closest pair of points found so far, by squared distance
+        struct Closest {
+            double distance = INFINITE_DISTANCE;
+            double p1[3] = { 0, 0, 0 };
+            double p2[3] = { 0, 0, 0 };
+
+            // q1 on the first triangle, q2 on the second, the other way round when reversed
+            void add(const double q1[3], const double q2[3], bool reversed = false) {
+                if (reversed) {
+                    std::swap(q1, q2);
+                }
+                double d[3] = { q1[0] - q2[0], q1[1] - q2[1], q1[2] - q2[2] };
+                double l = dot_product(d, d);
+                if (l < distance) {
+                    distance = l;
+                    std::copy(q1, q1 + 3, p1);
+                    std::copy(q2, q2 + 3, p2);
+                }
+            }
+        };
+
+        void interpolate(const double* const s[2], double a, double q[3]) {
+            for (int k = 0; k < 3; k++) {
+                q[k] = s[0][k] + a * (s[1][k] - s[0][k]);
+            }
+        }
+
+        // q = the point of s closest to p
+        void get_closest_point(const double* const s[2], const double p[3], double q[3]) {
+            double dir[3] = { s[1][0] - s[0][0], s[1][1] - s[0][1], s[1][2] - s[0][2] };
+            double w[3] = { p[0] - s[0][0], p[1] - s[0][1], p[2] - s[0][2] };
+            double a = dot_product(dir, dir);
+            interpolate(s, a > 0 ? std::min(1.0, std::max(0.0, dot_product(w, dir) / a)) : 0.0, q);
+        }
+
+        /*
+        Parameters of the closest points of the lines through s1 and s2, false for parallel lines. Unlike
+        get_line_parameters the parallel test is relative to the edge lengths, small skew edges are not parallel
+        */
+        bool get_edge_parameters(const double* const s1[2], const double* const s2[2], double& coef1, double& coef2) {
+            double dir1[3] = { s1[1][0] - s1[0][0], s1[1][1] - s1[0][1], s1[1][2] - s1[0][2] };
+            double dir2[3] = { s2[1][0] - s2[0][0], s2[1][1] - s2[0][1], s2[1][2] - s2[0][2] };
+            double v[3] = { s1[0][0] - s2[0][0], s1[0][1] - s2[0][1], s1[0][2] - s2[0][2] };
+
+            double a = dot_product(dir1, dir1);
+            double b = dot_product(dir1, dir2);
+            double c = dot_product(dir2, dir2);
+            double d = dot_product(dir1, v);
+            double e = dot_product(dir2, v);
+            double det = a * c - b * b;
+            if (det <= std::numeric_limits<double>::epsilon() * a * c) {
+                return false; // the endpoints against the other edge give the closest points
+            }
+
+            coef1 = (b * e - c * d) / det;
+            coef2 = (a * e - b * d) / det;
+            return true;
+        }
+
+        // p within the prism over t, n the normal of t
+        bool is_above(const double* const t[3], const double n[3], const double p[3]) {
+            for (int i = 0; i < 3; i++) {
+                const double* a = t[i];
+                const double* b = t[(i + 1) % 3];
+                double edge[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+                double w[3] = { p[0] - a[0], p[1] - a[1], p[2] - a[2] };
+                double c[3];
+                cross_product(edge, w, c);
+                if (dot_product(c, n) < 0) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /*
+        Vertices of t1 projected onto t2, and the edges of t1 crossing t2. Nothing for a point or segment t2,
+        the edges then cover it. reversed when t1 is the second triangle of closest
+        */
+        void add_face(Closest& closest, const double* const t1[3], const double* const t2[3], bool reversed) {
+            double edge1[3] = { t2[1][0] - t2[0][0], t2[1][1] - t2[0][1], t2[1][2] - t2[0][2] };
+            double edge2[3] = { t2[2][0] - t2[0][0], t2[2][1] - t2[0][1], t2[2][2] - t2[0][2] };
+            double n[3];
+            cross_product(edge1, edge2, n);
+            double nn = dot_product(n, n);
+            if (!(nn > 0)) {
+                return;
+            }
+
+            double d[3];
+            for (int i = 0; i < 3; i++) {
+                double w[3] = { t1[i][0] - t2[0][0], t1[i][1] - t2[0][1], t1[i][2] - t2[0][2] };
+                d[i] = dot_product(n, w);
+                double h = d[i] / nn;
+                double q[3] = { t1[i][0] - h * n[0], t1[i][1] - h * n[1], t1[i][2] - h * n[2] };
+                if (is_above(t2, n, q)) {
+                    closest.add(t1[i], q, reversed);
+                }
+            }
+
+            for (int i = 0; i < 3; i++) {
+                int j = (i + 1) % 3;
+                if ((d[i] < 0 && d[j] > 0) || (d[i] > 0 && d[j] < 0)) {
+                    const double* s[2] = { t1[i], t1[j] };
+                    double x[3];
+                    interpolate(s, d[i] / (d[i] - d[j]), x);
+                    if (is_above(t2, n, x)) {
+                        closest.add(x, x, reversed);
+                    }
+                }
+            }
+        }
+
+        /*
+        Squared distance. For disjoint triangles the closest points are a vertex and its projection on the other face,
+        or lie on two edges; the parameters of the closest points of the two lines give them when they fall inside both edges,
+        the endpoints against the other edges otherwise. Crossing triangles have an edge through the other face
+        */
+        double get_squared_distance(const double t1[9], const double t2[9], double p1[3], double p2[3]) {
+            const double* v1[3] = { t1, t1 + 3, t1 + 6 };
+            const double* v2[3] = { t2, t2 + 3, t2 + 6 };
+            Closest closest;
+
+            add_face(closest, v1, v2, false);
+            add_face(closest, v2, v1, true);
+
+            for (int i = 0; closest.distance != 0 && i < 3; i++) {
+                const double* s1[2] = { v1[i], v1[(i + 1) % 3] };
+                for (int j = 0; j < 3; j++) {
+                    const double* s2[2] = { v2[j], v2[(j + 1) % 3] };
+                    double q1[3], q2[3];
+
+                    double coef1, coef2;
+                    if (get_edge_parameters(s1, s2, coef1, coef2) && coef1 >= 0 && coef1 <= 1 && coef2 >= 0 && coef2 <= 1) {
+                        interpolate(s1, coef1, q1);
+                        interpolate(s2, coef2, q2);
+                        closest.add(q1, q2);
+                    }
+
+                    get_closest_point(s2, v1[i], q2);
+                    closest.add(v1[i], q2);
+                    get_closest_point(s1, v2[j], q1);
+                    closest.add(q1, v2[j]);
+                }
+            }
+
+            std::copy(closest.p1, closest.p1 + 3, p1);
+            std::copy(closest.p2, closest.p2 + 3, p2);
+            return closest.distance;
+        }
+
+        double get_squared_distance(const Aabb& b1, const Aabb& b2) {
+            double l = 0;
+            for (int k = 0; k < 3; k++) {
+                double gap = std::max({ 0.0, b1.min[k] - b2.max[k], b2.min[k] - b1.max[k] });
+                l += gap * gap;
+            }
+            return l;
+        }
+
+        struct NodePair {
+            std::uint32_t node1;
+            std::uint32_t node2;
+            double distance; // squared, of the boxes
+        };
+
+        /*
+        Depth-first over node pairs within bound (squared), the nearer child pair first. With stop the search
+        ends at the first pair within bound, otherwise bound shrinks to the closest pair found
+        */
+        ClosestPair find_closest_pair(const Bvh& mesh1, const Bvh& mesh2, double max_distance, bool stop) {
+            ClosestPair best { TrianglePair(0, 0), INFINITE_DISTANCE };
+            if (mesh1.size() == 0 || mesh2.size() == 0 || !(max_distance >= 0)) {
+                return best;
+            }
+
+            const std::vector<Bvh::Node>& nodes1 = mesh1.nodes();
+            const std::vector<Bvh::Node>& nodes2 = mesh2.nodes();
+            double bound = max_distance * max_distance;
+            double best_distance = INFINITE_DISTANCE;
+
+            std::vector<NodePair> stack;
+            stack.push_back({ 0, 0, get_squared_distance(nodes1[0].box, nodes2[0].box) });
+            while (!stack.empty()) {
+                NodePair pair = stack.back();
+                stack.pop_back();
+                if (pair.distance > bound) {
+                    continue;
+                }
+
+                const Bvh::Node& n1 = nodes1[pair.node1];
+                const Bvh::Node& n2 = nodes2[pair.node2];
+                if (n1.is_leaf() && n2.is_leaf()) {
+                    for (std::uint32_t i = n1.first; i < n1.first + n1.count; i++) {
+                        std::uint32_t t1 = mesh1.indices()[i];
+                        for (std::uint32_t j = n2.first; j < n2.first + n2.count; j++) {
+                            std::uint32_t t2 = mesh2.indices()[j];
+                            if (get_squared_distance(mesh1.get_triangle_box(t1), mesh2.get_triangle_box(t2)) > bound) {
+                                continue;
+                            }
+
+                            double p1[3], p2[3];
+                            double l = get_squared_distance(mesh1.triangles() + std::size_t(t1) * 9, mesh2.triangles() + std::size_t(t2) * 9, p1, p2);
+                            if (l <= bound && l < best_distance) {
+                                best_distance = l;
+                                best.pair = TrianglePair(t1, t2);
+                                if (stop) {
+                                    best.distance = std::sqrt(l);
+                                    return best;
+                                }
+                                bound = l;
+                            }
+                        }
+                    }
+                    continue;
+                }
+
+                NodePair children[2];
+                if (split_first(n1, n2)) {
+                    children[0] = { n1.first, pair.node2, get_squared_distance(nodes1[n1.first].box, n2.box) };
+                    children[1] = { n1.first + 1, pair.node2, get_squared_distance(nodes1[n1.first + 1].box, n2.box) };
+                } else {
+                    children[0] = { pair.node1, n2.first, get_squared_distance(n1.box, nodes2[n2.first].box) };
+                    children[1] = { pair.node1, n2.first + 1, get_squared_distance(n1.box, nodes2[n2.first + 1].box) };
+                }
+                if (children[0].distance < children[1].distance) {
+                    std::swap(children[0], children[1]);
+                }
+
+                for (const NodePair& child : children) {
+                    if (child.distance <= bound) {
+                        stack.push_back(child);
+                    }
+                }
+            }
+
+            best.distance = std::sqrt(best_distance);
+            return best;
+        }
+    }
+
+    double get_distance(const double t1[9], const double t2[9]) noexcept {
+        double p1[3], p2[3];
+        return get_distance(t1, t2, p1, p2);
+    }
+
+    double get_distance(const double t1[9], const double t2[9], double p1[3], double p2[3]) noexcept {
+        return std::sqrt(get_squared_distance(t1, t2, p1, p2));
+    }
+
+    bool have_proximity(const Bvh& mesh1, const Bvh& mesh2, double tolerance) {
+        return find_closest_pair(mesh1, mesh2, tolerance, true).distance != INFINITE_DISTANCE;
+    }
+
+    ClosestPair get_closest_pair(const Bvh& mesh1, const Bvh& mesh2) {
+        return find_closest_pair(mesh1, mesh2, INFINITE_DISTANCE, false);
+    }
+
+    ClosestPair get_closest_pair(const Bvh& mesh1, const Bvh& mesh2, double max_distance) {
+        return find_closest_pair(mesh1, mesh2, max_distance, false);
+    }
+}
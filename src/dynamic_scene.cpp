@@ -0,0 +1,267 @@
+#include <algorithm>
+#include <limits>
+#include "dynamic_scene.hpp"
+
+namespace triangle_intersection {
+    namespace {
+        // above one moved triangle in REBUILD_FRACTION, sorting and sweeping from scratch is cheaper
+        constexpr std::size_t REBUILD_FRACTION = 4;
+        // below, the narrow phase is not worth waking up threads
+        constexpr std::size_t SERIAL_CANDIDATES = 4096;
+
+        std::uint64_t get_key(std::uint32_t i, std::uint32_t j) {
+            return i < j ? (std::uint64_t(i) << 32) | j : (std::uint64_t(j) << 32) | i;
+        }
+
+        TrianglePair get_pair(std::uint64_t key) {
+            return { static_cast<std::uint32_t>(key >> 32), static_cast<std::uint32_t>(key) };
+        }
+
+        // mins before maxes at equal values, touching boxes overlap as in have_overlap
+        template <class Endpoint>
+        bool is_less(const Endpoint& a, const Endpoint& b) {
+            return a.value < b.value || (a.value == b.value && (a.id & 1) < (b.id & 1));
+        }
+    }
+
+    DynamicScene::DynamicScene(const ParallelOptions& options) : options_(options) {}
+
+    std::uint32_t DynamicScene::add_mesh(const double* triangles, std::size_t count) {
+        std::uint32_t mesh = static_cast<std::uint32_t>(first_triangles_.size());
+        std::uint32_t first = static_cast<std::uint32_t>(meshes_of_.size());
+        first_triangles_.push_back(first);
+        triangles_.insert(triangles_.end(), triangles, triangles + count * 9);
+        boxes_.resize(first + count);
+        meshes_of_.resize(first + count, mesh);
+        is_moved_.resize(first + count, false);
+        partners_.resize(first + count);
+
+        // placed at the end of the lists, the next update sorts them in like moved triangles
+        for (int axis = 0; axis < 3; axis++) {
+            for (std::uint32_t id = 2 * first; id < 2 * (first + count); id++) {
+                positions_[axis].push_back(static_cast<std::uint32_t>(endpoints_[axis].size()));
+                endpoints_[axis].push_back({ std::numeric_limits<double>::infinity(), id });
+            }
+        }
+
+        for (std::uint32_t t = first; t < first + count; t++) {
+            is_moved_[t] = true;
+            moved_.push_back(t);
+        }
+
+        return mesh;
+    }
+
+    void DynamicScene::move_mesh(std::uint32_t mesh, const double* triangles) {
+        std::uint32_t first = first_triangles_[mesh];
+        std::uint32_t last = mesh + 1 < first_triangles_.size() ? first_triangles_[mesh + 1] : static_cast<std::uint32_t>(size());
+        for (std::uint32_t t = first; t < last; t++) {
+            move_triangle(t, triangles + std::size_t(t - first) * 9);
+        }
+    }
+
+    void DynamicScene::move_triangle(std::uint32_t id, const double t[9]) {
+        double* stored = &triangles_[std::size_t(id) * 9];
+        if (std::equal(t, t + 9, stored)) {
+            return;
+        }
+
+        std::copy(t, t + 9, stored);
+        if (!is_moved_[id]) {
+            is_moved_[id] = true;
+            moved_.push_back(id);
+        }
+    }
+
+    void DynamicScene::add_overlap(std::uint32_t i, std::uint32_t j) {
+        if (overlaps_.insert(get_key(i, j)).second) {
+            partners_[i].push_back(j);
+            partners_[j].push_back(i);
+        }
+    }
+
+    bool DynamicScene::remove_overlap(std::uint32_t i, std::uint32_t j) {
+        if (overlaps_.erase(get_key(i, j)) == 0) {
+            return false;
+        }
+
+        auto remove = [] (std::vector<std::uint32_t>& partners, std::uint32_t t) {
+            auto it = std::find(partners.begin(), partners.end(), t);
+            *it = partners.back();
+            partners.pop_back();
+        };
+
+        remove(partners_[i], j);
+        remove(partners_[j], i);
+        return true;
+    }
+
+    void DynamicScene::on_swap(std::uint32_t moving, std::uint32_t other, bool moving_left, std::vector<std::uint64_t>& separated) {
+        std::uint32_t a = moving >> 1;
+        std::uint32_t b = other >> 1;
+        bool is_max = moving & 1;
+        if (is_max == bool(other & 1) || meshes_of_[a] == meshes_of_[b]) {
+            return;
+        }
+
+        // a min passing left of a max (or a max right of a min) may start an overlap, the opposite ends one
+        if (is_max != moving_left) {
+            if (have_overlap(boxes_[a], boxes_[b])) {
+                add_overlap(a, b);
+            }
+        } else if (remove_overlap(a, b)) {
+            separated.push_back(get_key(a, b));
+        }
+    }
+
+    bool DynamicScene::sort_endpoint(int axis, std::uint32_t id, std::vector<std::uint64_t>& separated) {
+        std::vector<Endpoint>& list = endpoints_[axis];
+        std::vector<std::uint32_t>& positions = positions_[axis];
+        std::uint32_t p = positions[id];
+        std::uint32_t start = p;
+        Endpoint e = list[p];
+
+        while (p > 0 && is_less(e, list[p - 1])) {
+            on_swap(id, list[p - 1].id, true, separated);
+            list[p] = list[p - 1];
+            positions[list[p].id] = p;
+            p--;
+        }
+
+        while (p + 1 < list.size() && is_less(list[p + 1], e)) {
+            on_swap(id, list[p + 1].id, false, separated);
+            list[p] = list[p + 1];
+            positions[list[p].id] = p;
+            p++;
+        }
+
+        list[p] = e;
+        positions[id] = p;
+        return p != start;
+    }
+
+    void DynamicScene::rebuild(std::vector<std::uint64_t>& separated) {
+        for (int axis = 0; axis < 3; axis++) {
+            std::vector<Endpoint>& list = endpoints_[axis];
+            std::sort(list.begin(), list.end(), is_less<Endpoint>);
+            for (std::uint32_t p = 0; p < list.size(); p++) {
+                positions_[axis][list[p].id] = p;
+            }
+        }
+
+        // every pair may have been separated, the intersecting ones are checked again after the sweep
+        separated.assign(intersections_.begin(), intersections_.end());
+        overlaps_.clear();
+        for (std::vector<std::uint32_t>& partners : partners_) {
+            partners.clear();
+        }
+
+        // along x: a box overlaps the boxes still open when it opens
+        std::vector<std::uint32_t> open;
+        std::vector<std::uint32_t> open_positions(size());
+        for (const Endpoint& e : endpoints_[0]) {
+            std::uint32_t t = e.id >> 1;
+            if (e.id & 1) {
+                std::uint32_t p = open_positions[t];
+                open[p] = open.back();
+                open_positions[open[p]] = p;
+                open.pop_back();
+            } else {
+                for (std::uint32_t other : open) {
+                    if (meshes_of_[other] != meshes_of_[t] && have_overlap(boxes_[other], boxes_[t])) {
+                        add_overlap(other, t);
+                    }
+                }
+                open_positions[t] = static_cast<std::uint32_t>(open.size());
+                open.push_back(t);
+            }
+        }
+    }
+
+    DynamicScene::Changes DynamicScene::update() {
+        Changes changes;
+        std::vector<std::uint64_t> separated;
+
+        for (std::uint32_t t : moved_) {
+            boxes_[t] = get_box(&triangles_[std::size_t(t) * 9]);
+            for (int axis = 0; axis < 3; axis++) {
+                endpoints_[axis][positions_[axis][2 * t]].value = boxes_[t].min[axis];
+                endpoints_[axis][positions_[axis][2 * t + 1]].value = boxes_[t].max[axis];
+            }
+        }
+
+        if (moved_.size() * REBUILD_FRACTION > size()) {
+            rebuild(separated);
+        } else {
+
+            // a moved endpoint can be held back by another one that has not been sorted yet,
+            // passes are repeated until none moves. The unmoved endpoints keep their order
+
+            for (int axis = 0; axis < 3; axis++) {
+                bool is_moving = true;
+                while (is_moving) {
+                    is_moving = false;
+                    for (std::uint32_t t : moved_) {
+                        is_moving |= sort_endpoint(axis, 2 * t, separated);
+                        is_moving |= sort_endpoint(axis, 2 * t + 1, separated);
+                    }
+                }
+            }
+        }
+
+        // motion changes intersections without changing overlaps, every overlap of a moved triangle is tested
+
+        std::vector<TrianglePair> candidates;
+        for (std::uint32_t t : moved_) {
+            for (std::uint32_t other : partners_[t]) {
+                candidates.push_back(get_pair(get_key(t, other)));
+            }
+        }
+
+        std::sort(candidates.begin(), candidates.end());
+        candidates.erase(std::unique(candidates.begin(), candidates.end()), candidates.end());
+
+        ParallelOptions options = options_;
+        if (candidates.size() < SERIAL_CANDIDATES) {
+            options.max_threads = 1;
+        }
+
+        std::vector<TrianglePair> hits = intersect_pairs(triangles_.data(), triangles_.data(), candidates, options);
+        auto hit = hits.begin();
+        for (const TrianglePair& p : candidates) {
+            std::uint64_t key = get_key(p.first, p.second);
+            if (hit != hits.end() && *hit == p) {
+                ++hit;
+                if (intersections_.insert(key).second) {
+                    changes.added.push_back(p);
+                }
+            } else if (intersections_.erase(key) != 0) {
+                changes.removed.push_back(p);
+            }
+        }
+
+        for (std::uint64_t key : separated) {
+            if (overlaps_.count(key) == 0 && intersections_.erase(key) != 0) {
+                changes.removed.push_back(get_pair(key));
+            }
+        }
+
+        std::sort(changes.removed.begin(), changes.removed.end());
+        for (std::uint32_t t : moved_) {
+            is_moved_[t] = false;
+        }
+        moved_.clear();
+        return changes;
+    }
+
+    std::vector<TrianglePair> DynamicScene::get_intersections() const {
+        std::vector<TrianglePair> pairs;
+        pairs.reserve(intersections_.size());
+        for (std::uint64_t key : intersections_) {
+            pairs.push_back(get_pair(key));
+        }
+
+        std::sort(pairs.begin(), pairs.end());
+        return pairs;
+    }
+}
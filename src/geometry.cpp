@@ -0,0 +1,9 @@
+#include "intersection_private.hpp"
+#include "detail/geometry_inl.hpp"
+
+namespace triangle_intersection {
+    template bool report_t_s<FastPredicates>(SegmentOutput& output, bool hit, const double* const t[3], const double* const s[2]);
+    template bool report_t_s<RobustPredicates>(SegmentOutput& output, bool hit, const double* const t[3], const double* const s[2]);
+    template bool report_coplanar_t_t<FastPredicates>(SegmentOutput& output, bool hit, const double* const t1[3], const double* const t2[3], int k);
+    template bool report_coplanar_t_t<RobustPredicates>(SegmentOutput& output, bool hit, const double* const t1[3], const double* const t2[3], int k);
+}
@@ -0,0 +1,277 @@
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include "intersection_private.hpp"
+
+namespace triangle_intersection {
+    namespace {
+
+        /*
+        Differences of coordinates within MAX_INTEGER_COORDINATE fit in 20 bits plus sign,
+        products of three of them in 60 bits: every determinant below is exact in int64
+        */
+
+        using Point = const std::int32_t*;
+
+        std::int64_t orient3d(Point a, Point b, Point c, Point d) {
+            std::int64_t m[3][3];
+            for (int k = 0; k < 3; k++) {
+                m[0][k] = std::int64_t(a[k]) - d[k];
+                m[1][k] = std::int64_t(b[k]) - d[k];
+                m[2][k] = std::int64_t(c[k]) - d[k];
+            }
+
+            return m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1])
+                 - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0])
+                 + m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+        }
+
+        void get_normal(Point a, Point b, Point c, std::int64_t n[3]) {
+            std::int64_t u[3] = { std::int64_t(b[0]) - a[0], std::int64_t(b[1]) - a[1], std::int64_t(b[2]) - a[2] };
+            std::int64_t v[3] = { std::int64_t(c[0]) - a[0], std::int64_t(c[1]) - a[1], std::int64_t(c[2]) - a[2] };
+            n[0] = u[1] * v[2] - u[2] * v[1];
+            n[1] = u[2] * v[0] - u[0] * v[2];
+            n[2] = u[0] * v[1] - u[1] * v[0];
+        }
+
+        // the axis to drop when projecting onto the plane with normal n, n is not zero
+        int get_dominant_axis(const std::int64_t n[3]) {
+            std::int64_t a[3] = { n[0] < 0 ? -n[0] : n[0], n[1] < 0 ? -n[1] : n[1], n[2] < 0 ? -n[2] : n[2] };
+            if (a[0] > a[1]) {
+                return a[0] > a[2] ? 0 : 2;
+            }
+            return a[1] > a[2] ? 1 : 2;
+        }
+
+        struct Point2d {
+            std::int64_t x, y;
+        };
+
+        Point2d project(Point p, int drop) {
+            return drop == 0 ? Point2d { p[1], p[2] } : drop == 1 ? Point2d { p[0], p[2] } : Point2d { p[0], p[1] };
+        }
+
+        std::int64_t orient2d(const Point2d& a, const Point2d& b, const Point2d& c) {
+            return (a.x - c.x) * (b.y - c.y) - (a.y - c.y) * (b.x - c.x);
+        }
+
+        bool is_same_strict_sign(std::int64_t a, std::int64_t b) {
+            return (a > 0 && b > 0) || (a < 0 && b < 0);
+        }
+
+        // closed segments
+        bool have_intersection_s_s_2d(const Point2d& a0, const Point2d& a1, const Point2d& b0, const Point2d& b1) {
+            std::int64_t o[4] = { orient2d(a0, a1, b0), orient2d(a0, a1, b1), orient2d(b0, b1, a0), orient2d(b0, b1, a1) };
+            if (o[0] == 0 && o[1] == 0) {
+                // on one line: the boxes overlap exactly when the segments do
+                return std::min(a0.x, a1.x) <= std::max(b0.x, b1.x) && std::min(b0.x, b1.x) <= std::max(a0.x, a1.x)
+                    && std::min(a0.y, a1.y) <= std::max(b0.y, b1.y) && std::min(b0.y, b1.y) <= std::max(a0.y, a1.y);
+            }
+            return !is_same_strict_sign(o[0], o[1]) && !is_same_strict_sign(o[2], o[3]);
+        }
+
+        // closed triangle, either orientation
+        bool have_intersection_t_p_2d(const Point2d t[3], const Point2d& p) {
+            std::int64_t o[3] = { orient2d(t[0], t[1], p), orient2d(t[1], t[2], p), orient2d(t[2], t[0], p) };
+            return (o[0] >= 0 && o[1] >= 0 && o[2] >= 0) || (o[0] <= 0 && o[1] <= 0 && o[2] <= 0);
+        }
+
+        bool have_intersection_p_p(Point p1, Point p2) {
+            return p1[0] == p2[0] && p1[1] == p2[1] && p1[2] == p2[2];
+        }
+
+        bool have_intersection_s_p(const Point s[2], Point p) {
+            std::int64_t d[3], v[3];
+            for (int k = 0; k < 3; k++) {
+                d[k] = std::int64_t(s[1][k]) - s[0][k];
+                v[k] = std::int64_t(p[k]) - s[0][k];
+            }
+
+            if (d[1] * v[2] != d[2] * v[1] || d[2] * v[0] != d[0] * v[2] || d[0] * v[1] != d[1] * v[0]) {
+                return false;
+            }
+
+            std::int64_t t = d[0] * v[0] + d[1] * v[1] + d[2] * v[2];
+            return t >= 0 && t <= d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+        }
+
+        bool have_intersection_s_s(const Point s1[2], const Point s2[2]) {
+            if (orient3d(s1[0], s1[1], s2[0], s2[1]) != 0) {
+                return false;
+            }
+
+            // the plane of two segments, or of a segment and a point of the other one when they are parallel
+            std::int64_t n[3];
+            get_normal(s1[0], s1[1], s2[0], n);
+            if (n[0] == 0 && n[1] == 0 && n[2] == 0) {
+                get_normal(s1[0], s1[1], s2[1], n);
+            }
+            if (n[0] == 0 && n[1] == 0 && n[2] == 0) {
+                // all four points on one line, any projection that keeps the line apart works
+                return have_intersection_s_p(s1, s2[0]) || have_intersection_s_p(s1, s2[1])
+                    || have_intersection_s_p(s2, s1[0]);
+            }
+
+            int drop = get_dominant_axis(n);
+            return have_intersection_s_s_2d(project(s1[0], drop), project(s1[1], drop), project(s2[0], drop), project(s2[1], drop));
+        }
+
+        bool have_intersection_t_p(const Point t[3], Point p) {
+            if (orient3d(t[0], t[1], t[2], p) != 0) {
+                return false;
+            }
+
+            std::int64_t n[3];
+            get_normal(t[0], t[1], t[2], n);
+            int drop = get_dominant_axis(n);
+            Point2d t2d[3] = { project(t[0], drop), project(t[1], drop), project(t[2], drop) };
+            return have_intersection_t_p_2d(t2d, project(p, drop));
+        }
+
+        bool have_intersection_t_s(const Point t[3], const Point s[2]) {
+            std::int64_t o[2] = { orient3d(t[0], t[1], t[2], s[0]), orient3d(t[0], t[1], t[2], s[1]) };
+            if (is_same_strict_sign(o[0], o[1])) {
+                return false;
+            }
+
+            if (o[0] == 0 && o[1] == 0) {
+                std::int64_t n[3];
+                get_normal(t[0], t[1], t[2], n);
+                int drop = get_dominant_axis(n);
+                Point2d t2d[3] = { project(t[0], drop), project(t[1], drop), project(t[2], drop) };
+                Point2d s2d[2] = { project(s[0], drop), project(s[1], drop) };
+                return have_intersection_t_p_2d(t2d, s2d[0])
+                    || have_intersection_s_s_2d(t2d[0], t2d[1], s2d[0], s2d[1])
+                    || have_intersection_s_s_2d(t2d[1], t2d[2], s2d[0], s2d[1])
+                    || have_intersection_s_s_2d(t2d[2], t2d[0], s2d[0], s2d[1]);
+            }
+
+            // the segment crosses the plane, its line has to pass on the same side of every edge
+            std::int64_t e[3] = {
+                orient3d(s[0], s[1], t[0], t[1]),
+                orient3d(s[0], s[1], t[1], t[2]),
+                orient3d(s[0], s[1], t[2], t[0])
+            };
+            return (e[0] >= 0 && e[1] >= 0 && e[2] >= 0) || (e[0] <= 0 && e[1] <= 0 && e[2] <= 0);
+        }
+
+        bool have_intersection_coplanar_t_t(const Point t1[3], const Point t2[3], const std::int64_t n[3]) {
+            int drop = get_dominant_axis(n);
+            Point2d a[3] = { project(t1[0], drop), project(t1[1], drop), project(t1[2], drop) };
+            Point2d b[3] = { project(t2[0], drop), project(t2[1], drop), project(t2[2], drop) };
+
+            for (int i = 0; i < 3; i++) {
+                for (int j = 0; j < 3; j++) {
+                    if (have_intersection_s_s_2d(a[i], a[(i + 1) % 3], b[j], b[(j + 1) % 3])) {
+                        return true;
+                    }
+                }
+            }
+
+            // no edges cross: either one contains the other or they are apart
+            return have_intersection_t_p_2d(a, b[0]) || have_intersection_t_p_2d(b, a[0]);
+        }
+
+        /*
+        Points first, then segments (collinear vertices, the two farthest apart are moved to the front),
+        count is 1, 2 or 3
+        */
+        int classify(Point t[3]) {
+            if (have_intersection_p_p(t[0], t[1]) && have_intersection_p_p(t[0], t[2])) {
+                return 1;
+            }
+
+            std::int64_t n[3];
+            get_normal(t[0], t[1], t[2], n);
+            if (n[0] != 0 || n[1] != 0 || n[2] != 0) {
+                return 3;
+            }
+
+            auto get_squared_length = [] (Point a, Point b) {
+                std::int64_t d[3] = { std::int64_t(b[0]) - a[0], std::int64_t(b[1]) - a[1], std::int64_t(b[2]) - a[2] };
+                return d[0] * d[0] + d[1] * d[1] + d[2] * d[2];
+            };
+
+            std::int64_t l[3] = { get_squared_length(t[0], t[1]), get_squared_length(t[1], t[2]), get_squared_length(t[2], t[0]) };
+            if (l[1] >= l[0] && l[1] >= l[2]) {
+                std::swap(t[0], t[2]);
+            } else if (l[2] >= l[0] && l[2] >= l[1]) {
+                std::swap(t[1], t[2]);
+            }
+            return 2;
+        }
+
+        void rotate(Point t[3], int first) {
+            Point r[3] = { t[first], t[(first + 1) % 3], t[(first + 2) % 3] };
+            t[0] = r[0];
+            t[1] = r[1];
+            t[2] = r[2];
+        }
+    }
+
+    bool have_intersection(const std::int32_t t1[9], const std::int32_t t2[9]) noexcept {
+        Point u1[3] = { t1, t1 + 3, t1 + 6 };
+        Point u2[3] = { t2, t2 + 3, t2 + 6 };
+
+        int kind1 = classify(u1);
+        int kind2 = classify(u2);
+        if (kind1 > kind2) {
+            std::swap(kind1, kind2);
+            std::swap(u1[0], u2[0]);
+            std::swap(u1[1], u2[1]);
+            std::swap(u1[2], u2[2]);
+        }
+
+        if (kind1 == 1) {
+            return kind2 == 1 ? have_intersection_p_p(u1[0], u2[0])
+                 : kind2 == 2 ? have_intersection_s_p(u2, u1[0]) : have_intersection_t_p(u2, u1[0]);
+        }
+
+        if (kind1 == 2) {
+            return kind2 == 2 ? have_intersection_s_s(u1, u2) : have_intersection_t_s(u2, u1);
+        }
+
+        // Devillers and Guigue with exact signs, as in the double kernel
+
+        std::int64_t d1[3] = {
+            orient3d(u2[0], u2[1], u2[2], u1[0]),
+            orient3d(u2[0], u2[1], u2[2], u1[1]),
+            orient3d(u2[0], u2[1], u2[2], u1[2])
+        };
+
+        if (d1[0] == 0 && d1[1] == 0 && d1[2] == 0) {
+            std::int64_t n[3];
+            get_normal(u1[0], u1[1], u1[2], n);
+            return have_intersection_coplanar_t_t(u1, u2, n);
+        }
+
+        if ((d1[0] < 0 && d1[1] < 0 && d1[2] < 0) || (d1[0] > 0 && d1[1] > 0 && d1[2] > 0)) {
+            return false;
+        }
+
+        std::int64_t d2[3] = {
+            orient3d(u1[0], u1[1], u1[2], u2[0]),
+            orient3d(u1[0], u1[1], u1[2], u2[1]),
+            orient3d(u1[0], u1[1], u1[2], u2[2])
+        };
+
+        if ((d2[0] < 0 && d2[1] < 0 && d2[2] < 0) || (d2[0] > 0 && d2[1] > 0 && d2[2] > 0)) {
+            return false;
+        }
+
+        // only the signs matter to get_lone_vertex, they survive the conversion
+        double s1[3] = { double(d1[0]), double(d1[1]), double(d1[2]) };
+        double s2[3] = { double(d2[0]), double(d2[1]), double(d2[2]) };
+        int side1, side2;
+        rotate(u1, get_lone_vertex(s1, side1));
+        rotate(u2, get_lone_vertex(s2, side2));
+        if (side2 > 0) {
+            std::swap(u1[1], u1[2]);
+        }
+        if (side1 > 0) {
+            std::swap(u2[1], u2[2]);
+        }
+
+        return orient3d(u1[0], u1[1], u2[0], u2[1]) >= 0 && orient3d(u1[0], u1[2], u2[2], u2[0]) >= 0;
+    }
+}
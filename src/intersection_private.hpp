@@ -1,30 +1,22 @@
-#include <utility>
-#include "intersection.hpp"
+#pragma once
 
-namespace triangle_intersection {
-    constexpr double EPS = 1e-12;
+#include "detail/kernel.hpp"
 
-    bool have_intersection_t_p(double t[9], double p[3]);
-    bool have_intersection_t_s(double t[9], double s[6]);
-    bool have_intersection_s_s(double s1[6], double s2[6]);
-    bool have_intersection_s_p(double s[6], double p[3]);
-    bool have_intersection_p_p(double p1[3], double p2[3]);
-    bool have_intersection_coplanar_t_t(double t1[9], double t2[9]);
-    
-    double get_determinant_3d(double p1[3], double p2[3], double p3[3], double p4[3]);
-    void reorder_points(double t1[9], double t2[9], double d1[3], double d2[3]);
-    bool is_point(double t[9]);
-    bool is_segment(double t[9]);
-    void cross_product (double v1[3], double v2[3], double cp[3]);
-    double dot_product(double v1[3], double v2[3]);
-    double get_length(double p1[3], double p2[3]);
+namespace triangle_intersection {
+    /*
+    Entry points of the batch kernels. check_degenerate false runs the lanes without the point and segment tests
+    (AssumeNonDegenerate), the fallback lanes of have_intersection_lane too. The *_avx2 and *_avx512 functions process
+    whole vectors and return the number of pairs done, the caller tests the rest
+    */
+    bool have_intersection_lane(const TriangleBatch& t1, const TriangleBatch& t2, std::size_t i, bool check_degenerate = true);
+    std::size_t have_intersection_batch_avx2(const TriangleBatch& t1, const TriangleBatch& t2, std::size_t n, std::uint64_t* mask, bool check_degenerate);
+    std::size_t have_intersection_batch_avx512(const TriangleBatch& t1, const TriangleBatch& t2, std::size_t n, std::uint64_t* mask, bool check_degenerate);
+    bool have_intersection_lane(const FloatTriangleBatch& t1, const FloatTriangleBatch& t2, std::size_t i, bool check_degenerate = true);
+    std::size_t have_intersection_batch_avx2(const FloatTriangleBatch& t1, const FloatTriangleBatch& t2, std::size_t n, std::uint64_t* mask, bool check_degenerate);
+    std::size_t have_intersection_batch_avx512(const FloatTriangleBatch& t1, const FloatTriangleBatch& t2, std::size_t n, std::uint64_t* mask, bool check_degenerate);
 
-    void make_couterclockwise_2d(double t[6]);
-    int get_dominant_axis(double t[9]);
-    void project_t_2d(double t1[9], double t2[6], int drop);
-    void project_p_2d(double p1[3], double p2[2], int drop);
-    bool have_intersection_s_s_2d(double s1[4], double s2[4]);
-    double get_determinant_2d(double p1[2], double p2[2], double p3[2]);
-    bool have_intersection_t_p_2d(double t[6], double p[2]);
-    bool is_same_side(double sp1[2], double sp2[2], double p1[2], double p2[2]);
-}
\ No newline at end of file
+    std::size_t get_degenerate_pairs_avx2(const TriangleBatch& t1, const TriangleBatch& t2, std::size_t n, std::uint64_t* degenerate);
+    std::size_t get_degenerate_pairs_avx512(const TriangleBatch& t1, const TriangleBatch& t2, std::size_t n, std::uint64_t* degenerate);
+    std::size_t get_degenerate_pairs_avx2(const FloatTriangleBatch& t1, const FloatTriangleBatch& t2, std::size_t n, std::uint64_t* degenerate);
+    std::size_t get_degenerate_pairs_avx512(const FloatTriangleBatch& t1, const FloatTriangleBatch& t2, std::size_t n, std::uint64_t* degenerate);
+}
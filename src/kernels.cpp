@@ -0,0 +1,265 @@
+#include <algorithm>
+#include <chrono>
+#include "intersection_private.hpp"
+#include "kernels.hpp"
+
+namespace triangle_intersection {
+    namespace {
+        enum class Decision {
+            No,
+            Yes,
+            Undecided // within the error bounds, left to Devillers-Guigue
+        };
+
+        // plane of a triangle and the error bound of its evaluations, as in PreparedTriangle
+        struct Plane {
+            double normal[3];
+            double offset;
+            double normal_magnitude[3];
+            double offset_magnitude;
+
+            explicit Plane(const double t[9]) {
+                double edge1[3] = { t[3] - t[0], t[4] - t[1], t[5] - t[2] };
+                double edge2[3] = { t[6] - t[0], t[7] - t[1], t[8] - t[2] };
+                cross_product(edge1, edge2, normal);
+                offset = dot_product(normal, t);
+
+                normal_magnitude[0] = std::abs(edge1[1] * edge2[2]) + std::abs(edge1[2] * edge2[1]);
+                normal_magnitude[1] = std::abs(edge1[2] * edge2[0]) + std::abs(edge1[0] * edge2[2]);
+                normal_magnitude[2] = std::abs(edge1[0] * edge2[1]) + std::abs(edge1[1] * edge2[0]);
+                offset_magnitude = normal_magnitude[0] * std::abs(t[0]) + normal_magnitude[1] * std::abs(t[1])
+                                 + normal_magnitude[2] * std::abs(t[2]);
+            }
+
+            // orient3d of the triangle and x up to rounding, error bounds the difference
+            double get_distance(const double x[3], double& error) const {
+                error = PLANE_ERROR_BOUND * (offset_magnitude + normal_magnitude[0] * std::abs(x[0])
+                                             + normal_magnitude[1] * std::abs(x[1]) + normal_magnitude[2] * std::abs(x[2]));
+                return offset - dot_product(normal, x);
+            }
+        };
+
+        // Yes when t straddles the plane, No when it lies on one side
+        Decision classify(const Plane& plane, const double t[9], double d[3], double error[3]) {
+            for (int i = 0; i < 3; i++) {
+                d[i] = plane.get_distance(t + 3 * i, error[i]);
+                if (std::abs(d[i]) <= error[i]) {
+                    return Decision::Undecided;
+                }
+            }
+            if ((d[0] > 0) == (d[1] > 0) && (d[0] > 0) == (d[2] > 0)) {
+                return Decision::No;
+            }
+            return Decision::Yes;
+        }
+
+        /*
+        Coordinate k of the points where the edges from the lone vertex of t cross the plane
+        the distances d were measured against, and the error bound of both
+        */
+        void get_interval(const double t[9], const double d[3], const double error[3], int k, double& min, double& max, double& tolerance) {
+            int lone = (d[0] > 0) == (d[1] > 0) ? 2 : (d[0] > 0) == (d[2] > 0) ? 1 : 0;
+            double x[2];
+            tolerance = 0;
+            for (int i = 0, n = 0; i < 3; i++) {
+                if (i == lone) {
+                    continue;
+                }
+                double a = t[3 * lone + k], b = t[3 * i + k];
+                double denominator = std::abs(d[i] - d[lone]);
+                x[n++] = b + (a - b) * (d[i] / (d[i] - d[lone]));
+                double ratio_error = 4 * (error[i] + error[lone]) / denominator + 4 * DBL_EPSILON;
+                tolerance = std::max(tolerance, std::abs(a - b) * ratio_error + 4 * DBL_EPSILON * (std::abs(a) + std::abs(b)));
+            }
+            min = std::min(x[0], x[1]);
+            max = std::max(x[0], x[1]);
+        }
+
+        // the triangles Devillers-Guigue takes for points or segments, by its own tolerances
+        bool is_degenerate(const double t[9]) {
+            const double* v[3] = { t, t + 3, t + 6 };
+            return is_point(v) || is_segment(v);
+        }
+
+        Decision decide_moller(const double t1[9], const double t2[9]) {
+            if (is_degenerate(t1) || is_degenerate(t2)) {
+                return Decision::Undecided;
+            }
+
+            double d1[3], e1[3], d2[3], e2[3];
+            Plane p2(t2);
+            Decision side = classify(p2, t1, d1, e1);
+            if (side != Decision::Yes) {
+                return side;
+            }
+            Plane p1(t1);
+            side = classify(p1, t2, d2, e2);
+            if (side != Decision::Yes) {
+                return side;
+            }
+
+            // both triangles cross the line where the planes meet, compared along its largest coordinate
+
+            double line[3];
+            cross_product(p1.normal, p2.normal, line);
+            int k = std::abs(line[0]) > std::abs(line[1]) ? (std::abs(line[0]) > std::abs(line[2]) ? 0 : 2)
+                                                          : (std::abs(line[1]) > std::abs(line[2]) ? 1 : 2);
+
+            double min1, max1, tolerance1, min2, max2, tolerance2;
+            get_interval(t1, d1, e1, k, min1, max1, tolerance1);
+            get_interval(t2, d2, e2, k, min2, max2, tolerance2);
+            double tolerance = tolerance1 + tolerance2;
+
+            if (max1 < min2 - tolerance || max2 < min1 - tolerance) {
+                return Decision::No;
+            }
+            if (max1 > min2 + tolerance && max2 > min1 + tolerance) {
+                return Decision::Yes;
+            }
+            return Decision::Undecided;
+        }
+
+        double get_norm_1(const double v[3]) {
+            return std::abs(v[0]) + std::abs(v[1]) + std::abs(v[2]);
+        }
+
+        Decision decide_separating_axis(const double t1[9], const double t2[9]) {
+            if (is_degenerate(t1) || is_degenerate(t2)) {
+                return Decision::Undecided;
+            }
+
+            double d[3], e[3];
+            Decision side = classify(Plane(t2), t1, d, e);
+            if (side != Decision::Yes) {
+                return side;
+            }
+            side = classify(Plane(t1), t2, d, e);
+            if (side != Decision::Yes) {
+                return side;
+            }
+
+            /*
+            Neither normal separates, only an edge cross product can. The tolerance covers the rounding
+            of the projections and the turn of the computed axis away from the exact cross product
+            */
+
+            double radius = 0;
+            for (int i = 0; i < 3; i++) {
+                radius = std::max(radius, std::max(get_norm_1(t1 + 3 * i), get_norm_1(t2 + 3 * i)));
+            }
+
+            bool overlap = true;
+            for (int i = 0; i < 3; i++) {
+                double edge1[3];
+                for (int c = 0; c < 3; c++) {
+                    edge1[c] = t1[(i + 1) % 3 * 3 + c] - t1[i * 3 + c];
+                }
+                for (int j = 0; j < 3; j++) {
+                    double edge2[3], axis[3];
+                    for (int c = 0; c < 3; c++) {
+                        edge2[c] = t2[(j + 1) % 3 * 3 + c] - t2[j * 3 + c];
+                    }
+                    cross_product(edge1, edge2, axis);
+
+                    double p1[3] = { dot_product(axis, t1), dot_product(axis, t1 + 3), dot_product(axis, t1 + 6) };
+                    double p2[3] = { dot_product(axis, t2), dot_product(axis, t2 + 3), dot_product(axis, t2 + 6) };
+                    double min1 = std::min({ p1[0], p1[1], p1[2] }), max1 = std::max({ p1[0], p1[1], p1[2] });
+                    double min2 = std::min({ p2[0], p2[1], p2[2] }), max2 = std::max({ p2[0], p2[1], p2[2] });
+                    double tolerance = 16 * DBL_EPSILON * get_norm_1(edge1) * get_norm_1(edge2) * radius;
+
+                    if (max1 < min2 - tolerance || max2 < min1 - tolerance) {
+                        return Decision::No;
+                    }
+                    overlap = overlap && max1 > min2 + tolerance && max2 > min1 + tolerance;
+                }
+            }
+
+            return overlap ? Decision::Yes : Decision::Undecided;
+        }
+
+        bool have_intersection_devillers_guigue(const double t1[9], const double t2[9]) {
+            const double* v1[3] = { t1, t1 + 3, t1 + 6 };
+            const double* v2[3] = { t2, t2 + 3, t2 + 6 };
+            return have_intersection(v1, v2);
+        }
+
+        bool have_intersection_moller(const double t1[9], const double t2[9]) {
+            Decision decision = decide_moller(t1, t2);
+            return decision == Decision::Undecided ? have_intersection_devillers_guigue(t1, t2) : decision == Decision::Yes;
+        }
+
+        bool have_intersection_separating_axis(const double t1[9], const double t2[9]) {
+            Decision decision = decide_separating_axis(t1, t2);
+            return decision == Decision::Undecided ? have_intersection_devillers_guigue(t1, t2) : decision == Decision::Yes;
+        }
+
+        const KernelFunction KERNELS[KERNEL_COUNT] = {
+            have_intersection_devillers_guigue,
+            have_intersection_moller,
+            have_intersection_separating_axis
+        };
+
+        const char* const KERNEL_NAMES[KERNEL_COUNT] = {
+            "devillers-guigue",
+            "moller",
+            "separating-axis"
+        };
+    }
+
+    KernelFunction get_kernel(Kernel kernel) noexcept {
+        return KERNELS[static_cast<std::size_t>(kernel)];
+    }
+
+    const char* get_kernel_name(Kernel kernel) noexcept {
+        return KERNEL_NAMES[static_cast<std::size_t>(kernel)];
+    }
+
+    bool have_intersection(const double t1[9], const double t2[9], Kernel kernel) noexcept {
+        return get_kernel(kernel)(t1, t2);
+    }
+
+    Kernel autotune(const double* t1, const double* t2, std::size_t n, const AutotuneOptions& options) {
+        if (options.sample_size == 0 || n < options.sample_size) {
+            return Kernel::DevillersGuigue;
+        }
+
+        // the kernels take turns within every round, so that none of them always runs on a cold cache
+
+        std::size_t stride = n / options.sample_size;
+        double best[KERNEL_COUNT];
+        std::fill(best, best + KERNEL_COUNT, -1.0);
+        std::size_t hits = 0;
+        for (int round = 0; round < std::max(options.rounds, 1); round++) {
+            for (std::size_t k = 0; k < KERNEL_COUNT; k++) {
+                KernelFunction kernel = KERNELS[k];
+                auto start = std::chrono::steady_clock::now();
+                for (std::size_t i = 0; i < options.sample_size; i++) {
+                    std::size_t pair = i * stride;
+                    hits += kernel(t1 + pair * 9, t2 + pair * 9);
+                }
+                double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+                if (best[k] < 0 || elapsed < best[k]) {
+                    best[k] = elapsed;
+                }
+            }
+        }
+
+        static_cast<void>(hits);
+        return static_cast<Kernel>(std::min_element(best, best + KERNEL_COUNT) - best);
+    }
+
+    Kernel have_intersection_autotuned(const double* t1, const double* t2, std::size_t n, std::uint64_t* mask, const AutotuneOptions& options) {
+        for (std::size_t i = 0; i < (n + 63) / 64; i++) {
+            mask[i] = 0;
+        }
+
+        Kernel kernel = n < 8 * options.sample_size ? Kernel::DevillersGuigue : autotune(t1, t2, n, options);
+        KernelFunction test = get_kernel(kernel);
+        for (std::size_t i = 0; i < n; i++) {
+            if (test(t1 + i * 9, t2 + i * 9)) {
+                mask[i / 64] |= std::uint64_t(1) << (i % 64);
+            }
+        }
+        return kernel;
+    }
+}
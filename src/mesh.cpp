@@ -0,0 +1,272 @@
+#include <algorithm>
+#include <atomic>
+#include "narrow_phase.hpp"
+#include "scheduler.hpp"
+
+namespace triangle_intersection {
+    PairTester::PairTester() : coords_(CHUNK_SIZE * 18) {
+        candidates_.reserve(CHUNK_SIZE);
+        hits_.reserve(CHUNK_SIZE);
+    }
+
+    PairTester::PairTester(const double* triangles1, const double* triangles2, PairSink* sink, unsigned worker) : PairTester() {
+        reset(triangles1, triangles2, sink, worker);
+    }
+
+    void PairTester::reset(const double* triangles1, const double* triangles2, PairSink* sink, unsigned worker) {
+        triangles1_ = triangles1;
+        triangles2_ = triangles2;
+        sink_ = sink;
+        worker_ = worker;
+        hit_count_ = 0;
+        candidates_.clear();
+    }
+
+    void PairTester::flush() {
+        std::size_t n = candidates_.size();
+        TriangleBatch b1, b2;
+        for (int k = 0; k < 9; k++) {
+            b1.coords[k] = coords_.data() + k * CHUNK_SIZE;
+            b2.coords[k] = coords_.data() + (k + 9) * CHUNK_SIZE;
+        }
+
+        for (std::size_t i = 0; i < n; i++) {
+            const double* t1 = triangles1_ + std::size_t(candidates_[i].first) * 9;
+            const double* t2 = triangles2_ + std::size_t(candidates_[i].second) * 9;
+            for (int k = 0; k < 9; k++) {
+                coords_[k * CHUNK_SIZE + i] = t1[k];
+                coords_[(k + 9) * CHUNK_SIZE + i] = t2[k];
+            }
+        }
+
+        std::uint64_t mask[CHUNK_SIZE / 64];
+        have_intersection_batch(b1, b2, n, mask);
+
+        hits_.clear();
+        for (std::size_t i = 0; i < n; i++) {
+            if ((mask[i / 64] >> (i % 64)) & 1) {
+                hits_.push_back(candidates_[i]);
+            }
+        }
+
+        hit_count_ += hits_.size();
+        candidates_.clear();
+        if (sink_ && !hits_.empty()) {
+            sink_->put(hits_.data(), hits_.size(), worker_);
+        }
+    }
+
+    namespace {
+        constexpr int SPLIT_DEPTH = 12;
+        constexpr std::size_t PAIRS_PER_TASK = 4096;
+
+        using NodePair = QueryArena::Scratch::NodePair;
+
+        /*
+        Depth-first from task on the stack of scratch, the candidates go to its tester. push(child) may hand
+        a child close to the roots over to the scheduler, the others are traversed in place
+        */
+        template <class Push>
+        void descend(const Bvh& mesh1, const Bvh& mesh2, NodePair task, QueryArena::Scratch& scratch, std::atomic<bool>* stop, Push push) {
+            const std::vector<Bvh::Node>& nodes1 = mesh1.nodes();
+            const std::vector<Bvh::Node>& nodes2 = mesh2.nodes();
+            PairTester& tester = scratch.tester;
+            std::vector<NodePair>& stack = scratch.stack;
+            stack.clear();
+            stack.push_back(task);
+
+            while (!stack.empty()) {
+                if (stop && stop->load(std::memory_order_relaxed)) {
+                    stack.clear();
+                    return;
+                }
+
+                NodePair pair = stack.back();
+                stack.pop_back();
+
+                const Bvh::Node& n1 = nodes1[pair.node1];
+                const Bvh::Node& n2 = nodes2[pair.node2];
+                if (!have_overlap(n1.box, n2.box)) {
+                    continue;
+                }
+
+                if (n1.is_leaf() && n2.is_leaf()) {
+                    for (std::uint32_t i = n1.first; i < n1.first + n1.count; i++) {
+                        std::uint32_t t1 = mesh1.indices()[i];
+                        for (std::uint32_t j = n2.first; j < n2.first + n2.count; j++) {
+                            std::uint32_t t2 = mesh2.indices()[j];
+                            if (have_overlap(mesh1.get_triangle_box(t1), mesh2.get_triangle_box(t2))) {
+                                tester.add(t1, t2);
+                                if (stop && tester.get_hit_count() != 0) {
+                                    stop->store(true, std::memory_order_relaxed);
+                                }
+                            }
+                        }
+                    }
+                    continue;
+                }
+
+                NodePair children[2];
+                if (split_first(n1, n2)) {
+                    children[0] = { n1.first, pair.node2, pair.depth + 1 };
+                    children[1] = { n1.first + 1, pair.node2, pair.depth + 1 };
+                } else {
+                    children[0] = { pair.node1, n2.first, pair.depth + 1 };
+                    children[1] = { pair.node1, n2.first + 1, pair.depth + 1 };
+                }
+
+                for (const NodePair& child : children) {
+                    if (pair.depth >= SPLIT_DEPTH || !push(child)) {
+                        stack.push_back(child);
+                    }
+                }
+            }
+        }
+
+        /*
+        Dual traversal of two non-empty hierarchies on threads threads, the candidates go to the testers of the scratch
+        of the arena, already reset. With stop, stop is set by the first hit and every worker gives up as soon as it sees it.
+        One thread traverses on the calling thread without a scheduler
+        */
+        void traverse(const Bvh& mesh1, const Bvh& mesh2, QueryArena& arena, unsigned threads, std::atomic<bool>* stop) {
+            if (threads == 1) {
+                descend(mesh1, mesh2, { 0, 0, 0 }, arena.get_scratch(0), stop, [] (const NodePair&) { return false; });
+            } else {
+                WorkStealingScheduler<NodePair> scheduler(threads);
+                scheduler.push(0, { 0, 0, 0 });
+                scheduler.run([&] (const NodePair& task, unsigned worker) {
+                    descend(mesh1, mesh2, task, arena.get_scratch(worker), stop, [&] (const NodePair& child) {
+                        scheduler.push(worker, child);
+                        return true;
+                    });
+                });
+            }
+
+            for (unsigned w = 0; w < threads; w++) {
+                if (stop && stop->load(std::memory_order_relaxed)) {
+                    return;
+                }
+                PairTester& tester = arena.get_scratch(w).tester;
+                tester.flush();
+                if (stop && tester.get_hit_count() != 0) {
+                    stop->store(true, std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // the testers of the first threads workers of arena, the scratch is created here before any thread starts
+        void reset_testers(QueryArena& arena, unsigned threads, const double* triangles1, const double* triangles2, PairSink* sink) {
+            for (unsigned w = 0; w < threads; w++) {
+                arena.get_scratch(w).tester.reset(triangles1, triangles2, sink, w);
+            }
+        }
+    }
+
+    std::vector<TrianglePair> intersect_meshes(const Bvh& mesh1, const Bvh& mesh2) {
+        return intersect_meshes(mesh1, mesh2, ParallelOptions { 1 });
+    }
+
+    std::vector<TrianglePair> intersect_meshes(const Bvh& mesh1, const Bvh& mesh2, const ParallelOptions& options) {
+        VectorSink sink;
+        QueryArena arena;
+        intersect_meshes(mesh1, mesh2, sink, arena, options);
+        return sink.get_sorted();
+    }
+
+    void intersect_meshes(const Bvh& mesh1, const Bvh& mesh2, PairSink& sink, QueryArena& arena) {
+        intersect_meshes(mesh1, mesh2, sink, arena, ParallelOptions { 1 });
+    }
+
+    void intersect_meshes(const Bvh& mesh1, const Bvh& mesh2, PairSink& sink, QueryArena& arena, const ParallelOptions& options) {
+        unsigned threads = get_thread_count(options.max_threads);
+        SinkSession session(sink, threads);
+        if (mesh1.size() == 0 || mesh2.size() == 0) {
+            return;
+        }
+
+        reset_testers(arena, threads, mesh1.triangles(), mesh2.triangles(), &sink);
+        traverse(mesh1, mesh2, arena, threads, nullptr);
+    }
+
+    bool have_intersection(const Bvh& mesh1, const Bvh& mesh2) {
+        return have_intersection(mesh1, mesh2, ParallelOptions { 1 });
+    }
+
+    bool have_intersection(const Bvh& mesh1, const Bvh& mesh2, const ParallelOptions& options) {
+        if (mesh1.size() == 0 || mesh2.size() == 0) {
+            return false;
+        }
+
+        unsigned threads = get_thread_count(options.max_threads);
+        QueryArena arena;
+        reset_testers(arena, threads, mesh1.triangles(), mesh2.triangles(), nullptr);
+        std::atomic<bool> stop { false };
+        traverse(mesh1, mesh2, arena, threads, &stop);
+        return stop.load();
+    }
+
+    std::size_t count_intersections(const Bvh& mesh1, const Bvh& mesh2) {
+        return count_intersections(mesh1, mesh2, ParallelOptions { 1 });
+    }
+
+    std::size_t count_intersections(const Bvh& mesh1, const Bvh& mesh2, const ParallelOptions& options) {
+        if (mesh1.size() == 0 || mesh2.size() == 0) {
+            return 0;
+        }
+
+        unsigned threads = get_thread_count(options.max_threads);
+        QueryArena arena;
+        reset_testers(arena, threads, mesh1.triangles(), mesh2.triangles(), nullptr);
+        traverse(mesh1, mesh2, arena, threads, nullptr);
+        std::size_t count = 0;
+        for (unsigned w = 0; w < threads; w++) {
+            count += arena.get_scratch(w).tester.get_hit_count();
+        }
+        return count;
+    }
+
+    std::vector<TrianglePair> intersect_pairs(const double* triangles1, const double* triangles2,
+                                              const std::vector<TrianglePair>& candidates, const ParallelOptions& options) {
+        VectorSink sink;
+        QueryArena arena;
+        intersect_pairs(triangles1, triangles2, candidates.data(), candidates.size(), sink, arena, options);
+        return sink.get_sorted();
+    }
+
+    void intersect_pairs(const double* triangles1, const double* triangles2, const TrianglePair* candidates, std::size_t count,
+                         PairSink& sink, QueryArena& arena, const ParallelOptions& options) {
+        unsigned threads = get_thread_count(options.max_threads);
+        SinkSession session(sink, threads);
+        reset_testers(arena, threads, triangles1, triangles2, &sink);
+
+        auto test = [&] (std::size_t first, std::size_t last, unsigned worker) {
+            PairTester& tester = arena.get_scratch(worker).tester;
+            for (std::size_t i = first; i < last; i++) {
+                tester.add(candidates[i].first, candidates[i].second);
+            }
+        };
+
+        if (threads == 1) {
+            test(0, count, 0);
+        } else {
+            // a task is the first candidate of a block of PAIRS_PER_TASK
+            WorkStealingScheduler<std::size_t> scheduler(threads);
+            std::size_t task_count = (count + PAIRS_PER_TASK - 1) / PAIRS_PER_TASK;
+            for (std::size_t t = 0; t < task_count; t++) {
+                scheduler.push(static_cast<unsigned>(t * threads / task_count), t * PAIRS_PER_TASK);
+            }
+
+            scheduler.run([&] (std::size_t first, unsigned worker) {
+                test(first, std::min(first + PAIRS_PER_TASK, count), worker);
+            });
+        }
+
+        for (unsigned w = 0; w < threads; w++) {
+            arena.get_scratch(w).tester.flush();
+        }
+    }
+
+    std::vector<TrianglePair> intersect_meshes(const double* mesh1, std::size_t count1, const double* mesh2, std::size_t count2) {
+        return intersect_meshes(Bvh(mesh1, count1), Bvh(mesh2, count2));
+    }
+}
@@ -0,0 +1,479 @@
+#include <array>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include "mesh_io.hpp"
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace triangle_intersection {
+    namespace {
+        constexpr std::size_t STL_HEADER_SIZE = 84;  // 80 bytes of text, the triangle count
+        constexpr std::size_t STL_RECORD_SIZE = 50;  // normal, three vertices, attribute bytes
+        constexpr std::size_t STL_VERTEX_OFFSET = 12;
+
+        bool is_little_endian() {
+            const std::uint16_t one = 1;
+            unsigned char first;
+            std::memcpy(&first, &one, 1);
+            return first == 1;
+        }
+
+        // the bytes of a field in host order
+        void load_field(const unsigned char* p, int size, bool swap_bytes, unsigned char* out) {
+            for (int i = 0; i < size; i++) {
+                out[i] = p[swap_bytes ? size - 1 - i : i];
+            }
+        }
+
+        int get_type_size(const std::string& type) {
+            if (type == "char" || type == "uchar" || type == "int8" || type == "uint8") {
+                return 1;
+            }
+            if (type == "short" || type == "ushort" || type == "int16" || type == "uint16") {
+                return 2;
+            }
+            if (type == "int" || type == "uint" || type == "int32" || type == "uint32" || type == "float" || type == "float32") {
+                return 4;
+            }
+            if (type == "double" || type == "float64") {
+                return 8;
+            }
+            throw std::runtime_error("unknown PLY property type " + type);
+        }
+
+        struct PlyProperty {
+            std::string name;
+            std::string type;
+            std::string count_type; // list properties only
+        };
+
+        struct PlyElement {
+            std::string name;
+            std::size_t count;
+            std::vector<PlyProperty> properties;
+        };
+    }
+
+    MappedMesh::MappedMesh(const std::string& path) {
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+        if (file == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error("cannot open " + path);
+        }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size)) {
+            CloseHandle(file);
+            throw std::runtime_error("cannot read the size of " + path);
+        }
+        size_ = static_cast<std::size_t>(size.QuadPart);
+        if (size_ != 0) {
+            HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (mapping != nullptr) {
+                data_ = static_cast<const unsigned char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+            }
+            if (data_ == nullptr) {
+                if (mapping != nullptr) {
+                    CloseHandle(mapping);
+                }
+                CloseHandle(file);
+                throw std::runtime_error("cannot map " + path);
+            }
+            handle_ = mapping;
+        }
+        CloseHandle(file);
+#else
+        int file = open(path.c_str(), O_RDONLY);
+        if (file < 0) {
+            throw std::runtime_error("cannot open " + path);
+        }
+        struct stat status;
+        if (fstat(file, &status) != 0) {
+            close(file);
+            throw std::runtime_error("cannot read the size of " + path);
+        }
+        size_ = static_cast<std::size_t>(status.st_size);
+        if (size_ != 0) {
+            void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file, 0);
+            if (data == MAP_FAILED) {
+                close(file);
+                throw std::runtime_error("cannot map " + path);
+            }
+            data_ = static_cast<const unsigned char*>(data);
+        }
+        // the mapping keeps the file alive
+        close(file);
+#endif
+
+        try {
+            if (size_ >= 4 && std::memcmp(data_, "ply", 3) == 0 && (data_[3] == '\n' || data_[3] == '\r')) {
+                format_ = MeshFormat::Ply;
+                parse_ply();
+            } else {
+                format_ = MeshFormat::Stl;
+                parse_stl();
+            }
+        } catch (...) {
+            unmap();
+            throw;
+        }
+    }
+
+    MappedMesh::MappedMesh(MappedMesh&& other) noexcept {
+        *this = std::move(other);
+    }
+
+    MappedMesh& MappedMesh::operator=(MappedMesh&& other) noexcept {
+        if (this != &other) {
+            unmap();
+            data_ = other.data_;
+            size_ = other.size_;
+            handle_ = other.handle_;
+            format_ = other.format_;
+            swap_bytes_ = other.swap_bytes_;
+            triangle_count_ = other.triangle_count_;
+            vertex_count_ = other.vertex_count_;
+            vertices_ = other.vertices_;
+            faces_ = other.faces_;
+            other.data_ = nullptr;
+            other.size_ = 0;
+            other.handle_ = nullptr;
+            other.triangle_count_ = 0;
+            other.vertex_count_ = 0;
+        }
+        return *this;
+    }
+
+    MappedMesh::~MappedMesh() {
+        unmap();
+    }
+
+    void MappedMesh::unmap() noexcept {
+        if (data_ == nullptr) {
+            return;
+        }
+#ifdef _WIN32
+        UnmapViewOfFile(data_);
+        CloseHandle(static_cast<HANDLE>(handle_));
+#else
+        munmap(const_cast<unsigned char*>(data_), size_);
+#endif
+        data_ = nullptr;
+        handle_ = nullptr;
+    }
+
+    void MappedMesh::parse_stl() {
+
+        // binary only: the size must match the triangle count, ASCII files never do
+
+        if (size_ < STL_HEADER_SIZE) {
+            throw std::runtime_error("not a binary STL or PLY file");
+        }
+
+        std::uint32_t count;
+        std::memcpy(&count, data_ + 80, 4);
+        swap_bytes_ = !is_little_endian();
+        if (swap_bytes_) {
+            unsigned char bytes[4];
+            load_field(data_ + 80, 4, true, bytes);
+            std::memcpy(&count, bytes, 4);
+        }
+
+        if (size_ != STL_HEADER_SIZE + std::size_t(count) * STL_RECORD_SIZE) {
+            throw std::runtime_error("not a binary STL or PLY file");
+        }
+        if (count > UINT32_MAX / 3) {
+            // the vertices of an STL file are numbered 3i to 3i + 2
+            throw std::runtime_error("too many triangles");
+        }
+
+        triangle_count_ = count;
+        vertex_count_ = std::size_t(count) * 3;
+        vertices_ = { STL_HEADER_SIZE + STL_VERTEX_OFFSET, STL_RECORD_SIZE, { 0, 4, 8 }, 4 };
+    }
+
+    void MappedMesh::parse_ply() {
+        const char* text = reinterpret_cast<const char*>(data_);
+        const char* end_marker = "end_header";
+        std::size_t header_end = 0;
+        for (std::size_t i = 0; i + 10 <= size_; i++) {
+            if (std::memcmp(text + i, end_marker, 10) == 0 && (i == 0 || text[i - 1] == '\n')) {
+                header_end = i + 10;
+                break;
+            }
+        }
+        if (header_end == 0) {
+            throw std::runtime_error("PLY header without end_header");
+        }
+        if (header_end < size_ && text[header_end] == '\r') {
+            header_end++;
+        }
+        if (header_end >= size_ || text[header_end] != '\n') {
+            throw std::runtime_error("PLY header without end_header");
+        }
+        header_end++;
+
+        std::istringstream header(std::string(text, header_end));
+        std::vector<PlyElement> elements;
+        std::string line;
+        bool is_binary = false;
+        while (std::getline(header, line)) {
+            std::istringstream words(line);
+            std::string keyword;
+            words >> keyword;
+            if (keyword == "format") {
+                std::string format;
+                words >> format;
+                if (format == "binary_little_endian") {
+                    swap_bytes_ = !is_little_endian();
+                } else if (format == "binary_big_endian") {
+                    swap_bytes_ = is_little_endian();
+                } else {
+                    throw std::runtime_error("only binary PLY files are supported");
+                }
+                is_binary = true;
+            } else if (keyword == "element") {
+                PlyElement e;
+                words >> e.name >> e.count;
+                elements.push_back(e);
+            } else if (keyword == "property") {
+                if (elements.empty()) {
+                    throw std::runtime_error("PLY property outside of an element");
+                }
+                PlyProperty p;
+                words >> p.type;
+                if (p.type == "list") {
+                    words >> p.count_type >> p.type;
+                }
+                words >> p.name;
+                elements.back().properties.push_back(p);
+            }
+        }
+        if (!is_binary) {
+            throw std::runtime_error("only binary PLY files are supported");
+        }
+
+        // every element the faces need to skip has fixed size records: scalar properties only, triangle lists
+
+        std::size_t offset = header_end;
+        std::size_t count_offset = 0; // the length of the face lists
+        int count_size = 0;
+        bool has_vertices = false, has_faces = false;
+        for (const PlyElement& e : elements) {
+            Layout layout {};
+            layout.offset = offset;
+            int found = 0;
+            for (const PlyProperty& p : e.properties) {
+                int size = get_type_size(p.type);
+                if (!p.count_type.empty()) {
+                    if (e.name != "face" || (p.name != "vertex_indices" && p.name != "vertex_index")) {
+                        throw std::runtime_error("unsupported PLY list property " + p.name);
+                    }
+                    count_offset = layout.stride;
+                    count_size = get_type_size(p.count_type);
+                    layout.stride += count_size;
+                    layout.fields[0] = layout.stride;
+                    layout.fields[1] = layout.stride + size;
+                    layout.fields[2] = layout.stride + 2 * size;
+                    layout.size = size;
+                    layout.stride += 3 * size;
+                    found = 3;
+                    continue;
+                }
+                if (e.name == "vertex" && (p.name == "x" || p.name == "y" || p.name == "z")) {
+                    if (size != 4 && size != 8) {
+                        throw std::runtime_error("PLY vertex coordinates must be float or double");
+                    }
+                    if (found != 0 && size != layout.size) {
+                        throw std::runtime_error("PLY vertex coordinates of mixed types");
+                    }
+                    layout.fields[p.name[0] - 'x'] = layout.stride;
+                    layout.size = size;
+                    found++;
+                }
+                layout.stride += size;
+            }
+
+            if (e.name == "vertex") {
+                if (found != 3) {
+                    throw std::runtime_error("PLY vertices without x, y, z");
+                }
+                vertices_ = layout;
+                vertex_count_ = e.count;
+                has_vertices = true;
+            } else if (e.name == "face") {
+                if (found != 3) {
+                    throw std::runtime_error("PLY faces without vertex indices");
+                }
+                if (e.count > UINT32_MAX) {
+                    throw std::runtime_error("too many triangles");
+                }
+                faces_ = layout;
+                triangle_count_ = e.count;
+                has_faces = true;
+            }
+
+            if (e.count != 0 && layout.stride > (size_ - offset) / e.count) {
+                throw std::runtime_error("PLY file shorter than its header says");
+            }
+            offset += e.count * layout.stride;
+        }
+
+        if (!has_vertices || !has_faces) {
+            throw std::runtime_error("PLY file without vertices or faces");
+        }
+
+        // a face list of another length would shift every record after it
+        for (std::size_t i = 0; i < triangle_count_; i++) {
+            const unsigned char* p = data_ + faces_.offset + i * faces_.stride + count_offset;
+            std::uint64_t count = 0;
+            for (int b = 0; b < count_size; b++) {
+                count |= std::uint64_t(p[swap_bytes_ ? count_size - 1 - b : b]) << (8 * b);
+            }
+            if (count != 3) {
+                throw std::runtime_error("only triangle faces are supported");
+            }
+        }
+
+        for (std::size_t i = 0; i < triangle_count_; i++) {
+            std::uint32_t indices[3];
+            get_indices(i, indices);
+            if (indices[0] >= vertex_count_ || indices[1] >= vertex_count_ || indices[2] >= vertex_count_) {
+                throw std::runtime_error("PLY face with a vertex index out of range");
+            }
+        }
+    }
+
+    double MappedMesh::read_coordinate(const unsigned char* p) const noexcept {
+        unsigned char bytes[8];
+        load_field(p, vertices_.size, swap_bytes_, bytes);
+        if (vertices_.size == 4) {
+            float f;
+            std::memcpy(&f, bytes, 4);
+            return f;
+        }
+        double d;
+        std::memcpy(&d, bytes, 8);
+        return d;
+    }
+
+    std::uint32_t MappedMesh::read_index(const unsigned char* p) const noexcept {
+        std::uint64_t index = 0;
+        for (int b = 0; b < faces_.size; b++) {
+            index |= std::uint64_t(p[swap_bytes_ ? faces_.size - 1 - b : b]) << (8 * b);
+        }
+        return static_cast<std::uint32_t>(index);
+    }
+
+    void MappedMesh::get_vertex(std::size_t i, double v[3]) const noexcept {
+        const unsigned char* record = format_ == MeshFormat::Stl
+            ? data_ + vertices_.offset + (i / 3) * vertices_.stride + (i % 3) * 12
+            : data_ + vertices_.offset + i * vertices_.stride;
+        for (int c = 0; c < 3; c++) {
+            v[c] = read_coordinate(record + vertices_.fields[c]);
+        }
+    }
+
+    void MappedMesh::get_indices(std::size_t i, std::uint32_t indices[3]) const noexcept {
+        if (format_ == MeshFormat::Stl) {
+            for (int k = 0; k < 3; k++) {
+                indices[k] = static_cast<std::uint32_t>(i * 3 + k);
+            }
+            return;
+        }
+
+        const unsigned char* record = data_ + faces_.offset + i * faces_.stride;
+        for (int k = 0; k < 3; k++) {
+            indices[k] = read_index(record + faces_.fields[k]);
+        }
+    }
+
+    void MappedMesh::get_triangle(std::size_t i, double t[9]) const noexcept {
+        std::uint32_t indices[3];
+        get_indices(i, indices);
+        for (int k = 0; k < 3; k++) {
+            get_vertex(indices[k], t + 3 * k);
+        }
+    }
+
+    void MappedMesh::get_triangles(std::size_t first, std::size_t count, double* out) const noexcept {
+        for (std::size_t i = 0; i < count; i++) {
+            get_triangle(first + i, out + i * 9);
+        }
+    }
+
+    bool MappedMesh::get_vertex_view(VertexView& view) const noexcept {
+        const unsigned char* x = data_ + vertices_.offset + vertices_.fields[0];
+        if (format_ != MeshFormat::Ply || swap_bytes_ || vertices_.size != 8
+            || vertices_.fields[1] != vertices_.fields[0] + 8 || vertices_.fields[2] != vertices_.fields[0] + 16
+            || vertices_.stride % 8 != 0 || reinterpret_cast<std::uintptr_t>(x) % alignof(double) != 0) {
+            return false;
+        }
+
+        view.data = reinterpret_cast<const double*>(x);
+        view.stride = vertices_.stride / 8;
+        return true;
+    }
+
+    std::vector<double> load_triangles(const MappedMesh& mesh) {
+        std::vector<double> triangles(mesh.triangle_count() * 9);
+        mesh.get_triangles(0, mesh.triangle_count(), triangles.data());
+        return triangles;
+    }
+
+    void load_indexed_mesh(const MappedMesh& mesh, std::vector<double>& vertices, std::vector<std::uint32_t>& indices) {
+        vertices.clear();
+        indices.resize(mesh.triangle_count() * 3);
+
+        if (mesh.format() == MeshFormat::Ply) {
+            vertices.resize(mesh.vertex_count() * 3);
+            for (std::size_t i = 0; i < mesh.vertex_count(); i++) {
+                mesh.get_vertex(i, vertices.data() + i * 3);
+            }
+            for (std::size_t i = 0; i < mesh.triangle_count(); i++) {
+                mesh.get_indices(i, indices.data() + i * 3);
+            }
+            return;
+        }
+
+        struct VertexHash {
+            std::size_t operator()(const std::array<double, 3>& v) const noexcept {
+                std::size_t h = 0;
+                for (double c : v) {
+                    std::uint64_t bits;
+                    std::memcpy(&bits, &c, 8);
+                    h = (h ^ bits) * 0x100000001b3ull;
+                }
+                return h;
+            }
+        };
+
+        std::unordered_map<std::array<double, 3>, std::uint32_t, VertexHash> welded;
+        welded.reserve(mesh.triangle_count() * 2);
+        for (std::size_t i = 0; i < mesh.vertex_count(); i++) {
+            std::array<double, 3> v;
+            mesh.get_vertex(i, v.data());
+            // +0 and -0 are the same point
+            for (double& c : v) {
+                c += 0.0;
+            }
+            auto inserted = welded.emplace(v, static_cast<std::uint32_t>(vertices.size() / 3));
+            if (inserted.second) {
+                vertices.insert(vertices.end(), v.begin(), v.end());
+            }
+            indices[i] = inserted.first->second;
+        }
+    }
+}
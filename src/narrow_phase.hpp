@@ -0,0 +1,100 @@
+#pragma once
+
+#include <vector>
+#include "intersection_private.hpp"
+#include "mesh.hpp"
+
+namespace triangle_intersection {
+    // dual tree traversal descends into the bigger node of a pair
+    inline bool split_first(const Bvh::Node& n1, const Bvh::Node& n2) {
+        auto get_size = [] (const Aabb& b) {
+            return (b.max[0] - b.min[0]) + (b.max[1] - b.min[1]) + (b.max[2] - b.min[2]);
+        };
+
+        return n2.is_leaf() || (!n1.is_leaf() && get_size(n1.box) >= get_size(n2.box));
+    }
+
+    /*
+    Collects candidate pairs coming out of a broad phase and tests them in chunks with have_intersection_batch.
+    The intersecting pairs of every chunk go to the sink as worker, or are only counted when there is no sink
+    */
+    class PairTester {
+    public:
+        static constexpr std::size_t CHUNK_SIZE = 256;
+
+        PairTester();
+        PairTester(const double* triangles1, const double* triangles2, PairSink* sink = nullptr, unsigned worker = 0);
+
+        // Starts over on other triangles, keeping the buffers
+        void reset(const double* triangles1, const double* triangles2, PairSink* sink, unsigned worker);
+
+        void add(std::uint32_t i, std::uint32_t j) {
+            candidates_.emplace_back(i, j);
+            if (candidates_.size() == CHUNK_SIZE) {
+                flush();
+            }
+        }
+
+        void flush();
+
+        // intersecting pairs among the flushed candidates
+        std::size_t get_hit_count() const noexcept { return hit_count_; }
+
+    private:
+        const double* triangles1_ = nullptr;
+        const double* triangles2_ = nullptr;
+        PairSink* sink_ = nullptr;
+        unsigned worker_ = 0;
+        std::size_t hit_count_ = 0;
+        std::vector<TrianglePair> candidates_;
+        std::vector<TrianglePair> hits_;
+        std::vector<double> coords_;
+    };
+
+    // Scratch of one worker of a dual traversal
+    struct QueryArena::Scratch {
+        struct NodePair {
+            std::uint32_t node1;
+            std::uint32_t node2;
+            int depth;
+        };
+
+        PairTester tester;
+        std::vector<NodePair> stack;
+    };
+
+    // The pairs of every worker in a vector of its own, merged and sorted for the overloads returning vectors
+    class VectorSink : public PairSink {
+    public:
+        void start(unsigned worker_count) override { found_.resize(worker_count); }
+        void put(const TrianglePair* pairs, std::size_t count, unsigned worker) override { found_[worker].insert(found_[worker].end(), pairs, pairs + count); }
+
+        std::vector<TrianglePair> get_sorted();
+
+    private:
+        std::vector<std::vector<TrianglePair>> found_;
+    };
+
+    // start() on construction, finish() on destruction, also when the query throws
+    class SinkSession {
+    public:
+        SinkSession(PairSink& sink, unsigned worker_count) : sink_(sink) { sink.start(worker_count); }
+        ~SinkSession() { sink_.finish(); }
+
+        SinkSession(const SinkSession&) = delete;
+        SinkSession& operator=(const SinkSession&) = delete;
+
+    private:
+        PairSink& sink_;
+    };
+
+    // triangle i of the mesh at triangles + 9i
+    void get_soup(const IndexedMesh& mesh, double* triangles);
+
+    // find_self_intersections over a hierarchy already built on the soup of mesh, as worker 0 of a started sink
+    void find_self_intersections(const IndexedMesh& mesh, const Bvh& bvh, PairSink& sink);
+    std::vector<TrianglePair> find_self_intersections(const IndexedMesh& mesh, const Bvh& bvh);
+
+    // the rules of find_self_intersections for one pair i < j, triangles is the soup of mesh
+    bool have_self_intersection(const IndexedMesh& mesh, const double* triangles, std::uint32_t i, std::uint32_t j);
+}
@@ -0,0 +1,430 @@
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include "narrow_phase.hpp"
+#include "pipeline.hpp"
+#include "scheduler.hpp"
+
+namespace triangle_intersection {
+    namespace {
+        constexpr std::size_t CHUNK_SIZE = BatchPipeline::CHUNK_SIZE;
+
+        struct Chunk {
+            std::size_t first = 0; // of the pairs of a batch job
+            std::size_t size = 0;
+            TriangleBatch t1, t2;  // what the test stage runs on
+            std::vector<TrianglePair> candidates;
+            std::vector<double> coords;
+            std::uint64_t mask[CHUNK_SIZE / 64];
+
+            Chunk() : coords(CHUNK_SIZE * 18) {
+                candidates.reserve(CHUNK_SIZE);
+            }
+
+            // copies the triangles of the candidates into coords, t1 and t2 then view them
+            void gather(const double* triangles1, const double* triangles2) {
+                size = candidates.size();
+                for (int k = 0; k < 9; k++) {
+                    t1.coords[k] = coords.data() + k * CHUNK_SIZE;
+                    t2.coords[k] = coords.data() + (k + 9) * CHUNK_SIZE;
+                }
+
+                for (std::size_t i = 0; i < size; i++) {
+                    const double* a = triangles1 + std::size_t(candidates[i].first) * 9;
+                    const double* b = triangles2 + std::size_t(candidates[i].second) * 9;
+                    for (int k = 0; k < 9; k++) {
+                        coords[k * CHUNK_SIZE + i] = a[k];
+                        coords[(k + 9) * CHUNK_SIZE + i] = b[k];
+                    }
+                }
+            }
+
+            bool is_hit(std::size_t i) const {
+                return (mask[i / 64] >> (i % 64)) & 1;
+            }
+        };
+
+        /*
+        A submitted job. gather() fills the next chunk and returns false once nothing is left, it is never called
+        by two workers at once. emit() takes the tested chunks in any order, from any worker.
+        finish() makes the future ready, with the first error if there was one
+        */
+        class Job {
+        public:
+            explicit Job(std::size_t weight) : weight(weight) {}
+            virtual ~Job() {}
+
+            virtual bool gather(Chunk& chunk) = 0;
+            virtual void emit(const Chunk& chunk) = 0;
+            virtual void finish(std::exception_ptr error) = 0;
+
+            std::size_t weight;        // counted against max_queued until gathered
+            std::size_t in_flight = 0; // chunks gathered and not yet emitted
+            bool gathering = false;
+            bool exhausted = false;
+            std::exception_ptr error;
+        };
+
+        class BatchJob : public Job {
+        public:
+            BatchJob(const TriangleBatch& t1, const TriangleBatch& t2, std::size_t n)
+                : Job(n), t1_(t1), t2_(t2), n_(n), mask_((n + 63) / 64) {}
+
+            std::future<std::vector<std::uint64_t>> get_future() { return promise_.get_future(); }
+
+            bool gather(Chunk& chunk) override {
+
+                // the caller's arrays are already laid out for the test, the chunk only views them
+
+                chunk.first = next_;
+                chunk.size = std::min(CHUNK_SIZE, n_ - next_);
+                for (int k = 0; k < 9; k++) {
+                    chunk.t1.coords[k] = t1_.coords[k] + next_;
+                    chunk.t2.coords[k] = t2_.coords[k] + next_;
+                }
+                next_ += chunk.size;
+                return next_ < n_;
+            }
+
+            void emit(const Chunk& chunk) override {
+                std::copy(chunk.mask, chunk.mask + (chunk.size + 63) / 64, mask_.begin() + static_cast<std::ptrdiff_t>(chunk.first / 64));
+            }
+
+            void finish(std::exception_ptr error) override {
+                if (error) {
+                    promise_.set_exception(error);
+                } else {
+                    promise_.set_value(std::move(mask_));
+                }
+            }
+
+        private:
+            TriangleBatch t1_, t2_;
+            std::size_t n_;
+            std::size_t next_ = 0;
+            std::vector<std::uint64_t> mask_;
+            std::promise<std::vector<std::uint64_t>> promise_;
+        };
+
+        // hits of the candidate pairs of intersect_pairs and intersect_meshes, sorted when the job ends
+        class PairJob : public Job {
+        public:
+            PairJob(std::size_t weight, const double* triangles1, const double* triangles2)
+                : Job(weight), triangles1_(triangles1), triangles2_(triangles2) {}
+
+            std::future<std::vector<TrianglePair>> get_future() { return promise_.get_future(); }
+
+            void emit(const Chunk& chunk) override {
+                std::lock_guard<std::mutex> lock(mutex_);
+                for (std::size_t i = 0; i < chunk.size; i++) {
+                    if (chunk.is_hit(i)) {
+                        found_.push_back(chunk.candidates[i]);
+                    }
+                }
+            }
+
+            void finish(std::exception_ptr error) override {
+                if (error) {
+                    promise_.set_exception(error);
+                    return;
+                }
+                std::sort(found_.begin(), found_.end());
+                promise_.set_value(std::move(found_));
+            }
+
+        protected:
+            const double* triangles1_;
+            const double* triangles2_;
+
+        private:
+            std::mutex mutex_;
+            std::vector<TrianglePair> found_;
+            std::promise<std::vector<TrianglePair>> promise_;
+        };
+
+        class CandidateJob : public PairJob {
+        public:
+            CandidateJob(const double* triangles1, const double* triangles2, std::vector<TrianglePair> candidates)
+                : PairJob(candidates.size(), triangles1, triangles2), candidates_(std::move(candidates)) {}
+
+            bool gather(Chunk& chunk) override {
+                std::size_t last = std::min(next_ + CHUNK_SIZE, candidates_.size());
+                chunk.candidates.assign(candidates_.begin() + static_cast<std::ptrdiff_t>(next_), candidates_.begin() + static_cast<std::ptrdiff_t>(last));
+                chunk.gather(triangles1_, triangles2_);
+                next_ = last;
+                return next_ < candidates_.size();
+            }
+
+        private:
+            std::vector<TrianglePair> candidates_;
+            std::size_t next_ = 0;
+        };
+
+        // the dual traversal of intersect_meshes, resumed where the previous chunk filled up
+        class MeshJob : public PairJob {
+        public:
+            MeshJob(const Bvh& mesh1, const Bvh& mesh2)
+                : PairJob(mesh1.size() + mesh2.size(), mesh1.triangles(), mesh2.triangles()), mesh1_(mesh1), mesh2_(mesh2) {
+                if (mesh1.size() != 0 && mesh2.size() != 0) {
+                    stack_.emplace_back(0, 0);
+                }
+            }
+
+            bool gather(Chunk& chunk) override {
+                std::vector<TrianglePair>& candidates = chunk.candidates;
+                candidates.clear();
+
+                // candidates of the leaf pair that overflowed the previous chunk first
+
+                std::size_t carried = std::min(CHUNK_SIZE, overflow_.size());
+                candidates.assign(overflow_.begin(), overflow_.begin() + static_cast<std::ptrdiff_t>(carried));
+                overflow_.erase(overflow_.begin(), overflow_.begin() + static_cast<std::ptrdiff_t>(carried));
+
+                const std::vector<Bvh::Node>& nodes1 = mesh1_.nodes();
+                const std::vector<Bvh::Node>& nodes2 = mesh2_.nodes();
+                while (candidates.size() < CHUNK_SIZE && !stack_.empty()) {
+                    std::pair<std::uint32_t, std::uint32_t> pair = stack_.back();
+                    stack_.pop_back();
+
+                    const Bvh::Node& n1 = nodes1[pair.first];
+                    const Bvh::Node& n2 = nodes2[pair.second];
+                    if (!have_overlap(n1.box, n2.box)) {
+                        continue;
+                    }
+
+                    if (n1.is_leaf() && n2.is_leaf()) {
+                        for (std::uint32_t i = n1.first; i < n1.first + n1.count; i++) {
+                            std::uint32_t t1 = mesh1_.indices()[i];
+                            for (std::uint32_t j = n2.first; j < n2.first + n2.count; j++) {
+                                std::uint32_t t2 = mesh2_.indices()[j];
+                                if (have_overlap(mesh1_.get_triangle_box(t1), mesh2_.get_triangle_box(t2))) {
+                                    (candidates.size() < CHUNK_SIZE ? candidates : overflow_).emplace_back(t1, t2);
+                                }
+                            }
+                        }
+                    } else if (split_first(n1, n2)) {
+                        stack_.emplace_back(n1.first + 1, pair.second);
+                        stack_.emplace_back(n1.first, pair.second);
+                    } else {
+                        stack_.emplace_back(pair.first, n2.first + 1);
+                        stack_.emplace_back(pair.first, n2.first);
+                    }
+                }
+
+                chunk.gather(triangles1_, triangles2_);
+                return !stack_.empty() || !overflow_.empty();
+            }
+
+        private:
+            const Bvh& mesh1_;
+            const Bvh& mesh2_;
+            std::vector<std::pair<std::uint32_t, std::uint32_t>> stack_;
+            std::vector<TrianglePair> overflow_;
+        };
+    }
+
+    struct BatchPipeline::State {
+        explicit State(const Options& options) {
+            unsigned threads = triangle_intersection::get_thread_count(options.threads);
+            std::size_t chunk_count = options.max_chunks_in_flight == 0 ? 4 * std::size_t(threads) : options.max_chunks_in_flight;
+            for (std::size_t c = 0; c < chunk_count; c++) {
+                chunks.emplace_back(new Chunk());
+                free.push_back(chunks.back().get());
+            }
+            max_queued = options.max_queued;
+
+            workers.reserve(threads);
+            try {
+                for (unsigned w = 0; w < threads; w++) {
+                    workers.emplace_back([this] { work(); });
+                }
+            } catch (...) {
+                // ~State does not run for a constructor that throws, the workers already started are stopped here
+                stop();
+                throw;
+            }
+        }
+
+        ~State() {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                space_ready.wait(lock, [this] { return jobs.empty(); });
+            }
+            stop();
+        }
+
+        void stop() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            work_ready.notify_all();
+            for (std::thread& t : workers) {
+                t.join();
+            }
+        }
+
+        template <class T>
+        auto add(std::unique_ptr<T> job) -> decltype(job->get_future()) {
+            auto future = job->get_future();
+            std::unique_lock<std::mutex> lock(mutex);
+            space_ready.wait(lock, [&] { return queued == 0 || queued + job->weight <= max_queued; });
+            queued += job->weight;
+            jobs.emplace_back(std::move(job));
+            lock.unlock();
+
+            work_ready.notify_all();
+            return future;
+        }
+
+        Job* get_gatherable_job() {
+            for (const std::unique_ptr<Job>& job : jobs) {
+                if (!job->gathering && !job->exhausted) {
+                    return job.get();
+                }
+            }
+            return nullptr;
+        }
+
+        // lock is held. Ends job once nothing more will be gathered and every chunk of it is emitted
+        void release(Job* job, std::unique_lock<std::mutex>& lock) {
+            if (!job->exhausted || job->in_flight != 0 || job->gathering) {
+                return;
+            }
+
+            auto i = std::find_if(jobs.begin(), jobs.end(), [&] (const std::unique_ptr<Job>& j) { return j.get() == job; });
+            std::unique_ptr<Job> finished = std::move(*i);
+            jobs.erase(i);
+            lock.unlock();
+            finished->finish(finished->error);
+            finished.reset();
+            lock.lock();
+            space_ready.notify_all();
+        }
+
+        /*
+        Emits before testing and tests before gathering, so a chunk in flight moves on before a new one starts:
+        the free chunks bound the memory and the work between a gather and its emit
+        */
+        void work() {
+            std::unique_lock<std::mutex> lock(mutex);
+            for (;;) {
+                if (!tested.empty()) {
+                    std::pair<Job*, Chunk*> item = tested.front();
+                    tested.pop_front();
+                    lock.unlock();
+
+                    std::exception_ptr error;
+                    try {
+                        item.first->emit(*item.second);
+                    } catch (...) {
+                        error = std::current_exception();
+                    }
+
+                    lock.lock();
+                    if (error && !item.first->error) {
+                        item.first->error = error;
+                    }
+                    item.first->in_flight--;
+                    free.push_back(item.second);
+                    release(item.first, lock);
+                    work_ready.notify_all();
+                    continue;
+                }
+
+                if (!gathered.empty()) {
+                    std::pair<Job*, Chunk*> item = gathered.front();
+                    gathered.pop_front();
+                    lock.unlock();
+
+                    Chunk& chunk = *item.second;
+                    have_intersection_batch(chunk.t1, chunk.t2, chunk.size, chunk.mask);
+
+                    lock.lock();
+                    tested.push_back(item);
+                    work_ready.notify_one();
+                    continue;
+                }
+
+                Job* job = free.empty() ? nullptr : get_gatherable_job();
+                if (job) {
+                    Chunk* chunk = free.back();
+                    free.pop_back();
+                    job->gathering = true;
+                    lock.unlock();
+
+                    bool more = false;
+                    std::exception_ptr error;
+                    try {
+                        more = job->gather(*chunk);
+                    } catch (...) {
+                        error = std::current_exception();
+                    }
+
+                    lock.lock();
+                    job->gathering = false;
+                    if (error) {
+                        job->error = error;
+                        more = false;
+                    }
+                    if (!more) {
+                        job->exhausted = true;
+                        queued -= job->weight;
+                        space_ready.notify_all();
+                    }
+                    if (!error && chunk->size != 0) {
+                        job->in_flight++;
+                        gathered.emplace_back(job, chunk);
+                    } else {
+                        free.push_back(chunk);
+                    }
+                    release(job, lock);
+                    work_ready.notify_all();
+                    continue;
+                }
+
+                if (stopping) {
+                    return;
+                }
+                work_ready.wait(lock);
+            }
+        }
+
+        std::mutex mutex;
+        std::condition_variable work_ready;  // for the workers
+        std::condition_variable space_ready; // for submit() and the destructor
+        std::deque<std::unique_ptr<Job>> jobs; // not finished, in submission order
+        std::deque<std::pair<Job*, Chunk*>> gathered, tested;
+        std::vector<std::unique_ptr<Chunk>> chunks;
+        std::vector<Chunk*> free;
+        std::size_t queued = 0;
+        std::size_t max_queued = 0;
+        bool stopping = false;
+        std::vector<std::thread> workers;
+    };
+
+    BatchPipeline::BatchPipeline() : BatchPipeline(Options()) {}
+
+    BatchPipeline::BatchPipeline(const Options& options) : state_(new State(options)) {}
+
+    BatchPipeline::~BatchPipeline() = default;
+
+    std::future<std::vector<std::uint64_t>> BatchPipeline::submit(const TriangleBatch& t1, const TriangleBatch& t2, std::size_t n) {
+        return state_->add(std::unique_ptr<BatchJob>(new BatchJob(t1, t2, n)));
+    }
+
+    std::future<std::vector<TrianglePair>> BatchPipeline::submit(const double* triangles1, const double* triangles2, std::vector<TrianglePair> candidates) {
+        return state_->add(std::unique_ptr<CandidateJob>(new CandidateJob(triangles1, triangles2, std::move(candidates))));
+    }
+
+    std::future<std::vector<TrianglePair>> BatchPipeline::submit(const Bvh& mesh1, const Bvh& mesh2) {
+        return state_->add(std::unique_ptr<MeshJob>(new MeshJob(mesh1, mesh2)));
+    }
+
+    unsigned BatchPipeline::get_thread_count() const noexcept {
+        return static_cast<unsigned>(state_->workers.size());
+    }
+}
@@ -0,0 +1,2 @@
+#include "intersection_private.hpp"
+#include "detail/predicates_inl.hpp"
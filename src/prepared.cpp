@@ -0,0 +1,168 @@
+#include "intersection_private.hpp"
+#include "stats_private.hpp"
+
+namespace triangle_intersection {
+    namespace {
+        // orient3d(p, q, r, x) of the prepared triangle (p, q, r), only the sign is exact with RobustPredicates
+        template <class Predicates>
+        double get_plane_distance(const PreparedTriangle& t, const double x[3]);
+
+        template <>
+        double get_plane_distance<FastPredicates>(const PreparedTriangle& t, const double x[3]) {
+            return t.offset - dot_product(t.normal, x);
+        }
+
+        template <>
+        double get_plane_distance<RobustPredicates>(const PreparedTriangle& t, const double x[3]) {
+
+            /*
+            The normal and the dot products carry rounding errors bounded by the magnitudes
+            of their terms, whatever does not clear the bound is evaluated exactly
+            */
+
+            double d = t.offset - dot_product(t.normal, x);
+            double magnitude = t.offset_magnitude + t.normal_magnitude[0] * std::abs(x[0])
+                             + t.normal_magnitude[1] * std::abs(x[1]) + t.normal_magnitude[2] * std::abs(x[2]);
+
+            if (std::abs(d) > PLANE_ERROR_BOUND * magnitude) {
+                return d;
+            }
+
+            return RobustPredicates::orient3d(t.vertices, t.vertices + 3, t.vertices + 6, x);
+        }
+
+        struct Vertices {
+            const double* v[3];
+
+            explicit Vertices(const PreparedTriangle& t) : v { t.vertices, t.vertices + 3, t.vertices + 6 } {}
+        };
+    }
+
+    PreparedTriangle::PreparedTriangle(const double t[9]) noexcept {
+        const double* v[3] = { t, t + 3, t + 6 };
+        *this = PreparedTriangle(v);
+    }
+
+    PreparedTriangle::PreparedTriangle(const double* const t[3]) noexcept {
+        const double* v[3] = { t[0], t[1], t[2] };
+        kind = is_point(v) ? TriangleKind::Point : is_segment(v) ? TriangleKind::Segment : TriangleKind::Triangle;
+
+        for (int i = 0; i < 3; i++) {
+            for (int k = 0; k < 3; k++) {
+                vertices[i * 3 + k] = v[i][k];
+            }
+        }
+
+        for (int k = 0; k < 3; k++) {
+            edges[0][k] = vertices[3 + k] - vertices[k];
+            edges[1][k] = vertices[6 + k] - vertices[k];
+        }
+
+        cross_product(edges[0], edges[1], normal);
+        offset = dot_product(normal, vertices);
+
+        normal_magnitude[0] = std::abs(edges[0][1] * edges[1][2]) + std::abs(edges[0][2] * edges[1][1]);
+        normal_magnitude[1] = std::abs(edges[0][2] * edges[1][0]) + std::abs(edges[0][0] * edges[1][2]);
+        normal_magnitude[2] = std::abs(edges[0][0] * edges[1][1]) + std::abs(edges[0][1] * edges[1][0]);
+        offset_magnitude = normal_magnitude[0] * std::abs(vertices[0]) + normal_magnitude[1] * std::abs(vertices[1])
+                         + normal_magnitude[2] * std::abs(vertices[2]);
+        dominant_axis = get_dominant_axis(v);
+    }
+
+    bool have_intersection(const PreparedTriangle& t1, const PreparedTriangle& t2) noexcept {
+        return have_intersection<RobustPredicates>(t1, t2);
+    }
+
+    bool have_intersection(const PreparedTriangle& t1, const double t2[9]) noexcept {
+        return have_intersection<RobustPredicates>(t1, PreparedTriangle(t2));
+    }
+
+    template <class Predicates>
+    bool have_intersection(const PreparedTriangle& t1, const PreparedTriangle& t2) noexcept {
+        TRIANGLE_INTERSECTION_PROBE;
+
+        Vertices v1(t1), v2(t2);
+
+        if (t1.kind != TriangleKind::Triangle || t2.kind != TriangleKind::Triangle) {
+            // same dispatch as the unprepared kernel, the classification is already done
+            if (t1.kind == TriangleKind::Point) {
+                if (t2.kind == TriangleKind::Point) {
+                    return TRIANGLE_INTERSECTION_EXIT(PointPoint, have_intersection_p_p(t1.vertices, t2.vertices));
+                }
+                if (t2.kind == TriangleKind::Segment) {
+                    return TRIANGLE_INTERSECTION_EXIT(PointSegment, have_intersection_s_p(v2.v, t1.vertices));
+                }
+                return TRIANGLE_INTERSECTION_EXIT(PointTriangle, have_intersection_t_p(v2.v, t1.vertices));
+            }
+
+            if (t2.kind == TriangleKind::Point) {
+                if (t1.kind == TriangleKind::Segment) {
+                    return TRIANGLE_INTERSECTION_EXIT(PointSegment, have_intersection_s_p(v1.v, t2.vertices));
+                }
+                return TRIANGLE_INTERSECTION_EXIT(PointTriangle, have_intersection_t_p(v1.v, t2.vertices));
+            }
+
+            if (t1.kind == TriangleKind::Segment) {
+                if (t2.kind == TriangleKind::Segment) {
+                    return TRIANGLE_INTERSECTION_EXIT(SegmentSegment, have_intersection_s_s(v1.v, v2.v));
+                }
+                return TRIANGLE_INTERSECTION_EXIT(SegmentTriangle, have_intersection_t_s(v2.v, t2.edges[0], t2.edges[1], v1.v));
+            }
+
+            return TRIANGLE_INTERSECTION_EXIT(SegmentTriangle, have_intersection_t_s(v1.v, t1.edges[0], t1.edges[1], v2.v));
+        }
+
+        double d1[3] = {
+            get_plane_distance<Predicates>(t2, t1.vertices),
+            get_plane_distance<Predicates>(t2, t1.vertices + 3),
+            get_plane_distance<Predicates>(t2, t1.vertices + 6)
+        };
+
+        if (d1[0] == 0 && d1[1] == 0 && d1[2] == 0) {
+            // flat triangles as in the unprepared kernel
+            const double* s[2];
+            if (is_flat<Predicates>(v2.v)) {
+                get_longest_side(v2.v, s);
+                return TRIANGLE_INTERSECTION_EXIT(SegmentTriangle, have_intersection_t_s(v1.v, t1.edges[0], t1.edges[1], s));
+            }
+            if (is_flat<Predicates>(v1.v)) {
+                get_longest_side(v1.v, s);
+                return TRIANGLE_INTERSECTION_EXIT(SegmentTriangle, have_intersection_t_s(v2.v, t2.edges[0], t2.edges[1], s));
+            }
+
+            return TRIANGLE_INTERSECTION_EXIT(Coplanar, have_intersection_coplanar_t_t<Predicates>(v1.v, v2.v, t1.dominant_axis));
+        }
+
+        if ((d1[0] < 0 && d1[1] < 0 && d1[2] < 0) || (d1[0] > 0 && d1[1] > 0 && d1[2] > 0)) {
+            return TRIANGLE_INTERSECTION_EXIT(FirstPlaneReject, false);
+        }
+
+        double d2[3] = {
+            get_plane_distance<Predicates>(t1, t2.vertices),
+            get_plane_distance<Predicates>(t1, t2.vertices + 3),
+            get_plane_distance<Predicates>(t1, t2.vertices + 6)
+        };
+
+        if ((d2[0] < 0 && d2[1] < 0 && d2[2] < 0) || (d2[0] > 0 && d2[1] > 0 && d2[2] > 0)) {
+            return TRIANGLE_INTERSECTION_EXIT(SecondPlaneReject, false);
+        }
+
+        if (d2[0] == 0 && d2[1] == 0 && d2[2] == 0 && is_flat<Predicates>(v1.v)) {
+            const double* s[2];
+            get_longest_side(v1.v, s);
+            return TRIANGLE_INTERSECTION_EXIT(SegmentTriangle, have_intersection_t_s(v2.v, t2.edges[0], t2.edges[1], s));
+        }
+
+        reorder_points(v1.v, v2.v, d1, d2);
+
+        double d[2] = {
+            Predicates::orient3d(v1.v[0], v1.v[1], v2.v[0], v2.v[1]),
+            Predicates::orient3d(v1.v[0], v1.v[2], v2.v[2], v2.v[0])
+        };
+
+        return TRIANGLE_INTERSECTION_EXIT(Interval, d[0] >= 0 && d[1] >= 0);
+    }
+
+    template bool have_intersection<FastPredicates>(const PreparedTriangle& t1, const PreparedTriangle& t2) noexcept;
+    template bool have_intersection<RobustPredicates>(const PreparedTriangle& t1, const PreparedTriangle& t2) noexcept;
+}
@@ -0,0 +1,308 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include "static_scene.hpp"
+#include "detail/kernel.hpp"
+
+/*
+Packet ray traversal of a StaticScene over the Ops of batch_kernel.hpp (double only), which also need
+    store, div, min (a < b ? a : b), max (a > b ? a : b)
+
+A packet is two vectors of rays (one ray with the scalar Ops). The packet enters a node when any of its rays
+hits the box, the triangles of a leaf are tested with Moller-Trumbore on the lanes that hit the leaf box.
+Lanes past the end of the input get a negative distance limit, no box or triangle accepts them. Every lane performs the same operations in the same order
+whatever the width, so all instruction sets give the same hits.
+This header must only be included by the translation units compiled for the corresponding instruction set.
+Those units must not emit shared inline functions (accessors, std::abs, the helpers of detail/kernel.hpp): the linker
+would keep one copy of each, possibly built for AVX, so the kernels only call the local helpers below and read
+the scene through the plain pointers of RayScene.
+*/
+
+namespace triangle_intersection {
+    // the arrays of a StaticScene the packet kernels read
+    struct RayScene {
+        const StaticScene::Node* nodes;
+        std::size_t node_count;
+        const double* triangles; // leaf order
+        const std::uint32_t* ids; // triangle i of the layout is triangle ids[i] of the soup
+    };
+
+    namespace {
+        constexpr double NO_RAY_HIT = std::numeric_limits<double>::infinity();
+
+        double get_ray_magnitude(double x) {
+            return x < 0 ? -x : x;
+        }
+
+        bool is_ray_leaf(const StaticScene::Node& node) {
+            return node.count != 0;
+        }
+    }
+
+    namespace simd {
+        // relative slack of the box tests, so that rounding never drops a box a ray touches
+        constexpr double BOX_MARGIN = 1e-9;
+
+        template <class Ops>
+        struct RayPacket {
+            static constexpr std::size_t vectors = Ops::width == 1 ? 1 : 2;
+            static constexpr std::size_t size = Ops::width * vectors;
+
+            typename Ops::vec origin[vectors][3];
+            typename Ops::vec direction[vectors][3];
+            typename Ops::vec inverse[vectors][3]; // 1 / direction, zero components replaced by a tiny one
+            typename Ops::vec limit[vectors];      // max_distance, then the distance of the nearest hit
+            typename Ops::vec id[vectors];         // nearest triangle as a double, infinity before the first hit
+            typename Ops::vec crossings[vectors];
+            typename Ops::mask uncertain[vectors];
+            double lead[3];                               // direction of the first ray, orders the children
+        };
+
+        template <class Ops>
+        void load_packet(const Ray* rays, std::size_t count, RayPacket<Ops>& p) {
+            constexpr std::size_t W = Ops::width;
+            alignas(64) double values[10][W];
+            for (std::size_t v = 0; v < RayPacket<Ops>::vectors; v++) {
+                for (std::size_t l = 0; l < W; l++) {
+                    std::size_t i = v * W + l;
+                    const Ray& r = rays[i < count ? i : 0];
+                    for (int c = 0; c < 3; c++) {
+                        values[c][l] = r.origin[c];
+                        values[3 + c][l] = r.direction[c];
+                        values[6 + c][l] = 1 / (r.direction[c] != 0 ? r.direction[c] : 1e-300);
+                    }
+                    values[9][l] = i < count ? r.max_distance : -1;
+                }
+                for (int c = 0; c < 3; c++) {
+                    p.origin[v][c] = Ops::load(values[c]);
+                    p.direction[v][c] = Ops::load(values[3 + c]);
+                    p.inverse[v][c] = Ops::load(values[6 + c]);
+                }
+                p.limit[v] = Ops::load(values[9]);
+                p.id[v] = Ops::set1(NO_RAY_HIT);
+                p.crossings[v] = Ops::set1(0.0);
+                p.uncertain[v] = Ops::lt(p.crossings[v], p.crossings[v]); // no lane
+            }
+            for (int c = 0; c < 3; c++) {
+                p.lead[c] = rays[0].direction[c];
+            }
+        }
+
+        // sets the lanes that hit the box, true when any does
+        template <class Ops>
+        bool hit_box(const RayPacket<Ops>& p, const StaticScene::Node& node, typename Ops::mask lanes[]) {
+            bool any = false;
+            for (std::size_t v = 0; v < RayPacket<Ops>::vectors; v++) {
+                typename Ops::vec t_in = Ops::set1(0.0);
+                typename Ops::vec t_out = p.limit[v];
+                for (int c = 0; c < 3; c++) {
+                    typename Ops::vec t0 = Ops::mul(Ops::sub(Ops::set1(node.min[c]), p.origin[v][c]), p.inverse[v][c]);
+                    typename Ops::vec t1 = Ops::mul(Ops::sub(Ops::set1(node.max[c]), p.origin[v][c]), p.inverse[v][c]);
+                    t_in = Ops::max(t_in, Ops::min(t0, t1));
+                    t_out = Ops::min(t_out, Ops::max(t0, t1));
+                }
+                lanes[v] = Ops::le(Ops::mul(t_in, Ops::set1(1 - BOX_MARGIN)), Ops::mul(t_out, Ops::set1(1 + BOX_MARGIN)));
+                any = any || !Ops::none(lanes[v]);
+            }
+            return any;
+        }
+
+        template <class Ops>
+        void cross(const typename Ops::vec a[3], const typename Ops::vec b[3], typename Ops::vec c[3]) {
+            c[0] = Ops::sub(Ops::mul(a[1], b[2]), Ops::mul(a[2], b[1]));
+            c[1] = Ops::sub(Ops::mul(a[2], b[0]), Ops::mul(a[0], b[2]));
+            c[2] = Ops::sub(Ops::mul(a[0], b[1]), Ops::mul(a[1], b[0]));
+        }
+
+        template <class Ops>
+        typename Ops::vec dot(const typename Ops::vec a[3], const typename Ops::vec b[3]) {
+            return Ops::add(Ops::add(Ops::mul(a[0], b[0]), Ops::mul(a[1], b[1])), Ops::mul(a[2], b[2]));
+        }
+
+        template <class Ops, bool Count>
+        void hit_triangle(RayPacket<Ops>& p, const typename Ops::mask lanes[], const double t[9], std::uint32_t id) {
+            using vec = typename Ops::vec;
+            using mask = typename Ops::mask;
+
+            double e1[3] = { t[3] - t[0], t[4] - t[1], t[5] - t[2] };
+            double e2[3] = { t[6] - t[0], t[7] - t[1], t[8] - t[2] };
+            double normal[3] = {
+                e1[1] * e2[2] - e1[2] * e2[1],
+                e1[2] * e2[0] - e1[0] * e2[2],
+                e1[0] * e2[1] - e1[1] * e2[0]
+            };
+            // a flat triangle has no inside to cross, rays along it are no reason to cast again
+            bool flat = normal[0] == 0 && normal[1] == 0 && normal[2] == 0;
+
+            vec p0[3], edge1[3], edge2[3];
+            for (int c = 0; c < 3; c++) {
+                p0[c] = Ops::set1(t[c]);
+                edge1[c] = Ops::set1(e1[c]);
+                edge2[c] = Ops::set1(e2[c]);
+            }
+
+            vec eps = Ops::set1(EPS);
+            vec one = Ops::set1(1.0);
+            for (std::size_t v = 0; v < RayPacket<Ops>::vectors; v++) {
+                if (Ops::none(lanes[v])) {
+                    continue;
+                }
+
+                vec v1[3];
+                cross<Ops>(p.direction[v], edge2, v1);
+                vec det = dot<Ops>(edge1, v1);
+                mask parallel = Ops::lt(Ops::abs(det), eps);
+                vec inverse_det = Ops::div(one, det);
+
+                vec v2[3] = {
+                    Ops::sub(p.origin[v][0], p0[0]),
+                    Ops::sub(p.origin[v][1], p0[1]),
+                    Ops::sub(p.origin[v][2], p0[2])
+                };
+                vec u = Ops::mul(dot<Ops>(v2, v1), inverse_det);
+
+                vec v3[3];
+                cross<Ops>(v2, edge1, v3);
+                vec w = Ops::mul(dot<Ops>(p.direction[v], v3), inverse_det);
+                vec r = Ops::mul(dot<Ops>(edge2, v3), inverse_det);
+                vec uw = Ops::add(u, w);
+
+                mask inside = Ops::and_(Ops::and_(Ops::ge(u, Ops::sub(Ops::set1(0.0), eps)), Ops::le(u, Ops::add(one, eps))),
+                                        Ops::and_(Ops::ge(w, Ops::sub(Ops::set1(0.0), eps)), Ops::le(uw, Ops::add(one, eps))));
+                inside = Ops::andnot(Ops::and_(Ops::and_(inside, Ops::le(r, p.limit[v])), lanes[v]), parallel);
+
+                if (Count) {
+                    // strictly inside, away from the edges and from the origin: a certain crossing
+                    mask strict = Ops::and_(Ops::and_(Ops::gt(u, eps), Ops::gt(w, eps)),
+                                            Ops::and_(Ops::lt(uw, Ops::sub(one, eps)), Ops::gt(r, eps)));
+                    strict = Ops::and_(strict, inside);
+                    p.crossings[v] = Ops::add(p.crossings[v], Ops::select(strict, one, Ops::set1(0.0)));
+
+                    mask doubtful = Ops::andnot(Ops::and_(inside, Ops::ge(r, Ops::sub(Ops::set1(0.0), eps))), strict);
+                    if (!flat) {
+                        doubtful = Ops::or_(doubtful, Ops::and_(parallel, lanes[v]));
+                    }
+                    p.uncertain[v] = Ops::or_(p.uncertain[v], doubtful);
+                } else {
+                    vec candidate = Ops::set1(static_cast<double>(id));
+                    mask closer = Ops::or_(Ops::lt(r, p.limit[v]), Ops::and_(Ops::eq(r, p.limit[v]), Ops::lt(candidate, p.id[v])));
+                    closer = Ops::and_(Ops::and_(inside, Ops::ge(r, Ops::set1(0.0))), closer);
+                    p.limit[v] = Ops::select(closer, r, p.limit[v]);
+                    p.id[v] = Ops::select(closer, candidate, p.id[v]);
+                }
+            }
+        }
+
+        template <class Ops, bool Count>
+        void trace_packet(const RayScene& scene, RayPacket<Ops>& p) {
+            const StaticScene::Node* nodes = scene.nodes;
+            typename Ops::mask lanes[RayPacket<Ops>::vectors];
+            typename Ops::mask other[RayPacket<Ops>::vectors];
+            if (scene.node_count == 0 || !hit_box(p, nodes[0], lanes)) {
+                return;
+            }
+
+            std::uint32_t stack[StaticScene::MAX_DEPTH];
+            int stack_size = 0;
+            std::uint32_t i = 0;
+            for (;;) {
+                const StaticScene::Node& node = nodes[i];
+                if (is_ray_leaf(node)) {
+                    if (hit_box(p, node, lanes)) {
+                        for (std::uint32_t k = node.offset; k < node.offset + node.count; k++) {
+                            hit_triangle<Ops, Count>(p, lanes, scene.triangles + std::size_t(k) * 9, scene.ids[k]);
+                        }
+                    }
+                } else {
+                    std::uint32_t left = i + 1;
+                    std::uint32_t right = node.offset;
+                    bool hit_left = hit_box(p, nodes[left], lanes);
+                    bool hit_right = hit_box(p, nodes[right], other);
+                    if (hit_left && hit_right) {
+
+                        // nearer child first along the axis separating the children most, as seen by the first ray
+
+                        int axis = 0;
+                        double separation = 0;
+                        for (int c = 0; c < 3; c++) {
+                            double d = (nodes[right].min[c] + nodes[right].max[c]) - (nodes[left].min[c] + nodes[left].max[c]);
+                            if (get_ray_magnitude(d) > get_ray_magnitude(separation)) {
+                                axis = c;
+                                separation = d;
+                            }
+                        }
+                        bool left_first = (p.lead[axis] >= 0) == (separation >= 0);
+                        stack[stack_size++] = left_first ? right : left;
+                        i = left_first ? left : right;
+                        continue;
+                    }
+                    if (hit_left || hit_right) {
+                        i = hit_left ? left : right;
+                        continue;
+                    }
+                }
+
+                if (stack_size == 0) {
+                    return;
+                }
+                i = stack[--stack_size];
+            }
+        }
+
+        template <class Ops>
+        void get_nearest_hits(const RayScene& scene, const Ray* rays, std::size_t n, RayHit* hits) {
+            constexpr std::size_t W = Ops::width;
+            constexpr std::size_t PACKET = RayPacket<Ops>::size;
+            alignas(64) double distances[W], ids[W];
+            for (std::size_t first = 0; first < n; first += PACKET) {
+                std::size_t count = n - first < PACKET ? n - first : PACKET;
+                RayPacket<Ops> p;
+                load_packet(rays + first, count, p);
+                trace_packet<Ops, false>(scene, p);
+
+                for (std::size_t v = 0; v < RayPacket<Ops>::vectors; v++) {
+                    Ops::store(distances, p.limit[v]);
+                    Ops::store(ids, p.id[v]);
+                    for (std::size_t l = 0; l < W && v * W + l < count; l++) {
+                        RayHit& hit = hits[first + v * W + l];
+                        hit.distance = distances[l];
+                        hit.triangle = ids[l] == NO_RAY_HIT ? StaticScene::NO_HIT : static_cast<std::uint32_t>(ids[l]);
+                    }
+                }
+            }
+        }
+
+        // uncertain holds (n + 63) / 64 words, bits are only set
+        template <class Ops>
+        void count_crossings(const RayScene& scene, const Ray* rays, std::size_t n, std::uint32_t* crossings, std::uint64_t* uncertain) {
+            constexpr std::size_t W = Ops::width;
+            constexpr std::size_t PACKET = RayPacket<Ops>::size;
+            alignas(64) double counts[W];
+            for (std::size_t first = 0; first < n; first += PACKET) {
+                std::size_t count = n - first < PACKET ? n - first : PACKET;
+                RayPacket<Ops> p;
+                load_packet(rays + first, count, p);
+                trace_packet<Ops, true>(scene, p);
+
+                for (std::size_t v = 0; v < RayPacket<Ops>::vectors; v++) {
+                    Ops::store(counts, p.crossings[v]);
+                    unsigned bits = Ops::bits(p.uncertain[v]);
+                    for (std::size_t l = 0; l < W && v * W + l < count; l++) {
+                        std::size_t i = first + v * W + l;
+                        crossings[i] = static_cast<std::uint32_t>(counts[l]);
+                        if ((bits >> l) & 1) {
+                            uncertain[i / 64] |= std::uint64_t(1) << (i % 64);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    void get_nearest_hits_avx2(const RayScene& scene, const Ray* rays, std::size_t n, RayHit* hits);
+    void get_nearest_hits_avx512(const RayScene& scene, const Ray* rays, std::size_t n, RayHit* hits);
+    void count_crossings_avx2(const RayScene& scene, const Ray* rays, std::size_t n, std::uint32_t* crossings, std::uint64_t* uncertain);
+    void count_crossings_avx512(const RayScene& scene, const Ray* rays, std::size_t n, std::uint32_t* crossings, std::uint64_t* uncertain);
+}
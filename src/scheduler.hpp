@@ -0,0 +1,122 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <deque>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace triangle_intersection {
+    // 0 asks for one thread per hardware thread
+    inline unsigned get_thread_count(unsigned max_threads) {
+        return max_threads == 0 ? std::max(1u, std::thread::hardware_concurrency()) : max_threads;
+    }
+
+    /*
+    Work-stealing task scheduler. Every worker owns a deque: it takes its own tasks from the back
+    and, when it runs dry, steals from the front of the others. Tasks may push new tasks.
+    run() returns once every task is done; worker 0 is the calling thread. When a thread cannot be started,
+    run() goes on with the workers it has
+    */
+    template <class Task>
+    class WorkStealingScheduler {
+    public:
+        explicit WorkStealingScheduler(unsigned threads) : size_(std::max(1u, threads)), queues_(new Queue[size_]) {}
+
+        unsigned size() const { return size_; }
+
+        void push(unsigned worker, Task task) {
+            pending_.fetch_add(1, std::memory_order_relaxed);
+            std::lock_guard<std::mutex> lock(queues_[worker].mutex);
+            queues_[worker].tasks.push_back(std::move(task));
+        }
+
+        // process(task, worker)
+        template <class F>
+        void run(F process) {
+            std::vector<std::thread> threads;
+            threads.reserve(size_ - 1);
+            try {
+                for (unsigned w = 1; w < size_; w++) {
+                    threads.emplace_back([this, &process, w] { work(process, w); });
+                }
+            } catch (...) {
+                // a thread failed to start: the workers already running steal the tasks of the missing ones
+            }
+
+            work(process, 0);
+            for (std::thread& t : threads) {
+                t.join();
+            }
+
+            if (error_) {
+                std::rethrow_exception(error_);
+            }
+        }
+
+    private:
+        struct Queue {
+            std::mutex mutex;
+            std::deque<Task> tasks;
+        };
+
+        bool pop(unsigned worker, Task& task) {
+            {
+                Queue& own = queues_[worker];
+                std::lock_guard<std::mutex> lock(own.mutex);
+                if (!own.tasks.empty()) {
+                    task = std::move(own.tasks.back());
+                    own.tasks.pop_back();
+                    return true;
+                }
+            }
+
+            for (unsigned i = 1; i < size_; i++) {
+                Queue& victim = queues_[(worker + i) % size_];
+                std::lock_guard<std::mutex> lock(victim.mutex);
+                if (!victim.tasks.empty()) {
+                    task = std::move(victim.tasks.front());
+                    victim.tasks.pop_front();
+                    return true;
+                }
+            }
+
+            return false;
+        }
+
+        template <class F>
+        void work(F& process, unsigned worker) {
+            Task task;
+            while (pending_.load(std::memory_order_acquire) != 0) {
+                if (!pop(worker, task)) {
+                    std::this_thread::yield();
+                    continue;
+                }
+
+                if (!failed_.load(std::memory_order_relaxed)) {
+                    try {
+                        process(task, worker);
+                    } catch (...) {
+                        std::lock_guard<std::mutex> lock(error_mutex_);
+                        if (!error_) {
+                            error_ = std::current_exception();
+                        }
+                        failed_.store(true, std::memory_order_relaxed);
+                    }
+                }
+
+                pending_.fetch_sub(1, std::memory_order_acq_rel);
+            }
+        }
+
+        unsigned size_;
+        std::unique_ptr<Queue[]> queues_;
+        std::atomic<std::size_t> pending_ { 0 };
+        std::atomic<bool> failed_ { false };
+        std::mutex error_mutex_;
+        std::exception_ptr error_;
+    };
+}
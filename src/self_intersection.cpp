@@ -0,0 +1,210 @@
+#include <algorithm>
+#include "narrow_phase.hpp"
+
+namespace triangle_intersection {
+    namespace {
+        struct SelfTest {
+            const IndexedMesh& mesh;
+            const Bvh& bvh;
+            PairTester& tester;
+            PairSink& sink;
+
+            void test_leaf_pair(const Bvh::Node& n1, const Bvh::Node& n2, bool same);
+        };
+
+        const double* get_vertex(const IndexedMesh& mesh, std::uint32_t triangle, int corner) {
+            return mesh.vertices + std::size_t(mesh.indices[std::size_t(triangle) * 3 + corner]) * mesh.vertex_stride;
+        }
+
+        bool have_intersection_t_opposite_edge(const IndexedMesh& mesh, std::uint32_t triangle, std::uint32_t other, int shared_corner) {
+
+            // the edge of other facing its shared vertex, passed as a triangle with a repeated vertex
+
+            const double* t[3] = { get_vertex(mesh, triangle, 0), get_vertex(mesh, triangle, 1), get_vertex(mesh, triangle, 2) };
+            const double* q = get_vertex(mesh, other, (shared_corner + 2) % 3);
+            const double* s[3] = { get_vertex(mesh, other, (shared_corner + 1) % 3), q, q };
+
+            return have_intersection(t, s);
+        }
+
+        bool is_folded(const double a[3], const double b[3], const double c[3], const double d[3]) {
+
+            // triangles (a, b, c) and (b, a, d) lie in one plane with c and d on the same side of ab
+
+            if (RobustPredicates::orient3d(a, b, c, d) != 0) {
+                return false;
+            }
+
+            double e[3] = { b[0] - a[0], b[1] - a[1], b[2] - a[2] };
+            double u[3] = { c[0] - a[0], c[1] - a[1], c[2] - a[2] };
+            double v[3] = { d[0] - a[0], d[1] - a[1], d[2] - a[2] };
+            double n1[3], n2[3];
+            cross_product(e, u, n1);
+            cross_product(e, v, n2);
+
+            return dot_product(n1, n2) > 0;
+        }
+
+        int get_shared_vertices(const IndexedMesh& mesh, std::uint32_t i, std::uint32_t j, int& vi, int& vj) {
+
+            /*
+            Returns the number of common vertices, vi / vj is the corner of i / j that is
+            the shared vertex (one shared) or the one off the shared edge (two shared)
+            */
+
+            const std::uint32_t* ti = mesh.indices + std::size_t(i) * 3;
+            const std::uint32_t* tj = mesh.indices + std::size_t(j) * 3;
+            int shared = 0;
+            vi = vj = 0;
+            bool matched_i[3] = {}, matched_j[3] = {};
+            for (int a = 0; a < 3; a++) {
+                for (int b = 0; b < 3; b++) {
+                    if (ti[a] == tj[b] && !matched_j[b]) {
+                        matched_i[a] = matched_j[b] = true;
+                        shared++;
+                        break;
+                    }
+                }
+            }
+
+            for (int c = 0; c < 3; c++) {
+                if (matched_i[c] == (shared == 1)) {
+                    vi = c;
+                }
+                if (matched_j[c] == (shared == 1)) {
+                    vj = c;
+                }
+            }
+            return shared;
+        }
+
+        bool have_adjacent_intersection(const IndexedMesh& mesh, std::uint32_t i, std::uint32_t j, int shared, int vi, int vj) {
+            if (shared == 3) {
+                return true;
+            }
+
+            if (shared == 1) {
+                return have_intersection_t_opposite_edge(mesh, j, i, vi) || have_intersection_t_opposite_edge(mesh, i, j, vj);
+            }
+
+            // shared edge: vi and vj are the corners not on it
+            return is_folded(get_vertex(mesh, i, (vi + 1) % 3), get_vertex(mesh, i, (vi + 2) % 3), get_vertex(mesh, i, vi), get_vertex(mesh, j, vj));
+        }
+
+        void SelfTest::test_leaf_pair(const Bvh::Node& n1, const Bvh::Node& n2, bool same) {
+            for (std::uint32_t k = n1.first; k < n1.first + n1.count; k++) {
+                for (std::uint32_t l = same ? k + 1 : n2.first; l < n2.first + n2.count; l++) {
+                    std::uint32_t i = bvh.indices()[k];
+                    std::uint32_t j = bvh.indices()[l];
+                    if (i > j) {
+                        std::swap(i, j);
+                    }
+
+                    if (!have_overlap(bvh.get_triangle_box(i), bvh.get_triangle_box(j))) {
+                        continue;
+                    }
+
+                    int vi, vj;
+                    int shared = get_shared_vertices(mesh, i, j, vi, vj);
+                    if (shared == 0) {
+                        tester.add(i, j);
+                    } else if (have_adjacent_intersection(mesh, i, j, shared, vi, vj)) {
+                        TrianglePair pair(i, j);
+                        sink.put(&pair, 1, 0);
+                    }
+                }
+            }
+        }
+    }
+
+    bool have_self_intersection(const IndexedMesh& mesh, const double* triangles, std::uint32_t i, std::uint32_t j) {
+        int vi, vj;
+        int shared = get_shared_vertices(mesh, i, j, vi, vj);
+        if (shared == 0) {
+            const double* ti = triangles + std::size_t(i) * 9;
+            const double* tj = triangles + std::size_t(j) * 9;
+            const double* t1[3] = { ti, ti + 3, ti + 6 };
+            const double* t2[3] = { tj, tj + 3, tj + 6 };
+            return have_intersection(t1, t2);
+        }
+        return have_adjacent_intersection(mesh, i, j, shared, vi, vj);
+    }
+
+    void get_soup(const IndexedMesh& mesh, double* triangles) {
+        for (std::size_t i = 0; i < mesh.triangle_count * 3; i++) {
+            const double* v = mesh.vertices + std::size_t(mesh.indices[i]) * mesh.vertex_stride;
+            std::copy(v, v + 3, triangles + i * 3);
+        }
+    }
+
+    std::vector<TrianglePair> find_self_intersections(const IndexedMesh& mesh) {
+        VectorSink sink;
+        find_self_intersections(mesh, sink);
+        return sink.get_sorted();
+    }
+
+    void find_self_intersections(const IndexedMesh& mesh, PairSink& sink) {
+        SinkSession session(sink, 1);
+        if (mesh.triangle_count < 2) {
+            return;
+        }
+
+        std::vector<double> soup(mesh.triangle_count * 9);
+        get_soup(mesh, soup.data());
+        find_self_intersections(mesh, Bvh(soup.data(), mesh.triangle_count), sink);
+    }
+
+    std::vector<TrianglePair> find_self_intersections(const IndexedMesh& mesh, const Bvh& bvh) {
+        VectorSink sink;
+        sink.start(1);
+        find_self_intersections(mesh, bvh, sink);
+        return sink.get_sorted();
+    }
+
+    void find_self_intersections(const IndexedMesh& mesh, const Bvh& bvh, PairSink& sink) {
+        if (mesh.triangle_count < 2) {
+            return;
+        }
+
+        PairTester tester(bvh.triangles(), bvh.triangles(), &sink);
+        SelfTest self { mesh, bvh, tester, sink };
+        const std::vector<Bvh::Node>& nodes = bvh.nodes();
+
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> stack = { { 0, 0 } };
+        while (!stack.empty()) {
+            std::uint32_t a = stack.back().first;
+            std::uint32_t b = stack.back().second;
+            stack.pop_back();
+
+            const Bvh::Node& n1 = nodes[a];
+            const Bvh::Node& n2 = nodes[b];
+
+            if (a == b) {
+                if (n1.is_leaf()) {
+                    self.test_leaf_pair(n1, n1, true);
+                } else {
+                    stack.emplace_back(n1.first, n1.first);
+                    stack.emplace_back(n1.first + 1, n1.first + 1);
+                    stack.emplace_back(n1.first, n1.first + 1);
+                }
+                continue;
+            }
+
+            if (!have_overlap(n1.box, n2.box)) {
+                continue;
+            }
+
+            if (n1.is_leaf() && n2.is_leaf()) {
+                self.test_leaf_pair(n1, n2, false);
+            } else if (split_first(n1, n2)) {
+                stack.emplace_back(n1.first, b);
+                stack.emplace_back(n1.first + 1, b);
+            } else {
+                stack.emplace_back(a, n2.first);
+                stack.emplace_back(a, n2.first + 1);
+            }
+        }
+
+        tester.flush();
+    }
+}
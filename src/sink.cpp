@@ -0,0 +1,135 @@
+#include <algorithm>
+#include <stdexcept>
+#include "narrow_phase.hpp"
+
+namespace triangle_intersection {
+    RingSink::RingSink(std::size_t capacity) {
+        if (capacity == 0) {
+            throw std::invalid_argument("RingSink: capacity must not be 0");
+        }
+        ring_.resize(capacity);
+    }
+
+    void RingSink::start(unsigned) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        finished_ = false;
+    }
+
+    void RingSink::put(const TrianglePair* pairs, std::size_t count, unsigned) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (count != 0) {
+            not_full_.wait(lock, [this] { return size_ < ring_.size(); });
+
+            std::size_t n = std::min(count, ring_.size() - size_);
+            for (std::size_t i = 0; i < n; i++) {
+                ring_[(head_ + size_ + i) % ring_.size()] = pairs[i];
+            }
+            size_ += n;
+            pairs += n;
+            count -= n;
+            not_empty_.notify_all();
+        }
+    }
+
+    void RingSink::finish() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        finished_ = true;
+        not_empty_.notify_all();
+    }
+
+    std::size_t RingSink::pop(TrianglePair* pairs, std::size_t max_count) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_empty_.wait(lock, [this] { return size_ != 0 || finished_; });
+
+        std::size_t n = std::min(max_count, size_);
+        for (std::size_t i = 0; i < n; i++) {
+            pairs[i] = ring_[(head_ + i) % ring_.size()];
+        }
+        head_ = (head_ + n) % ring_.size();
+        size_ -= n;
+        not_full_.notify_all();
+        return n;
+    }
+
+    void RingSink::reset() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        head_ = size_ = 0;
+        finished_ = false;
+    }
+
+    constexpr std::size_t ArenaSink::BLOCK_SIZE;
+
+    void ArenaSink::start(unsigned worker_count) {
+        if (workers_.size() < worker_count) {
+            workers_.resize(worker_count);
+        }
+    }
+
+    void ArenaSink::put(const TrianglePair* pairs, std::size_t count, unsigned worker) {
+        Worker& w = workers_[worker];
+        while (count != 0) {
+            if (w.used == 0 || w.blocks[w.used - 1].size() == BLOCK_SIZE) {
+                if (w.used == w.blocks.size()) {
+                    w.blocks.emplace_back();
+                    w.blocks.back().reserve(BLOCK_SIZE);
+                }
+                w.used++;
+            }
+
+            std::vector<TrianglePair>& block = w.blocks[w.used - 1];
+            std::size_t n = std::min(count, BLOCK_SIZE - block.size());
+            block.insert(block.end(), pairs, pairs + n);
+            pairs += n;
+            count -= n;
+        }
+    }
+
+    std::size_t ArenaSink::size() const noexcept {
+        std::size_t size = 0;
+        for_each_block([&] (const TrianglePair*, std::size_t count) { size += count; });
+        return size;
+    }
+
+    std::vector<TrianglePair> ArenaSink::get_sorted() const {
+        std::vector<TrianglePair> result;
+        result.reserve(size());
+        for_each_block([&] (const TrianglePair* pairs, std::size_t count) { result.insert(result.end(), pairs, pairs + count); });
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    void ArenaSink::clear() noexcept {
+        for (Worker& w : workers_) {
+            for (std::size_t b = 0; b < w.used; b++) {
+                w.blocks[b].clear();
+            }
+            w.used = 0;
+        }
+    }
+
+    QueryArena::QueryArena() = default;
+    QueryArena::~QueryArena() = default;
+
+    QueryArena::Scratch& QueryArena::get_scratch(unsigned worker) {
+        while (scratch_.size() <= worker) {
+            scratch_.emplace_back(new Scratch());
+        }
+        return *scratch_[worker];
+    }
+
+    std::vector<TrianglePair> VectorSink::get_sorted() {
+        std::size_t size = 0;
+        for (const std::vector<TrianglePair>& f : found_) {
+            size += f.size();
+        }
+
+        std::vector<TrianglePair> result;
+        result.reserve(size);
+        for (const std::vector<TrianglePair>& f : found_) {
+            result.insert(result.end(), f.begin(), f.end());
+        }
+
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+}
@@ -0,0 +1,275 @@
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include "intersection.hpp"
+#include "ray_kernel.hpp"
+#include "static_scene.hpp"
+
+namespace triangle_intersection {
+    namespace {
+        // Ops of ray_kernel.hpp on single doubles, min and max as minpd and maxpd
+        struct Scalar {
+            using scalar = double;
+            using vec = double;
+            using mask = bool;
+            static constexpr std::size_t width = 1;
+
+            static vec load(const double* p) { return *p; }
+            static void store(double* p, vec a) { *p = a; }
+            static vec set1(double v) { return v; }
+            static vec add(vec a, vec b) { return a + b; }
+            static vec sub(vec a, vec b) { return a - b; }
+            static vec mul(vec a, vec b) { return a * b; }
+            static vec div(vec a, vec b) { return a / b; }
+            static vec min(vec a, vec b) { return a < b ? a : b; }
+            static vec max(vec a, vec b) { return a > b ? a : b; }
+            static vec abs(vec a) { return std::abs(a); }
+
+            static mask lt(vec a, vec b) { return a < b; }
+            static mask gt(vec a, vec b) { return a > b; }
+            static mask le(vec a, vec b) { return a <= b; }
+            static mask ge(vec a, vec b) { return a >= b; }
+            static mask eq(vec a, vec b) { return a == b; }
+
+            static mask and_(mask a, mask b) { return a && b; }
+            static mask or_(mask a, mask b) { return a || b; }
+            static mask andnot(mask a, mask b) { return a && !b; }
+            static mask not_(mask a) { return !a; }
+            static bool none(mask a) { return !a; }
+            static unsigned bits(mask a) { return a ? 1 : 0; }
+
+            static vec select(mask m, vec a, vec b) { return m ? a : b; }
+        };
+
+        /*
+        Directions of the point-in-mesh rays, the next one is tried when a ray passes too close to an edge.
+        None of them is parallel to an axis or to a diagonal, grid-aligned meshes rarely line up with them
+        */
+        constexpr double RAY_DIRECTIONS[][3] = {
+            { 0.5773502692, 0.7071067812, 0.4082482905 },
+            { -0.6180339887, 0.3090169944, 0.7236067977 },
+            { 0.2679491924, -0.8660254038, 0.4226182617 },
+            { -0.3826834324, -0.5411961001, -0.7485107482 },
+            { 0.8090169944, 0.1305261922, -0.5735764364 }
+        };
+        constexpr int RAY_DIRECTION_COUNT = sizeof(RAY_DIRECTIONS) / sizeof(RAY_DIRECTIONS[0]);
+
+        SimdIsa get_supported_isa(SimdIsa isa) {
+            return isa > get_simd_isa() ? get_simd_isa() : isa;
+        }
+
+        void count_crossings(const RayScene& scene, const Ray* rays, std::size_t n, std::uint32_t* crossings, std::uint64_t* uncertain, SimdIsa isa) {
+#if defined(TRIANGLE_INTERSECTION_SIMD_X86)
+            if (isa == SimdIsa::Avx512) {
+                count_crossings_avx512(scene, rays, n, crossings, uncertain);
+                return;
+            }
+            if (isa == SimdIsa::Avx2) {
+                count_crossings_avx2(scene, rays, n, crossings, uncertain);
+                return;
+            }
+#endif
+            static_cast<void>(isa);
+            simd::count_crossings<Scalar>(scene, rays, n, crossings, uncertain);
+        }
+
+        bool have_overlap(const StaticScene::Node& n, const Aabb& b) {
+            return n.min[0] <= b.max[0] && b.min[0] <= n.max[0]
+                && n.min[1] <= b.max[1] && b.min[1] <= n.max[1]
+                && n.min[2] <= b.max[2] && b.min[2] <= n.max[2];
+        }
+
+        struct Flattener {
+            const Bvh& bvh;
+            std::vector<StaticScene::Node>& nodes;
+            std::vector<double>& triangles;
+            std::vector<std::uint32_t>& ids;
+
+            void flatten(std::uint32_t node, int depth) {
+                if (depth >= StaticScene::MAX_DEPTH) {
+                    throw std::length_error("StaticScene: hierarchy too deep");
+                }
+
+                const Bvh::Node& source = bvh.nodes()[node];
+                std::size_t i = nodes.size();
+                nodes.emplace_back();
+                std::copy(source.box.min, source.box.min + 3, nodes[i].min);
+                std::copy(source.box.max, source.box.max + 3, nodes[i].max);
+                nodes[i].count = source.count;
+
+                if (source.is_leaf()) {
+                    nodes[i].offset = static_cast<std::uint32_t>(ids.size());
+                    for (std::uint32_t k = source.first; k < source.first + source.count; k++) {
+                        std::uint32_t t = bvh.indices()[k];
+                        ids.push_back(t);
+                        triangles.insert(triangles.end(), bvh.triangles() + std::size_t(t) * 9, bvh.triangles() + std::size_t(t) * 9 + 9);
+                    }
+                    return;
+                }
+
+                flatten(source.first, depth + 1);
+                nodes[i].offset = static_cast<std::uint32_t>(nodes.size());
+                flatten(source.first + 1, depth + 1);
+            }
+        };
+    }
+
+    StaticScene::StaticScene(const double* triangles, std::size_t count) {
+        Bvh bvh(triangles, count);
+        nodes_.reserve(bvh.nodes().size());
+        triangles_.reserve(count * 9);
+        ids_.reserve(count);
+        if (count != 0) {
+            Flattener { bvh, nodes_, triangles_, ids_ }.flatten(0, 0);
+        }
+    }
+
+    template <class Visit>
+    void StaticScene::traverse(const double t[9], Visit& visit) const {
+        if (nodes_.empty()) {
+            return;
+        }
+
+        Aabb box = get_box(t);
+        PreparedTriangle prepared(t);
+        std::uint32_t stack[MAX_DEPTH];
+        int stack_size = 0;
+
+        // children are tested before they are entered, only overlapping ones reach the stack
+
+        if (!have_overlap(nodes_[0], box)) {
+            return;
+        }
+
+        std::uint32_t i = 0;
+        for (;;) {
+            const Node& node = nodes_[i];
+            if (node.is_leaf()) {
+                for (std::uint32_t k = node.offset; k < node.offset + node.count; k++) {
+                    const double* candidate = &triangles_[std::size_t(k) * 9];
+                    if (have_overlap(get_box(candidate), box) && have_intersection(prepared, candidate) && !visit(ids_[k])) {
+                        return;
+                    }
+                }
+            } else {
+                bool left = have_overlap(nodes_[i + 1], box);
+                bool right = have_overlap(nodes_[node.offset], box);
+                if (left) {
+                    if (right) {
+                        stack[stack_size++] = node.offset;
+                    }
+                    i++;
+                    continue;
+                }
+                if (right) {
+                    i = node.offset;
+                    continue;
+                }
+            }
+
+            if (stack_size == 0) {
+                return;
+            }
+            i = stack[--stack_size];
+        }
+    }
+
+    bool StaticScene::have_any_hit(const double t[9]) const noexcept {
+        bool hit = false;
+        auto visit = [&] (std::uint32_t) {
+            hit = true;
+            return false;
+        };
+
+        traverse(t, visit);
+        return hit;
+    }
+
+    std::size_t StaticScene::get_hits(const double t[9], std::uint32_t* hits, std::size_t max_hits) const noexcept {
+        std::size_t count = 0;
+        auto visit = [&] (std::uint32_t id) {
+            hits[count++] = id;
+            return count < max_hits;
+        };
+
+        if (max_hits != 0) {
+            traverse(t, visit);
+        }
+        std::sort(hits, hits + count);
+        return count;
+    }
+
+    void StaticScene::get_all_hits(const double t[9], std::vector<std::uint32_t>& hits) const {
+        std::size_t first = hits.size();
+        auto visit = [&] (std::uint32_t id) {
+            hits.push_back(id);
+            return true;
+        };
+
+        traverse(t, visit);
+        std::sort(hits.begin() + static_cast<std::ptrdiff_t>(first), hits.end());
+    }
+
+    void StaticScene::get_nearest_hits(const Ray* rays, std::size_t n, RayHit* hits) const noexcept {
+        get_nearest_hits(rays, n, hits, get_simd_isa());
+    }
+
+    void StaticScene::get_nearest_hits(const Ray* rays, std::size_t n, RayHit* hits, SimdIsa isa) const noexcept {
+        isa = get_supported_isa(isa);
+        RayScene scene { nodes_.data(), nodes_.size(), triangles_.data(), ids_.data() };
+#if defined(TRIANGLE_INTERSECTION_SIMD_X86)
+        if (isa == SimdIsa::Avx512) {
+            get_nearest_hits_avx512(scene, rays, n, hits);
+            return;
+        }
+        if (isa == SimdIsa::Avx2) {
+            get_nearest_hits_avx2(scene, rays, n, hits);
+            return;
+        }
+#endif
+        simd::get_nearest_hits<Scalar>(scene, rays, n, hits);
+    }
+
+    void StaticScene::classify_points(const double* points, std::size_t n, std::uint64_t* inside) const noexcept {
+        classify_points(points, n, inside, get_simd_isa());
+    }
+
+    void StaticScene::classify_points(const double* points, std::size_t n, std::uint64_t* inside, SimdIsa isa) const noexcept {
+        for (std::size_t i = 0; i < (n + 63) / 64; i++) {
+            inside[i] = 0;
+        }
+
+        // 64 points at a time, one word of inside and of uncertain
+
+        isa = get_supported_isa(isa);
+        RayScene scene { nodes_.data(), nodes_.size(), triangles_.data(), ids_.data() };
+        Ray rays[64];
+        std::uint32_t crossings[64];
+        for (std::size_t first = 0; first < n; first += 64) {
+            std::size_t count = std::min<std::size_t>(n - first, 64);
+            for (std::size_t i = 0; i < count; i++) {
+                std::copy(points + (first + i) * 3, points + (first + i) * 3 + 3, rays[i].origin);
+                std::copy(RAY_DIRECTIONS[0], RAY_DIRECTIONS[0] + 3, rays[i].direction);
+                rays[i].max_distance = std::numeric_limits<double>::infinity();
+            }
+
+            std::uint64_t uncertain = 0;
+            count_crossings(scene, rays, count, crossings, &uncertain, isa);
+
+            for (std::size_t i = 0; i < count; i++) {
+                for (int d = 1; ((uncertain >> i) & 1) && d < RAY_DIRECTION_COUNT; d++) {
+                    std::uint64_t again = 0;
+                    std::copy(RAY_DIRECTIONS[d], RAY_DIRECTIONS[d] + 3, rays[i].direction);
+                    count_crossings(scene, rays + i, 1, crossings + i, &again, isa);
+                    if (again == 0) {
+                        uncertain &= ~(std::uint64_t(1) << i);
+                    }
+                }
+                if (crossings[i] % 2 == 1) {
+                    inside[(first + i) / 64] |= std::uint64_t(1) << ((first + i) % 64);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,194 @@
+#include "stats_private.hpp"
+
+#if defined(TRIANGLE_INTERSECTION_STATS) || defined(TRIANGLE_INTERSECTION_STATS_TIMERS)
+
+#include <algorithm>
+#include <mutex>
+#include <vector>
+
+#if defined(__x86_64__) || defined(_M_X64)
+#ifdef _MSC_VER
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#elif !defined(__aarch64__)
+#include <chrono>
+#endif
+
+namespace triangle_intersection {
+    namespace stats {
+        namespace {
+            struct Registry {
+                std::mutex mutex;
+                std::vector<ThreadStats*> threads;
+                std::uint64_t count[BRANCH_COUNT] = {}; // threads that exited
+                std::uint64_t ticks[BRANCH_COUNT] = {};
+            };
+
+            Registry& get_registry() {
+                // never destroyed: threads may still exit after the static destructors ran
+                static Registry* registry = new Registry;
+                return *registry;
+            }
+
+            // the counts of t since the last reset, under the mutex of the registry
+            void add_to(BranchStats& s, const ThreadStats& t) {
+                for (std::size_t i = 0; i < BRANCH_COUNT; i++) {
+                    s.count[i] += t.count[i].load(std::memory_order_relaxed) - t.reset_count[i];
+                    s.ticks[i] += t.ticks[i].load(std::memory_order_relaxed) - t.reset_ticks[i];
+                }
+            }
+
+            struct ThreadSlot {
+                ThreadStats stats;
+                bool registered = false;
+
+                ThreadSlot() {
+                    for (std::size_t i = 0; i < BRANCH_COUNT; i++) {
+                        stats.count[i].store(0, std::memory_order_relaxed);
+                        stats.ticks[i].store(0, std::memory_order_relaxed);
+                        stats.reset_count[i] = stats.reset_ticks[i] = 0;
+                    }
+
+                    try {
+                        Registry& r = get_registry();
+                        std::lock_guard<std::mutex> lock(r.mutex);
+                        r.threads.push_back(&stats);
+                        registered = true;
+                    } catch (...) {
+                        // the thread still counts, its numbers are just missing from the snapshots
+                    }
+                }
+
+                ~ThreadSlot() {
+                    if (!registered) {
+                        return;
+                    }
+
+                    Registry& r = get_registry();
+                    std::lock_guard<std::mutex> lock(r.mutex);
+                    BranchStats s {};
+                    add_to(s, stats);
+                    for (std::size_t i = 0; i < BRANCH_COUNT; i++) {
+                        r.count[i] += s.count[i];
+                        r.ticks[i] += s.ticks[i];
+                    }
+                    r.threads.erase(std::find(r.threads.begin(), r.threads.end(), &stats));
+                }
+            };
+        }
+
+        ThreadStats& get_thread_stats() {
+            thread_local ThreadSlot slot;
+            return slot.stats;
+        }
+
+        std::uint64_t get_ticks() noexcept {
+#if defined(__x86_64__) || defined(_M_X64)
+            return __rdtsc();
+#elif defined(__aarch64__)
+            std::uint64_t t;
+            asm volatile("mrs %0, cntvct_el0" : "=r"(t));
+            return t;
+#else
+            return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+        }
+    }
+
+    bool have_branch_stats() noexcept {
+        return true;
+    }
+
+    bool have_branch_timers() noexcept {
+#ifdef TRIANGLE_INTERSECTION_STATS_TIMERS
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    BranchStats get_branch_stats() {
+        BranchStats s {};
+        stats::Registry& r = stats::get_registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (std::size_t i = 0; i < BRANCH_COUNT; i++) {
+            s.count[i] = r.count[i];
+            s.ticks[i] = r.ticks[i];
+        }
+        for (const stats::ThreadStats* t : r.threads) {
+            stats::add_to(s, *t);
+        }
+        return s;
+    }
+
+    BranchStats get_thread_branch_stats() {
+        BranchStats s {};
+        const stats::ThreadStats& t = stats::get_thread_stats();
+        stats::Registry& r = stats::get_registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        stats::add_to(s, t);
+        return s;
+    }
+
+    void reset_branch_stats() {
+        stats::Registry& r = stats::get_registry();
+        std::lock_guard<std::mutex> lock(r.mutex);
+        for (std::size_t i = 0; i < BRANCH_COUNT; i++) {
+            r.count[i] = 0;
+            r.ticks[i] = 0;
+        }
+        for (stats::ThreadStats* t : r.threads) {
+            for (std::size_t i = 0; i < BRANCH_COUNT; i++) {
+                t->reset_count[i] = t->count[i].load(std::memory_order_relaxed);
+                t->reset_ticks[i] = t->ticks[i].load(std::memory_order_relaxed);
+            }
+        }
+    }
+}
+
+#else
+
+namespace triangle_intersection {
+    bool have_branch_stats() noexcept {
+        return false;
+    }
+
+    bool have_branch_timers() noexcept {
+        return false;
+    }
+
+    BranchStats get_branch_stats() {
+        return {};
+    }
+
+    BranchStats get_thread_branch_stats() {
+        return {};
+    }
+
+    void reset_branch_stats() {}
+}
+
+#endif
+
+namespace triangle_intersection {
+    const char* get_branch_name(Branch b) noexcept {
+        static const char* const names[BRANCH_COUNT] = {
+            "point-point",
+            "point-segment",
+            "point-triangle",
+            "segment-segment",
+            "segment-triangle",
+            "coplanar",
+            "first-plane-reject",
+            "second-plane-reject",
+            "interval",
+            "error"
+        };
+
+        std::size_t i = static_cast<std::size_t>(b);
+        return i < BRANCH_COUNT ? names[i] : "unknown";
+    }
+}
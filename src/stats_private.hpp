@@ -0,0 +1,64 @@
+#pragma once
+
+#include "stats.hpp"
+
+/*
+Kernel probes. A function declares TRIANGLE_INTERSECTION_PROBE at its start
+and wraps every returned value in TRIANGLE_INTERSECTION_EXIT(branch, value).
+Without TRIANGLE_INTERSECTION_STATS both expand to nothing but the value
+*/
+
+#if defined(TRIANGLE_INTERSECTION_STATS) || defined(TRIANGLE_INTERSECTION_STATS_TIMERS)
+
+#include <atomic>
+
+namespace triangle_intersection {
+    namespace stats {
+        struct ThreadStats {
+            // only the owner thread writes, the atomics let other threads take snapshots
+            std::atomic<std::uint64_t> count[BRANCH_COUNT];
+            std::atomic<std::uint64_t> ticks[BRANCH_COUNT];
+            // the counters as of the last reset_branch_stats, under the mutex of the registry: a reset never writes the counters
+            std::uint64_t reset_count[BRANCH_COUNT];
+            std::uint64_t reset_ticks[BRANCH_COUNT];
+        };
+
+        ThreadStats& get_thread_stats();
+        std::uint64_t get_ticks() noexcept;
+
+        inline void add(std::atomic<std::uint64_t>& counter, std::uint64_t value) {
+            counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+        }
+
+        class Probe {
+        public:
+#ifdef TRIANGLE_INTERSECTION_STATS_TIMERS
+            Probe() noexcept : start_(get_ticks()) {}
+#endif
+
+            bool exit(Branch b, bool result) noexcept {
+                ThreadStats& s = get_thread_stats();
+                add(s.count[static_cast<std::size_t>(b)], 1);
+#ifdef TRIANGLE_INTERSECTION_STATS_TIMERS
+                add(s.ticks[static_cast<std::size_t>(b)], get_ticks() - start_);
+#endif
+                return result;
+            }
+
+        private:
+#ifdef TRIANGLE_INTERSECTION_STATS_TIMERS
+            std::uint64_t start_;
+#endif
+        };
+    }
+}
+
+#define TRIANGLE_INTERSECTION_PROBE ::triangle_intersection::stats::Probe stats_probe
+#define TRIANGLE_INTERSECTION_EXIT(branch, value) stats_probe.exit(::triangle_intersection::Branch::branch, (value))
+
+#else
+
+#define TRIANGLE_INTERSECTION_PROBE static_cast<void>(0)
+#define TRIANGLE_INTERSECTION_EXIT(branch, value) (value)
+
+#endif
@@ -0,0 +1,384 @@
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include "narrow_phase.hpp"
+#include "validation.hpp"
+
+namespace triangle_intersection {
+    namespace {
+        // above one changed triangle in REBUILD_FRACTION, building the hierarchy again and testing every pair is cheaper
+        constexpr std::size_t REBUILD_FRACTION = 8;
+
+        /*
+        Session file: "TIVS", version (4 bytes), content hash, triangle count and pair count (8 bytes each),
+        all little-endian, then the sorted pairs as pairs of varints: the step of the first index and,
+        if it moved, the step from it to the second index, otherwise the step of the second index
+        */
+        const char MAGIC[4] = { 'T', 'I', 'V', 'S' };
+        constexpr std::uint32_t VERSION = 1;
+
+        class Hasher {
+        public:
+            void add(std::uint64_t x) {
+                x *= 0x9e3779b97f4a7c15;
+                x ^= x >> 32;
+                hash_ = (hash_ ^ x) * 0xff51afd7ed558ccd;
+                hash_ ^= hash_ >> 29;
+            }
+
+            void add_coordinate(double x) {
+                std::uint64_t bits;
+                std::memcpy(&bits, &x, sizeof(bits));
+                add(bits);
+            }
+
+            std::uint64_t get() const { return hash_; }
+
+        private:
+            std::uint64_t hash_ = 0xcbf29ce484222325;
+        };
+
+        std::vector<double> make_soup(const IndexedMesh& mesh) {
+            std::vector<double> triangles(mesh.triangle_count * 9);
+            get_soup(mesh, triangles.data());
+            return triangles;
+        }
+
+        void put(std::vector<unsigned char>& data, std::uint64_t value, int size) {
+            for (int i = 0; i < size; i++) {
+                data.push_back(static_cast<unsigned char>(value >> (8 * i)));
+            }
+        }
+
+        void put_varint(std::vector<unsigned char>& data, std::uint32_t value) {
+            while (value >= 0x80) {
+                data.push_back(static_cast<unsigned char>(value | 0x80));
+                value >>= 7;
+            }
+            data.push_back(static_cast<unsigned char>(value));
+        }
+
+        struct Reader {
+            const std::vector<unsigned char>& data;
+            const std::string& path;
+            std::size_t position;
+
+            void fail() const {
+                throw std::runtime_error(path + " is not a valid validation session file");
+            }
+
+            std::uint64_t get(int size) {
+                if (data.size() - position < static_cast<std::size_t>(size)) {
+                    fail();
+                }
+                std::uint64_t value = 0;
+                for (int i = 0; i < size; i++) {
+                    value |= std::uint64_t(data[position++]) << (8 * i);
+                }
+                return value;
+            }
+
+            std::uint32_t get_varint() {
+                std::uint64_t value = 0;
+                for (int shift = 0; shift < 35; shift += 7) {
+                    if (position == data.size()) {
+                        fail();
+                    }
+                    unsigned char byte = data[position++];
+                    value |= std::uint64_t(byte & 0x7f) << shift;
+                    if ((byte & 0x80) == 0) {
+                        if (value > 0xffffffff) {
+                            fail();
+                        }
+                        return static_cast<std::uint32_t>(value);
+                    }
+                }
+                fail();
+                return 0;
+            }
+        };
+
+        std::vector<TrianglePair> get_difference(const std::vector<TrianglePair>& a, const std::vector<TrianglePair>& b) {
+            std::vector<TrianglePair> result;
+            std::set_difference(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(result));
+            return result;
+        }
+
+        void remove_all(std::vector<std::uint32_t>& list, std::uint32_t value) {
+            list.erase(std::remove(list.begin(), list.end(), value), list.end());
+        }
+    }
+
+    std::uint64_t get_content_hash(const IndexedMesh& mesh) noexcept {
+        Hasher hasher;
+        hasher.add(mesh.triangle_count);
+        for (std::size_t t = 0; t < mesh.triangle_count; t++) {
+            const std::uint32_t* indices = mesh.indices + t * 3;
+            for (int c = 0; c < 3; c++) {
+                const double* v = mesh.vertices + std::size_t(indices[c]) * mesh.vertex_stride;
+                hasher.add_coordinate(v[0]);
+                hasher.add_coordinate(v[1]);
+                hasher.add_coordinate(v[2]);
+            }
+            for (int c = 0; c < 3; c++) {
+                hasher.add(indices[c]);
+            }
+        }
+        return hasher.get();
+    }
+
+    ValidationSession::ValidationSession(const IndexedMesh& mesh)
+        : triangles_(make_soup(mesh)), indices_(mesh.indices, mesh.indices + mesh.triangle_count * 3),
+          bvh_(triangles_.data(), mesh.triangle_count) {
+        index_vertices(mesh.vertex_count);
+        set_intersections(find_self_intersections(mesh, bvh_), true);
+    }
+
+    ValidationSession::ValidationSession(const IndexedMesh& mesh, const std::string& path)
+        : triangles_(make_soup(mesh)), indices_(mesh.indices, mesh.indices + mesh.triangle_count * 3),
+          bvh_(triangles_.data(), mesh.triangle_count) {
+        index_vertices(mesh.vertex_count);
+
+        std::ifstream in(path, std::ios::binary);
+        if (!in) {
+            throw std::runtime_error("cannot open " + path);
+        }
+        std::vector<unsigned char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+        Reader reader { data, path, 0 };
+        if (data.size() < sizeof(MAGIC) || std::memcmp(data.data(), MAGIC, sizeof(MAGIC)) != 0) {
+            reader.fail();
+        }
+        reader.position = sizeof(MAGIC);
+        if (reader.get(4) != VERSION) {
+            throw std::runtime_error(path + " was saved by another version of the library");
+        }
+        std::uint64_t hash = reader.get(8);
+        std::uint64_t triangle_count = reader.get(8);
+        if (triangle_count != size() || hash != get_content_hash()) {
+            throw std::runtime_error(path + " was saved for another mesh");
+        }
+
+        std::uint64_t count = reader.get(8);
+        if (count > data.size()) {
+            reader.fail();
+        }
+        std::vector<TrianglePair> pairs;
+        pairs.reserve(static_cast<std::size_t>(count));
+        TrianglePair previous(0, 0);
+        for (std::uint64_t k = 0; k < count; k++) {
+            std::uint32_t step = reader.get_varint();
+            std::uint32_t second = reader.get_varint();
+            TrianglePair p = step == 0 ? TrianglePair(previous.first, previous.second + second)
+                                       : TrianglePair(previous.first + step, previous.first + step + second);
+            if (p.first < previous.first || p.second <= p.first || p.second >= size() || (k != 0 && p <= previous)) {
+                reader.fail();
+            }
+            pairs.push_back(p);
+            previous = p;
+        }
+        set_intersections(pairs, true);
+    }
+
+    ValidationSession::Changes ValidationSession::update(const IndexedMesh& mesh, const std::uint32_t* changed_vertices, std::size_t changed_vertex_count,
+                                                         const std::uint32_t* changed_triangles, std::size_t changed_triangle_count) {
+        std::size_t old_count = size();
+        std::size_t count = mesh.triangle_count;
+        if (count < old_count) {
+            throw std::invalid_argument("triangles cannot be removed from a validation session");
+        }
+        if (mesh.vertex_count > vertex_triangles_.size()) {
+            vertex_triangles_.resize(mesh.vertex_count);
+        }
+
+        // triangles whose indices changed move to the lists of their new vertices, appended ones join them
+
+        std::vector<std::uint32_t> changed;
+        for (std::size_t k = 0; k < changed_triangle_count; k++) {
+            std::uint32_t t = changed_triangles[k];
+            if (t >= old_count) {
+                continue;
+            }
+            for (int c = 0; c < 3; c++) {
+                remove_all(vertex_triangles_[indices_[std::size_t(t) * 3 + c]], t);
+            }
+            for (int c = 0; c < 3; c++) {
+                indices_[std::size_t(t) * 3 + c] = mesh.indices[std::size_t(t) * 3 + c];
+                vertex_triangles_[indices_[std::size_t(t) * 3 + c]].push_back(t);
+            }
+            changed.push_back(t);
+        }
+
+        indices_.insert(indices_.end(), mesh.indices + old_count * 3, mesh.indices + count * 3);
+        partners_.resize(count);
+        for (std::size_t t = old_count; t < count; t++) {
+            for (int c = 0; c < 3; c++) {
+                vertex_triangles_[indices_[t * 3 + c]].push_back(static_cast<std::uint32_t>(t));
+            }
+            changed.push_back(static_cast<std::uint32_t>(t));
+        }
+
+        for (std::size_t k = 0; k < changed_vertex_count; k++) {
+            const std::vector<std::uint32_t>& users = vertex_triangles_[changed_vertices[k]];
+            changed.insert(changed.end(), users.begin(), users.end());
+        }
+        std::sort(changed.begin(), changed.end());
+        changed.erase(std::unique(changed.begin(), changed.end()), changed.end());
+
+        triangles_.resize(count * 9);
+        for (std::uint32_t t : changed) {
+            for (int c = 0; c < 3; c++) {
+                const double* v = mesh.vertices + std::size_t(indices_[std::size_t(t) * 3 + c]) * mesh.vertex_stride;
+                std::copy(v, v + 3, &triangles_[std::size_t(t) * 9 + c * 3]);
+            }
+        }
+
+        Changes changes;
+        if (count != old_count || changed.size() * REBUILD_FRACTION > count) {
+
+            // the copy of the triangles may have moved, the hierarchy is built on it again
+
+            std::vector<TrianglePair> before = get_intersections();
+            bvh_ = Bvh(triangles_.data(), count);
+            std::vector<TrianglePair> after = find_self_intersections(mesh, bvh_);
+
+            changes.added = get_difference(after, before);
+            changes.removed = get_difference(before, after);
+            set_intersections(changes.removed, false);
+            set_intersections(changes.added, true);
+            return changes;
+        }
+
+        std::vector<TrianglePair> before;
+        for (std::uint32_t t : changed) {
+            for (std::uint32_t other : partners_[t]) {
+                before.emplace_back(std::min(t, other), std::max(t, other));
+            }
+        }
+        std::sort(before.begin(), before.end());
+        before.erase(std::unique(before.begin(), before.end()), before.end());
+
+        // a pair of two changed triangles is found from both, only the lower one tests it
+
+        bvh_.refit(changed.data(), changed.size());
+        const std::vector<Bvh::Node>& nodes = bvh_.nodes();
+        std::vector<TrianglePair> after;
+        std::vector<std::uint32_t> stack;
+        for (std::uint32_t t : changed) {
+            const Aabb& box = bvh_.get_triangle_box(t);
+            stack.assign(1, 0);
+            while (!stack.empty()) {
+                const Bvh::Node& node = nodes[stack.back()];
+                stack.pop_back();
+                if (!have_overlap(node.box, box)) {
+                    continue;
+                }
+                if (!node.is_leaf()) {
+                    stack.push_back(node.first);
+                    stack.push_back(node.first + 1);
+                    continue;
+                }
+
+                for (std::uint32_t k = node.first; k < node.first + node.count; k++) {
+                    std::uint32_t other = bvh_.indices()[k];
+                    if (other == t || (other < t && std::binary_search(changed.begin(), changed.end(), other))) {
+                        continue;
+                    }
+                    if (!have_overlap(box, bvh_.get_triangle_box(other))) {
+                        continue;
+                    }
+                    std::uint32_t i = std::min(t, other), j = std::max(t, other);
+                    if (have_self_intersection(mesh, triangles_.data(), i, j)) {
+                        after.emplace_back(i, j);
+                    }
+                }
+            }
+        }
+        std::sort(after.begin(), after.end());
+
+        changes.added = get_difference(after, before);
+        changes.removed = get_difference(before, after);
+        set_intersections(changes.removed, false);
+        set_intersections(changes.added, true);
+        return changes;
+    }
+
+    std::vector<TrianglePair> ValidationSession::get_intersections() const {
+        std::vector<TrianglePair> result;
+        result.reserve(intersection_count_);
+        for (std::uint32_t i = 0; i < partners_.size(); i++) {
+            for (std::uint32_t j : partners_[i]) {
+                if (i < j) {
+                    result.emplace_back(i, j);
+                }
+            }
+        }
+        std::sort(result.begin(), result.end());
+        return result;
+    }
+
+    std::uint64_t ValidationSession::get_content_hash() const noexcept {
+        Hasher hasher;
+        hasher.add(size());
+        for (std::size_t t = 0; t < size(); t++) {
+            for (int k = 0; k < 9; k++) {
+                hasher.add_coordinate(triangles_[t * 9 + k]);
+            }
+            for (int c = 0; c < 3; c++) {
+                hasher.add(indices_[t * 3 + c]);
+            }
+        }
+        return hasher.get();
+    }
+
+    void ValidationSession::save(const std::string& path) const {
+        std::vector<unsigned char> data(MAGIC, MAGIC + sizeof(MAGIC));
+        put(data, VERSION, 4);
+        put(data, get_content_hash(), 8);
+        put(data, size(), 8);
+        put(data, intersection_count_, 8);
+
+        TrianglePair previous(0, 0);
+        for (const TrianglePair& p : get_intersections()) {
+            if (p.first == previous.first) {
+                put_varint(data, 0);
+                put_varint(data, p.second - previous.second);
+            } else {
+                put_varint(data, p.first - previous.first);
+                put_varint(data, p.second - p.first);
+            }
+            previous = p;
+        }
+
+        std::ofstream out(path, std::ios::binary);
+        out.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size()));
+        if (!out) {
+            throw std::runtime_error("cannot write " + path);
+        }
+    }
+
+    void ValidationSession::index_vertices(std::size_t vertex_count) {
+        vertex_triangles_.assign(vertex_count, std::vector<std::uint32_t>());
+        for (std::size_t i = 0; i < indices_.size(); i++) {
+            vertex_triangles_[indices_[i]].push_back(static_cast<std::uint32_t>(i / 3));
+        }
+        partners_.assign(size(), std::vector<std::uint32_t>());
+        intersection_count_ = 0;
+    }
+
+    void ValidationSession::set_intersections(const std::vector<TrianglePair>& pairs, bool intersect) {
+        for (const TrianglePair& p : pairs) {
+            if (intersect) {
+                partners_[p.first].push_back(p.second);
+                partners_[p.second].push_back(p.first);
+                intersection_count_++;
+            } else {
+                remove_all(partners_[p.first], p.second);
+                remove_all(partners_[p.second], p.first);
+                intersection_count_--;
+            }
+        }
+    }
+}
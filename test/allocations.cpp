@@ -0,0 +1,117 @@
+#include <gtest/gtest.h>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include <vector>
+#include "mesh.hpp"
+
+// A binary of its own: every form of the global operator new below counts, for every test of the binary
+
+using namespace triangle_intersection;
+
+static std::atomic<std::size_t> allocation_count { 0 };
+
+static void* allocate(std::size_t size) noexcept {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    return std::malloc(size ? size : 1);
+}
+
+void* operator new(std::size_t size) {
+    if (void* p = allocate(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    if (void* p = allocate(size)) {
+        return p;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return allocate(size);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, const std::nothrow_t&) noexcept {
+    std::free(p);
+}
+
+static std::vector<double> random_soup(std::size_t n, double extent, double size, unsigned seed) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> position(0, extent);
+    std::uniform_real_distribution<double> offset(-size, size);
+
+    std::vector<double> t(n * 9);
+    for (std::size_t i = 0; i < n; i++) {
+        double c[3] = { position(gen), position(gen), position(gen) };
+        for (int k = 0; k < 9; k++) {
+            t[i * 9 + k] = c[k % 3] + offset(gen);
+        }
+    }
+
+    return t;
+}
+
+TEST(Sink, SteadyStateAllocatesNothing) {
+    std::vector<double> m1 = random_soup(3000, 20, 1, 42);
+    std::vector<double> m2 = random_soup(2000, 20, 1, 43);
+    Bvh b1(m1.data(), 3000), b2(m2.data(), 2000);
+    std::vector<TrianglePair> expected = intersect_meshes(b1, b2);
+    std::vector<TrianglePair> candidates;
+    for (std::uint32_t i = 0; i < 2000; i++) {
+        for (std::uint32_t j = 0; j < 5; j++) {
+            candidates.emplace_back((i * 7 + j * 13) % 3000, i);
+        }
+    }
+    std::vector<TrianglePair> expected_pairs = intersect_pairs(m1.data(), m2.data(), candidates, ParallelOptions { 1 });
+    ASSERT_FALSE(expected.empty());
+
+    QueryArena arena;
+    ArenaSink arena_sink;
+    std::size_t called = 0;
+    auto callback = make_callback_sink([&] (const TrianglePair*, std::size_t count, unsigned) { called += count; });
+    auto run = [&] {
+        arena_sink.clear();
+        called = 0;
+        intersect_meshes(b1, b2, arena_sink, arena);
+        intersect_pairs(m1.data(), m2.data(), candidates.data(), candidates.size(), arena_sink, arena, ParallelOptions { 1 });
+        intersect_meshes(b1, b2, callback, arena);
+    };
+
+    run();
+    std::size_t before = allocation_count.load();
+    run();
+    std::size_t allocations = allocation_count.load() - before;
+
+    ASSERT_NE(before, 0u); // the counting operator new is in use
+    ASSERT_EQ(allocations, 0u);
+    ASSERT_EQ(arena_sink.size(), expected.size() + expected_pairs.size());
+    ASSERT_EQ(called, expected.size());
+}
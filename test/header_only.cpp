@@ -0,0 +1,62 @@
+#include <gtest/gtest.h>
+#include "intersection.hpp"
+
+// Built against TriangleIntersectionHeaderOnly, not the library: every kernel call below is defined inline
+
+using namespace triangle_intersection;
+
+TEST(HeaderOnly, Intersection) {
+    double t1[] = { -78, 99, 40, -21, -72, 63, -19, -78, -83 };
+    double t2[] = { 9, 5, -21, 96, 77, -51, -95, -1, -16 };
+    double t3[] = { -1, 4, 3, 3, 5, -2, -4, -7, 1 };
+    double t4[] = { 3, -5, -4, -2.5, -5.7, 0, 6, 1.6, 2 };
+
+    ASSERT_TRUE(have_intersection(t1, t2));
+    ASSERT_FALSE(have_intersection(t3, t4));
+}
+
+TEST(HeaderOnly, Coplanar) {
+    double t1[] = { 3, 3, 4, 3, -1, 4, 1.5, 1.5, 4 };
+    double t2[] = { 10, 5, 4, -1, 0, 4, 7, -3, 4 };
+    double t3[] = { 5, 10, 4, 4, 0, 4, 7, -3, 4 };
+
+    ASSERT_TRUE(have_intersection(t1, t2));
+    ASSERT_FALSE(have_intersection(t1, t3));
+}
+
+TEST(HeaderOnly, Degenerate) {
+    double t[] = { 0, 0, 0, 4, 0, 0, 0, 4, 0 };
+    double segment[] = { 1, 1, -1, 1, 1, 1, 1, 1, 1 };
+    double point[] = { 1, 1, 0, 1, 1, 0, 1, 1, 0 };
+    double outside[] = { 5, 5, 0, 5, 5, 0, 5, 5, 0 };
+
+    ASSERT_TRUE(have_intersection(t, segment));
+    ASSERT_TRUE(have_intersection(t, point));
+    ASSERT_FALSE(have_intersection(t, outside));
+}
+
+TEST(HeaderOnly, Predicates) {
+    double a[] = { 0, 0, 0 };
+    double b[] = { 1, 0, 0 };
+    double c[] = { 0, 1, 0 };
+    double d[] = { 0, 0, 1 };
+    double e[] = { 0.5, 0.5, 0 };
+
+    ASSERT_NE(0, RobustPredicates::orient3d(a, b, c, d));
+    ASSERT_EQ(0, RobustPredicates::orient3d(a, b, c, e));
+    ASSERT_GT(RobustPredicates::orient2d(a, b, c), 0);
+
+    const double* t1[3] = { a, b, c };
+    const double* t2[3] = { e, d, d };
+    ASSERT_TRUE(have_intersection<FastPredicates>(t1, t2));
+}
+
+TEST(HeaderOnly, Output) {
+    double t1[] = { 0, 0, 0, 4, 0, 0, 0, 4, 0 };
+    double t2[] = { 1, 1, -1, 1, 1, 1, 3, 1, 0 };
+    Intersection result;
+
+    ASSERT_TRUE(have_intersection(t1, t2, result));
+    ASSERT_EQ(Intersection::Kind::Segment, result.kind);
+    ASSERT_EQ(2u, result.count);
+}
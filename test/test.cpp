@@ -1,5 +1,26 @@
 #include <gtest/gtest.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <iterator>
+#include <fstream>
+#include <limits>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "dynamic_scene.hpp"
 #include "intersection.hpp"
+#include "kernels.hpp"
+#include "mesh.hpp"
+#include "mesh_io.hpp"
+#include "pipeline.hpp"
+#include "predicates.hpp"
+#include "static_scene.hpp"
+#include "compact_scene.hpp"
+#include "stats.hpp"
+#include "validation.hpp"
 
 using namespace triangle_intersection;
 
@@ -169,4 +190,1884 @@ TEST(Intersection_Degenerate, NoIntersectionPointPoint) {
     double t2[] = { 5.45, -1.77, -0.68, 5.45, -1.77, -0.68, 5.45, -1.77, -0.68 };
 
     ASSERT_FALSE(have_intersection(t1, t2));
-}
\ No newline at end of file
+}
+
+static std::vector<double> random_triangles(std::size_t n, unsigned seed) {
+
+    /*
+    Mixes small integer coordinates (lots of touching, coplanar and degenerate triangles)
+    with arbitrary ones
+    */
+
+    std::mt19937 gen(seed);
+    std::uniform_int_distribution<int> grid(-2, 2);
+    std::uniform_real_distribution<double> real(-10, 10);
+
+    std::vector<double> t(n * 9);
+    for (std::size_t i = 0; i < n; i++) {
+        bool on_grid = i % 2 == 0;
+        for (int k = 0; k < 9; k++) {
+            t[i * 9 + k] = on_grid ? grid(gen) : real(gen);
+        }
+    }
+
+    return t;
+}
+
+TEST(Batch, MatchesScalar) {
+    const std::size_t n = 4003;
+    std::vector<double> a = random_triangles(n, 1);
+    std::vector<double> b = random_triangles(n, 2);
+
+    std::vector<double> soa_a(n * 9), soa_b(n * 9);
+    TriangleBatch ba, bb;
+    for (int k = 0; k < 9; k++) {
+        for (std::size_t i = 0; i < n; i++) {
+            soa_a[k * n + i] = a[i * 9 + k];
+            soa_b[k * n + i] = b[i * 9 + k];
+        }
+        ba.coords[k] = soa_a.data() + k * n;
+        bb.coords[k] = soa_b.data() + k * n;
+    }
+
+    std::vector<bool> expected(n);
+    for (std::size_t i = 0; i < n; i++) {
+        double t1[9], t2[9];
+        std::copy(a.begin() + i * 9, a.begin() + i * 9 + 9, t1);
+        std::copy(b.begin() + i * 9, b.begin() + i * 9 + 9, t2);
+        expected[i] = have_intersection(t1, t2);
+    }
+
+    for (SimdIsa isa : { SimdIsa::Scalar, SimdIsa::Avx2, SimdIsa::Avx512 }) {
+        if (isa > get_simd_isa()) {
+            continue;
+        }
+
+        std::vector<std::uint64_t> mask((n + 63) / 64, ~std::uint64_t(0));
+        have_intersection_batch(ba, bb, n, mask.data(), isa);
+
+        for (std::size_t i = 0; i < n; i++) {
+            ASSERT_EQ(expected[i], ((mask[i / 64] >> (i % 64)) & 1) != 0) << "pair " << i << ", isa " << static_cast<int>(isa);
+        }
+    }
+}
+
+TEST(Batch, DegeneratePairs) {
+
+    // unmarked pairs are regular, every kernel without the degeneracy tests gives the answer of have_intersection on them
+
+    const std::size_t n = 4003;
+    std::vector<double> a = random_triangles(n, 42);
+    std::vector<double> b = random_triangles(n, 43);
+
+    std::vector<double> soa_a(n * 9), soa_b(n * 9);
+    TriangleBatch ba, bb;
+    for (int k = 0; k < 9; k++) {
+        for (std::size_t i = 0; i < n; i++) {
+            soa_a[k * n + i] = a[i * 9 + k];
+            soa_b[k * n + i] = b[i * 9 + k];
+        }
+        ba.coords[k] = soa_a.data() + k * n;
+        bb.coords[k] = soa_b.data() + k * n;
+    }
+
+    std::vector<bool> expected(n), is_degenerate(n);
+    std::size_t degenerate_count = 0;
+    for (std::size_t i = 0; i < n; i++) {
+        double t1[9], t2[9];
+        std::copy(a.begin() + i * 9, a.begin() + i * 9 + 9, t1);
+        std::copy(b.begin() + i * 9, b.begin() + i * 9 + 9, t2);
+        expected[i] = have_intersection(t1, t2);
+        is_degenerate[i] = PreparedTriangle(t1).kind != TriangleKind::Triangle || PreparedTriangle(t2).kind != TriangleKind::Triangle;
+        degenerate_count += is_degenerate[i];
+    }
+    ASSERT_GT(degenerate_count, 0u);
+
+    for (SimdIsa isa : { SimdIsa::Scalar, SimdIsa::Avx2, SimdIsa::Avx512 }) {
+        if (isa > get_simd_isa()) {
+            continue;
+        }
+
+        std::vector<std::uint64_t> degenerate((n + 63) / 64, ~std::uint64_t(0));
+        std::size_t count = get_degenerate_pairs(ba, bb, n, degenerate.data(), isa);
+        std::vector<std::uint64_t> mask((n + 63) / 64, ~std::uint64_t(0));
+        have_intersection_batch(ba, bb, n, mask.data(), isa, AssumeNonDegenerate());
+
+        std::size_t marked = 0;
+        for (std::size_t i = 0; i < n; i++) {
+            bool is_marked = ((degenerate[i / 64] >> (i % 64)) & 1) != 0;
+            marked += is_marked;
+            if (is_degenerate[i]) {
+                ASSERT_TRUE(is_marked) << "pair " << i << ", isa " << static_cast<int>(isa);
+            } else if (!is_marked) {
+                ASSERT_EQ(expected[i], have_intersection(&a[i * 9], &b[i * 9], AssumeNonDegenerate())) << "pair " << i;
+                ASSERT_EQ(expected[i], ((mask[i / 64] >> (i % 64)) & 1) != 0) << "pair " << i << ", isa " << static_cast<int>(isa);
+            }
+        }
+        ASSERT_EQ(marked, count);
+        ASSERT_LT(count, n);
+    }
+}
+
+static std::vector<double> random_soup(std::size_t n, double extent, double size, unsigned seed) {
+    std::mt19937 gen(seed);
+    std::uniform_real_distribution<double> position(0, extent);
+    std::uniform_real_distribution<double> offset(-size, size);
+
+    std::vector<double> t(n * 9);
+    for (std::size_t i = 0; i < n; i++) {
+        double c[3] = { position(gen), position(gen), position(gen) };
+        for (int k = 0; k < 9; k++) {
+            t[i * 9 + k] = c[k % 3] + offset(gen);
+        }
+    }
+
+    return t;
+}
+
+static std::vector<TrianglePair> brute_force(const std::vector<double>& m1, const std::vector<double>& m2) {
+    std::vector<TrianglePair> pairs;
+    for (std::uint32_t i = 0; i < m1.size() / 9; i++) {
+        for (std::uint32_t j = 0; j < m2.size() / 9; j++) {
+            double t1[9], t2[9];
+            std::copy(m1.begin() + i * 9, m1.begin() + i * 9 + 9, t1);
+            std::copy(m2.begin() + j * 9, m2.begin() + j * 9 + 9, t2);
+            if (have_intersection(t1, t2)) {
+                pairs.emplace_back(i, j);
+            }
+        }
+    }
+
+    return pairs;
+}
+
+TEST(Bvh, CoversAllTriangles) {
+    const std::size_t n = 20000;
+    std::vector<double> soup = random_soup(n, 100, 1, 3);
+    Bvh bvh(soup.data(), n);
+
+    std::vector<int> seen(n, 0);
+    for (const Bvh::Node& node : bvh.nodes()) {
+        if (!node.is_leaf()) {
+            for (std::uint32_t c = node.first; c < node.first + 2; c++) {
+                ASSERT_LT(c, bvh.nodes().size());
+                const Aabb& child = bvh.nodes()[c].box;
+                for (int k = 0; k < 3; k++) {
+                    ASSERT_LE(node.box.min[k], child.min[k]);
+                    ASSERT_GE(node.box.max[k], child.max[k]);
+                }
+            }
+            continue;
+        }
+
+        for (std::uint32_t i = node.first; i < node.first + node.count; i++) {
+            std::uint32_t t = bvh.indices()[i];
+            seen[t]++;
+            for (int k = 0; k < 3; k++) {
+                ASSERT_LE(node.box.min[k], bvh.get_triangle_box(t).min[k]);
+                ASSERT_GE(node.box.max[k], bvh.get_triangle_box(t).max[k]);
+            }
+        }
+    }
+
+    for (int count : seen) {
+        ASSERT_EQ(count, 1);
+    }
+}
+
+TEST(Mesh, MatchesBruteForce) {
+    std::vector<double> m1 = random_soup(600, 10, 1, 4);
+    std::vector<double> m2 = random_soup(500, 10, 1, 5);
+
+    std::vector<TrianglePair> expected = brute_force(m1, m2);
+    ASSERT_FALSE(expected.empty());
+    ASSERT_EQ(intersect_meshes(m1.data(), 600, m2.data(), 500), expected);
+}
+
+TEST(Mesh, AnyAndCount) {
+    std::vector<double> m1 = random_soup(600, 10, 1, 4);
+    std::vector<double> m2 = random_soup(500, 10, 1, 5);
+    std::vector<double> apart = random_soup(500, 10, 1, 6);
+    for (double& c : apart) {
+        c += 20;
+    }
+
+    Bvh b1(m1.data(), 600), b2(m2.data(), 500), b3(apart.data(), 500);
+    std::size_t expected = brute_force(m1, m2).size();
+    for (unsigned threads : { 1u, 4u }) {
+        ParallelOptions options { threads };
+        ASSERT_TRUE(have_intersection(b1, b2, options));
+        ASSERT_EQ(count_intersections(b1, b2, options), expected);
+        ASSERT_FALSE(have_intersection(b1, b3, options));
+        ASSERT_EQ(count_intersections(b1, b3, options), 0u);
+    }
+
+    Bvh empty(nullptr, 0);
+    ASSERT_FALSE(have_intersection(b1, empty));
+    ASSERT_EQ(count_intersections(empty, b1), 0u);
+}
+
+TEST(Mesh, Empty) {
+    std::vector<double> m1 = random_soup(10, 10, 1, 4);
+
+    ASSERT_TRUE(intersect_meshes(m1.data(), 10, nullptr, 0).empty());
+    ASSERT_TRUE(intersect_meshes(nullptr, 0, m1.data(), 10).empty());
+}
+
+TEST(Distance, Triangles) {
+    double t1[9] = { 0, 0, 0, 1, 0, 0, 0, 1, 0 };
+    double above[9] = { 0, 0, 2, 1, 0, 2, 0, 1, 2 };
+    double crossing[9] = { 0.2, 0.2, -1, 0.2, 0.2, 1, 2, 2, 0 };
+    double skew[9] = { 2, -1, 3, 2, 1, 3, 3, 0, 5 };         // edge x = 2, z = 3 above the corner (1, 0, 0)
+    double point[9] = { 0.25, 0.25, -3, 0.25, 0.25, -3, 0.25, 0.25, -3 };
+    double p1[3], p2[3];
+
+    ASSERT_DOUBLE_EQ(get_distance(t1, above), 2);
+    ASSERT_EQ(get_distance(t1, crossing, p1, p2), 0);
+    ASSERT_EQ(get_distance(p1, p2), 0);
+    ASSERT_DOUBLE_EQ(get_distance(t1, skew, p1, p2), std::sqrt(10.0));
+    ASSERT_DOUBLE_EQ(p1[0], 1);
+    ASSERT_DOUBLE_EQ(p2[0], 2);
+    ASSERT_DOUBLE_EQ(p2[2], 3);
+    ASSERT_DOUBLE_EQ(get_distance(point, t1), 3);
+    ASSERT_DOUBLE_EQ(get_distance(point, point), 0);
+
+    // small skew edges, closest at their crossing; an absolute parallel test takes them for parallel
+
+    const double s = 1e-4;
+    double small1[9] = { -s, 0, 0, s, 0, 0, 0, -2 * s, -s };
+    double small2[9] = { 0, -s, 0.1 * s, 0, s, 0.1 * s, 2 * s, 0, s };
+    ASSERT_NEAR(get_distance(small1, small2), 0.1 * s, 1e-12 * s);
+
+    // random pairs: zero exactly for intersecting ones, otherwise no farther than any sampled pair of points
+
+    std::vector<double> m1 = random_soup(300, 3, 1, 38);
+    std::vector<double> m2 = random_soup(300, 3, 1, 39);
+    const int steps = 12;
+    for (std::size_t i = 0; i < 300; i++) {
+        double* a = &m1[i * 9];
+        double* b = &m2[i * 9];
+        double d = get_distance(a, b, p1, p2);
+        ASSERT_EQ(d == 0, have_intersection(a, b)) << "pair " << i;
+        double gap[3] = { p1[0] - p2[0], p1[1] - p2[1], p1[2] - p2[2] };
+        ASSERT_NEAR(std::sqrt(gap[0] * gap[0] + gap[1] * gap[1] + gap[2] * gap[2]), d, 1e-12);
+
+        double sampled = std::numeric_limits<double>::infinity();
+        for (int u1 = 0; u1 <= steps; u1++) {
+            for (int v1 = 0; u1 + v1 <= steps; v1++) {
+                for (int u2 = 0; u2 <= steps; u2++) {
+                    for (int v2 = 0; u2 + v2 <= steps; v2++) {
+                        double l = 0;
+                        for (int k = 0; k < 3; k++) {
+                            double x1 = a[k] + (u1 * (a[3 + k] - a[k]) + v1 * (a[6 + k] - a[k])) / steps;
+                            double x2 = b[k] + (u2 * (b[3 + k] - b[k]) + v2 * (b[6 + k] - b[k])) / steps;
+                            l += (x1 - x2) * (x1 - x2);
+                        }
+                        sampled = std::min(sampled, l);
+                    }
+                }
+            }
+        }
+        ASSERT_LE(d, std::sqrt(sampled) + 1e-12) << "pair " << i;
+        ASSERT_GE(d, std::sqrt(sampled) - 8.0 / steps) << "pair " << i;
+    }
+}
+
+TEST(Distance, MeshProximity) {
+    std::vector<double> m1 = random_soup(400, 10, 1, 40);
+    std::vector<double> m2 = random_soup(300, 10, 1, 41);
+    for (std::size_t k = 0; k < m2.size(); k += 3) {
+        m2[k] += 12;
+    }
+
+    double expected = std::numeric_limits<double>::infinity();
+    for (std::size_t i = 0; i < 400; i++) {
+        for (std::size_t j = 0; j < 300; j++) {
+            expected = std::min(expected, get_distance(&m1[i * 9], &m2[j * 9]));
+        }
+    }
+    ASSERT_GT(expected, 0);
+
+    Bvh b1(m1.data(), 400), b2(m2.data(), 300);
+    ClosestPair closest = get_closest_pair(b1, b2);
+    ASSERT_EQ(closest.distance, expected);
+    ASSERT_EQ(get_distance(&m1[closest.pair.first * 9], &m2[closest.pair.second * 9]), expected);
+    ASSERT_EQ(get_closest_pair(b1, b2, expected * 2).distance, expected);
+    ASSERT_EQ(get_closest_pair(b1, b2, expected * 0.99).distance, std::numeric_limits<double>::infinity());
+
+    ASSERT_TRUE(have_proximity(b1, b2, expected * 1.01));
+    ASSERT_TRUE(have_proximity(b1, b2, 100));
+    ASSERT_FALSE(have_proximity(b1, b2, expected * 0.99));
+    ASSERT_TRUE(have_proximity(b1, b1, 0));
+
+    Bvh empty(nullptr, 0);
+    ASSERT_FALSE(have_proximity(b1, empty, 100));
+    ASSERT_EQ(get_closest_pair(empty, b1).distance, std::numeric_limits<double>::infinity());
+}
+
+static void make_sphere(int rings, int segments, double radius, std::vector<double>& vertices, std::vector<std::uint32_t>& indices) {
+    const double pi = 3.14159265358979323846;
+    vertices = { 0, 0, radius, 0, 0, -radius };
+    for (int r = 1; r < rings; r++) {
+        for (int s = 0; s < segments; s++) {
+            double theta = pi * r / rings;
+            double phi = 2 * pi * s / segments;
+            vertices.insert(vertices.end(), {
+                radius * std::sin(theta) * std::cos(phi),
+                radius * std::sin(theta) * std::sin(phi),
+                radius * std::cos(theta)
+            });
+        }
+    }
+
+    auto ring_vertex = [&] (int r, int s) { return static_cast<std::uint32_t>(2 + (r - 1) * segments + s % segments); };
+    for (int s = 0; s < segments; s++) {
+        indices.insert(indices.end(), { 0, ring_vertex(1, s), ring_vertex(1, s + 1) });
+        indices.insert(indices.end(), { 1, ring_vertex(rings - 1, s + 1), ring_vertex(rings - 1, s) });
+        for (int r = 1; r < rings - 1; r++) {
+            indices.insert(indices.end(), { ring_vertex(r, s), ring_vertex(r + 1, s), ring_vertex(r + 1, s + 1) });
+            indices.insert(indices.end(), { ring_vertex(r, s), ring_vertex(r + 1, s + 1), ring_vertex(r, s + 1) });
+        }
+    }
+}
+
+TEST(SelfIntersection, ClosedSphere) {
+    std::vector<double> vertices;
+    std::vector<std::uint32_t> indices;
+    make_sphere(12, 16, 2, vertices, indices);
+
+    IndexedMesh mesh = { vertices.data(), vertices.size() / 3, indices.data(), indices.size() / 3 };
+    ASSERT_TRUE(find_self_intersections(mesh).empty());
+}
+
+TEST(SelfIntersection, PiercingTriangle) {
+    std::vector<double> vertices;
+    std::vector<std::uint32_t> indices;
+    make_sphere(12, 16, 2, vertices, indices);
+
+    std::uint32_t first = static_cast<std::uint32_t>(vertices.size() / 3);
+    vertices.insert(vertices.end(), { -3, 0.1, 0.2, 3, 0.3, -0.1, 0, 0.5, 3 });
+    indices.insert(indices.end(), { first, first + 1, first + 2 });
+
+    IndexedMesh mesh = { vertices.data(), vertices.size() / 3, indices.data(), indices.size() / 3 };
+    std::vector<TrianglePair> pairs = find_self_intersections(mesh);
+
+    std::vector<TrianglePair> expected;
+    std::uint32_t last = static_cast<std::uint32_t>(mesh.triangle_count - 1);
+    for (std::uint32_t i = 0; i < last; i++) {
+        double t1[9], t2[9];
+        for (int k = 0; k < 9; k++) {
+            t1[k] = vertices[indices[i * 3 + k / 3] * 3 + k % 3];
+            t2[k] = vertices[indices[last * 3 + k / 3] * 3 + k % 3];
+        }
+        if (have_intersection(t1, t2)) {
+            expected.emplace_back(i, last);
+        }
+    }
+
+    ASSERT_FALSE(expected.empty());
+    ASSERT_EQ(pairs, expected);
+}
+
+TEST(SelfIntersection, SharedVertex) {
+    std::vector<double> vertices = { 0, 0, 0, 2, 0, 0, 0, 2, 0, 1, 0.2, 1, 0.2, 1, -1, 1, 1, 1, -1, 2, 1 };
+    std::vector<std::uint32_t> crossing = { 0, 1, 2, 0, 3, 4 };
+    std::vector<std::uint32_t> touching = { 0, 1, 2, 0, 5, 6 };
+
+    IndexedMesh mesh = { vertices.data(), 7, crossing.data(), 2 };
+    ASSERT_EQ(find_self_intersections(mesh), std::vector<TrianglePair>({ { 0, 1 } }));
+
+    mesh.indices = touching.data();
+    ASSERT_TRUE(find_self_intersections(mesh).empty());
+}
+
+TEST(SelfIntersection, SharedEdge) {
+    std::vector<double> vertices = { 0, 0, 0, 2, 0, 0, 1, 1, 0, 1, -1, 0, 1, 0.5, 0 };
+    std::vector<std::uint32_t> flat = { 0, 1, 2, 1, 0, 3 };
+    std::vector<std::uint32_t> folded = { 0, 1, 2, 1, 0, 4 };
+
+    IndexedMesh mesh = { vertices.data(), 5, flat.data(), 2 };
+    ASSERT_TRUE(find_self_intersections(mesh).empty());
+
+    mesh.indices = folded.data();
+    ASSERT_EQ(find_self_intersections(mesh), std::vector<TrianglePair>({ { 0, 1 } }));
+}
+
+static void expect_changes(const std::vector<TrianglePair>& before, const std::vector<TrianglePair>& after, const ValidationSession::Changes& changes) {
+    std::vector<TrianglePair> added, removed;
+    std::set_difference(after.begin(), after.end(), before.begin(), before.end(), std::back_inserter(added));
+    std::set_difference(before.begin(), before.end(), after.begin(), after.end(), std::back_inserter(removed));
+    ASSERT_EQ(added, changes.added);
+    ASSERT_EQ(removed, changes.removed);
+}
+
+TEST(ValidationSession, MatchesFullCheck) {
+    std::vector<double> vertices;
+    std::vector<std::uint32_t> indices;
+    make_sphere(24, 32, 2, vertices, indices);
+
+    IndexedMesh mesh = { vertices.data(), vertices.size() / 3, indices.data(), indices.size() / 3 };
+    ValidationSession session(mesh);
+    ASSERT_TRUE(session.get_intersections().empty());
+
+    // small edits: vertices pushed through the opposite side of the sphere and pulled back one by one
+
+    std::mt19937 gen(44);
+    std::uniform_int_distribution<std::uint32_t> vertex(2, static_cast<std::uint32_t>(mesh.vertex_count - 1));
+    std::vector<TrianglePair> before = session.get_intersections();
+    std::vector<std::uint32_t> moved;
+    bool found = false;
+    for (int step = 0; step < 40; step++) {
+        std::uint32_t v = vertex(gen);
+        for (int k = 0; k < 3; k++) {
+            vertices[v * 3 + k] *= step % 4 == 3 ? 0.5 : -1.3;
+        }
+        moved.push_back(v);
+
+        ValidationSession::Changes changes = session.update(mesh, &v, 1, nullptr, 0);
+        std::vector<TrianglePair> after = find_self_intersections(mesh);
+        ASSERT_EQ(after, session.get_intersections()) << "step " << step;
+        ASSERT_EQ(after.size(), session.get_intersection_count());
+        expect_changes(before, after, changes);
+        found |= !after.empty();
+        before = after;
+    }
+    ASSERT_TRUE(found);
+
+    // an edge flip changes the indices of two triangles
+
+    std::uint32_t flipped[2] = { 100, 101 };
+    std::uint32_t* a = &indices[100 * 3];
+    std::uint32_t* b = &indices[101 * 3];
+    std::uint32_t quad[4] = { a[0], a[1], a[2], b[2] };
+    std::uint32_t t1[3] = { quad[0], quad[1], quad[3] };
+    std::uint32_t t2[3] = { quad[1], quad[2], quad[3] };
+    std::copy(t1, t1 + 3, a);
+    std::copy(t2, t2 + 3, b);
+    ValidationSession::Changes changes = session.update(mesh, nullptr, 0, flipped, 2);
+    std::vector<TrianglePair> after = find_self_intersections(mesh);
+    ASSERT_EQ(after, session.get_intersections());
+    expect_changes(before, after, changes);
+    before = after;
+
+    // a triangle appended on new vertices, through the middle of the sphere
+
+    std::uint32_t first = static_cast<std::uint32_t>(vertices.size() / 3);
+    vertices.insert(vertices.end(), { -3, -0.1, 0.2, 3, 0.1, -0.2, 0, 0.1, 3 });
+    indices.insert(indices.end(), { first, first + 1, first + 2 });
+    mesh = { vertices.data(), vertices.size() / 3, indices.data(), indices.size() / 3 };
+    changes = session.update(mesh, nullptr, 0, nullptr, 0);
+    after = find_self_intersections(mesh);
+    ASSERT_EQ(session.size(), mesh.triangle_count);
+    ASSERT_EQ(after, session.get_intersections());
+    expect_changes(before, after, changes);
+    before = after;
+
+    // a moved session keeps a hierarchy over its own triangles, copies are not allowed
+
+    static_assert(!std::is_copy_constructible<ValidationSession>::value, "ValidationSession is not copyable");
+    ValidationSession moved_session(std::move(session));
+    session = ValidationSession(mesh);
+    ASSERT_EQ(moved_session.get_intersections(), session.get_intersections());
+
+    // moving every vertex takes the path that tests everything again
+
+    std::vector<std::uint32_t> all(mesh.vertex_count);
+    for (std::uint32_t v = 0; v < all.size(); v++) {
+        all[v] = v;
+        vertices[v * 3 + 2] *= 0.8;
+    }
+    changes = moved_session.update(mesh, all.data(), all.size(), nullptr, 0);
+    after = find_self_intersections(mesh);
+    ASSERT_EQ(after, moved_session.get_intersections());
+    expect_changes(before, after, changes);
+
+    mesh.triangle_count--;
+    ASSERT_THROW(moved_session.update(mesh, nullptr, 0, nullptr, 0), std::invalid_argument);
+}
+
+TEST(ValidationSession, SaveAndLoad) {
+    std::vector<double> vertices;
+    std::vector<std::uint32_t> indices;
+    make_sphere(16, 24, 2, vertices, indices);
+    for (std::uint32_t v : { 40u, 90u, 150u, 200u }) {
+        for (int k = 0; k < 3; k++) {
+            vertices[v * 3 + k] *= -1.3;
+        }
+    }
+
+    IndexedMesh mesh = { vertices.data(), vertices.size() / 3, indices.data(), indices.size() / 3 };
+    ValidationSession session(mesh);
+    ASSERT_FALSE(session.get_intersections().empty());
+    ASSERT_EQ(get_content_hash(mesh), session.get_content_hash());
+
+    std::string path = testing::TempDir() + "session.bin";
+    session.save(path);
+    ValidationSession loaded(mesh, path);
+    ASSERT_EQ(session.get_intersections(), loaded.get_intersections());
+
+    // the loaded session goes on from the saved state
+    std::uint32_t v = 40;
+    for (int k = 0; k < 3; k++) {
+        vertices[v * 3 + k] /= -1.3;
+    }
+    loaded.update(mesh, &v, 1, nullptr, 0);
+    ASSERT_EQ(find_self_intersections(mesh), loaded.get_intersections());
+
+    // the file belongs to the mesh before the edit
+    ASSERT_NE(get_content_hash(mesh), session.get_content_hash());
+    ASSERT_THROW(ValidationSession(mesh, path), std::runtime_error);
+    ASSERT_THROW(ValidationSession(mesh, testing::TempDir() + "missing.bin"), std::runtime_error);
+
+    std::ofstream(path, std::ios::binary) << "TIVS";
+    ASSERT_THROW(ValidationSession(mesh, path), std::runtime_error);
+}
+
+TEST(Parallel, MeshesIndependentOfThreadCount) {
+    std::vector<double> m1 = random_soup(3000, 20, 1, 6);
+    std::vector<double> m2 = random_soup(3000, 20, 1, 7);
+    Bvh b1(m1.data(), 3000), b2(m2.data(), 3000);
+
+    std::vector<TrianglePair> expected = intersect_meshes(b1, b2);
+    ASSERT_FALSE(expected.empty());
+    for (unsigned threads : { 2u, 3u, 8u, 0u }) {
+        ASSERT_EQ(intersect_meshes(b1, b2, ParallelOptions { threads }), expected);
+    }
+}
+
+TEST(Parallel, PairsMatchScalar) {
+    std::vector<double> m1 = random_soup(200, 5, 1, 8);
+    std::vector<double> m2 = random_soup(200, 5, 1, 9);
+
+    std::vector<TrianglePair> candidates;
+    for (std::uint32_t i = 0; i < 200; i++) {
+        for (std::uint32_t j = 0; j < 200; j++) {
+            candidates.emplace_back(j, i);
+        }
+    }
+
+    std::vector<TrianglePair> expected = brute_force(m1, m2);
+    for (unsigned threads : { 1u, 4u }) {
+        ASSERT_EQ(intersect_pairs(m1.data(), m2.data(), candidates, ParallelOptions { threads }), expected);
+    }
+}
+
+TEST(Pipeline, MatchesBlocking) {
+    std::vector<double> m1 = random_soup(3000, 20, 1, 42);
+    std::vector<double> m2 = random_soup(2000, 20, 1, 43);
+    Bvh b1(m1.data(), 3000), b2(m2.data(), 2000), empty(nullptr, 0);
+    std::vector<TrianglePair> expected = intersect_meshes(b1, b2);
+    ASSERT_FALSE(expected.empty());
+
+    std::vector<TrianglePair> candidates;
+    for (std::uint32_t i = 0; i < 2000; i++) {
+        for (std::uint32_t j = 0; j < 5; j++) {
+            candidates.emplace_back((i * 7 + j * 13) % 3000, i);
+        }
+    }
+    std::vector<TrianglePair> expected_pairs = intersect_pairs(m1.data(), m2.data(), candidates, ParallelOptions { 1 });
+
+    // pairs (m1[i], m2[i]) as a batch, n not a multiple of the chunk size
+    const std::size_t n = 2000 + 37;
+    std::vector<double> soa(n * 18);
+    TriangleBatch t1, t2;
+    for (int k = 0; k < 9; k++) {
+        for (std::size_t i = 0; i < n; i++) {
+            soa[k * n + i] = m1[i * 9 + k];
+            soa[(k + 9) * n + i] = m2[(i % 2000) * 9 + k];
+        }
+        t1.coords[k] = soa.data() + k * n;
+        t2.coords[k] = soa.data() + (k + 9) * n;
+    }
+    std::vector<std::uint64_t> expected_mask((n + 63) / 64);
+    have_intersection_batch(t1, t2, n, expected_mask.data());
+
+    // few chunks and a tiny queue: submit() blocks and the stages take turns
+
+    BatchPipeline::Options options;
+    options.threads = 3;
+    options.max_chunks_in_flight = 2;
+    options.max_queued = 1;
+    BatchPipeline pipeline(options);
+    ASSERT_EQ(pipeline.get_thread_count(), 3u);
+
+    auto submit_all = [&] {
+        for (int round = 0; round < 3; round++) {
+            auto meshes = pipeline.submit(b1, b2);
+            auto pairs = pipeline.submit(m1.data(), m2.data(), candidates);
+            auto mask = pipeline.submit(t1, t2, n);
+            auto none = pipeline.submit(b1, empty);
+            auto nothing = pipeline.submit(t1, t2, 0);
+            ASSERT_EQ(meshes.get(), expected);
+            ASSERT_EQ(pairs.get(), expected_pairs);
+            ASSERT_EQ(mask.get(), expected_mask);
+            ASSERT_TRUE(none.get().empty());
+            ASSERT_TRUE(nothing.get().empty());
+        }
+    };
+    std::thread other(submit_all);
+    submit_all();
+    other.join();
+
+    // jobs still running when the pipeline goes away complete
+    std::future<std::vector<TrianglePair>> pending;
+    {
+        BatchPipeline scoped;
+        pending = scoped.submit(b1, b2);
+    }
+    ASSERT_EQ(pending.wait_for(std::chrono::seconds(0)), std::future_status::ready);
+    ASSERT_EQ(pending.get(), expected);
+}
+
+TEST(Sink, MatchesVectors) {
+    std::vector<double> m1 = random_soup(3000, 20, 1, 42);
+    std::vector<double> m2 = random_soup(2000, 20, 1, 43);
+    Bvh b1(m1.data(), 3000), b2(m2.data(), 2000);
+    std::vector<TrianglePair> expected = intersect_meshes(b1, b2);
+    ASSERT_FALSE(expected.empty());
+
+    QueryArena arena;
+    for (unsigned threads : { 1u, 3u }) {
+        ArenaSink arena_sink;
+        intersect_meshes(b1, b2, arena_sink, arena, ParallelOptions { threads });
+        ASSERT_EQ(arena_sink.size(), expected.size());
+        ASSERT_EQ(arena_sink.get_sorted(), expected);
+
+        std::mutex mutex;
+        std::vector<TrianglePair> called;
+        auto callback = make_callback_sink([&] (const TrianglePair* pairs, std::size_t count, unsigned worker) {
+            ASSERT_LT(worker, threads);
+            std::lock_guard<std::mutex> lock(mutex);
+            called.insert(called.end(), pairs, pairs + count);
+        });
+        intersect_meshes(b1, b2, callback, arena, ParallelOptions { threads });
+        std::sort(called.begin(), called.end());
+        ASSERT_EQ(called, expected);
+    }
+
+    // a ring much smaller than the result, drained by another thread
+
+    RingSink ring(100);
+    for (int round = 0; round < 2; round++) {
+        std::vector<TrianglePair> popped;
+        std::thread consumer([&] {
+            TrianglePair pairs[64];
+            while (std::size_t n = ring.pop(pairs, 64)) {
+                popped.insert(popped.end(), pairs, pairs + n);
+            }
+        });
+        intersect_meshes(b1, b2, ring, arena, ParallelOptions { 3 });
+        consumer.join();
+        std::sort(popped.begin(), popped.end());
+        ASSERT_EQ(popped, expected);
+        ring.reset();
+    }
+
+    // pairs add up until clear()
+
+    std::vector<TrianglePair> candidates(expected.begin(), expected.end());
+    candidates.emplace_back(0, 0);
+    ArenaSink arena_sink;
+    intersect_pairs(m1.data(), m2.data(), candidates.data(), candidates.size(), arena_sink, arena, ParallelOptions { 2 });
+    intersect_meshes(b1, b2, arena_sink, arena);
+    ASSERT_EQ(arena_sink.size(), expected.size() * 2);
+    arena_sink.clear();
+    ASSERT_EQ(arena_sink.size(), 0u);
+    ASSERT_TRUE(arena_sink.get_sorted().empty());
+
+    // two overlapping spheres as one mesh
+
+    std::vector<double> vertices, other_vertices;
+    std::vector<std::uint32_t> indices, other_indices;
+    make_sphere(12, 16, 2, vertices, indices);
+    make_sphere(12, 16, 2, other_vertices, other_indices);
+    std::uint32_t offset = static_cast<std::uint32_t>(vertices.size() / 3);
+    for (std::size_t i = 0; i < other_vertices.size(); i++) {
+        vertices.push_back(other_vertices[i] + (i % 3 == 0 ? 1.5 : 0));
+    }
+    for (std::uint32_t i : other_indices) {
+        indices.push_back(i + offset);
+    }
+    IndexedMesh mesh = { vertices.data(), vertices.size() / 3, indices.data(), indices.size() / 3 };
+    std::vector<TrianglePair> self = find_self_intersections(mesh);
+    ASSERT_FALSE(self.empty());
+    find_self_intersections(mesh, arena_sink);
+    ASSERT_EQ(arena_sink.get_sorted(), self);
+}
+
+TEST(ConstApi, InputsUnchanged) {
+    double t1[] = { 3, 3, 4, -3, -3, -4, 3, -1, 4 };
+    double t2[] = { -5, 2, -2, -5, 2, -2, 5, -4, 3 };
+    double c1[9], c2[9];
+    std::copy(t1, t1 + 9, c1);
+    std::copy(t2, t2 + 9, c2);
+
+    ASSERT_TRUE(have_intersection(t1, t2));
+    ASSERT_TRUE(std::equal(t1, t1 + 9, c1));
+    ASSERT_TRUE(std::equal(t2, t2 + 9, c2));
+}
+
+TEST(ConstApi, StridedVertexBuffer) {
+    std::vector<double> a = random_triangles(500, 10);
+    std::vector<double> b = random_triangles(500, 11);
+
+    // interleaved position and normal, the normals are never read
+    std::vector<double> vertices;
+    for (std::size_t i = 0; i < a.size(); i += 3) {
+        vertices.insert(vertices.end(), { a[i], a[i + 1], a[i + 2], -1, -1, -1 });
+    }
+    for (std::size_t i = 0; i < b.size(); i += 3) {
+        vertices.insert(vertices.end(), { b[i], b[i + 1], b[i + 2], -1, -1, -1 });
+    }
+    const std::vector<double> copy = vertices;
+
+    VertexView view = { vertices.data(), 6 };
+    for (std::uint32_t i = 0; i < 500; i++) {
+        std::uint32_t i1[3] = { i * 3, i * 3 + 1, i * 3 + 2 };
+        std::uint32_t i2[3] = { 1500 + i * 3, 1500 + i * 3 + 1, 1500 + i * 3 + 2 };
+        ASSERT_EQ(have_intersection(view, i1, view, i2), have_intersection(a.data() + i * 9, b.data() + i * 9)) << "pair " << i;
+    }
+
+    ASSERT_EQ(vertices, copy);
+}
+
+TEST(Prepared, MatchesUnprepared) {
+    const std::size_t n = 4000;
+    std::vector<double> a = random_triangles(n, 12);
+    std::vector<double> b = random_triangles(n, 13);
+
+    for (std::size_t i = 0; i < n; i++) {
+        PreparedTriangle p1(a.data() + i * 9);
+        PreparedTriangle p2(b.data() + i * 9);
+        bool expected = have_intersection(a.data() + i * 9, b.data() + i * 9);
+
+        ASSERT_EQ(have_intersection(p1, p2), expected) << "pair " << i;
+        ASSERT_EQ(have_intersection(p1, b.data() + i * 9), expected) << "pair " << i;
+    }
+}
+
+TEST(Prepared, Kind) {
+    double point[] = { 5, 7, 3, 5, 7, 3, 5, 7, 3 };
+    double segment[] = { -1, 2, -2, 5, -4, 3, -1, 2, -2 };
+    double triangle[] = { 3, 3, 4, -3, -3, -4, 3, -1, 4 };
+
+    ASSERT_EQ(PreparedTriangle(point).kind, TriangleKind::Point);
+    ASSERT_EQ(PreparedTriangle(segment).kind, TriangleKind::Segment);
+    ASSERT_EQ(PreparedTriangle(triangle).kind, TriangleKind::Triangle);
+}
+
+TEST(Stats, CountsBranches) {
+    double far1[] = { 0, 0, 0, 1, 0, 0, 0, 1, 0 };
+    double far2[] = { 0, 0, 5, 1, 0, 5, 0, 1, 6 };
+    double crossing1[] = { -78, 99, 40, -21, -72, 63, -19, -78, -83 };
+    double crossing2[] = { 9, 5, -21, 96, 77, -51, -95, -1, -16 };
+    double coplanar1[] = { 3, 3, 4, 3, -1, 4, 1.5, 1.5, 4 };
+    double coplanar2[] = { 10, 5, 4, -1, 0, 4, 7, -3, 4 };
+    double point[] = { 5, 7, 3, 5, 7, 3, 5, 7, 3 };
+
+    reset_branch_stats();
+    std::thread([&] {
+        have_intersection(far1, far2);
+        have_intersection(crossing1, crossing2);
+        have_intersection(PreparedTriangle(coplanar1), PreparedTriangle(coplanar2));
+        have_intersection(point, point);
+        have_intersection(point, point);
+
+        BranchStats s = get_thread_branch_stats();
+        std::uint64_t n = have_branch_stats() ? 1 : 0;
+        ASSERT_EQ(s.get_count(Branch::FirstPlaneReject), n);
+        ASSERT_EQ(s.get_count(Branch::Interval), n);
+        ASSERT_EQ(s.get_count(Branch::Coplanar), n);
+        ASSERT_EQ(s.get_count(Branch::PointPoint), 2 * n);
+        ASSERT_EQ(s.get_count(Branch::SegmentTriangle), 0u);
+    }).join();
+
+    // the thread is gone, its counts are kept
+    BranchStats s = get_branch_stats();
+    ASSERT_EQ(s.get_count(Branch::PointPoint), have_branch_stats() ? 2u : 0u);
+
+    // a running thread counts on from the reset
+    have_intersection(point, point);
+    reset_branch_stats();
+    ASSERT_EQ(get_branch_stats().get_count(Branch::PointPoint), 0u);
+    ASSERT_EQ(get_thread_branch_stats().get_count(Branch::PointPoint), 0u);
+    have_intersection(point, point);
+    ASSERT_EQ(get_thread_branch_stats().get_count(Branch::PointPoint), have_branch_stats() ? 1u : 0u);
+    ASSERT_STREQ(get_branch_name(Branch::Coplanar), "coplanar");
+}
+
+#ifdef __SIZEOF_INT128__
+TEST(Predicates, Orient2dExact) {
+
+    /*
+    Points next to the line through (12, 12) and (24, 24) on a grid of step 2^-50:
+    the scaled coordinates are integers and the determinant is computed exactly with 128 bits
+    */
+
+    const double step = std::ldexp(1.0, -50);
+    double a[2] = { 12, 12 }, b[2] = { 24, 24 };
+    int wrong = 0;
+
+    for (int i = 0; i < 64; i++) {
+        for (int j = 0; j < 64; j++) {
+            double c[2] = { 0.5 + i * step, 0.5 + j * step };
+
+            __int128 s[3][2];
+            const double* p[3] = { a, b, c };
+            for (int k = 0; k < 3; k++) {
+                for (int l = 0; l < 2; l++) {
+                    s[k][l] = static_cast<__int128>(std::ldexp(p[k][l], 50));
+                }
+            }
+            __int128 exact = (s[0][0] - s[2][0]) * (s[1][1] - s[2][1]) - (s[0][1] - s[2][1]) * (s[1][0] - s[2][0]);
+            int sign = exact > 0 ? 1 : exact < 0 ? -1 : 0;
+
+            double robust = RobustPredicates::orient2d(a, b, c);
+            double fast = FastPredicates::orient2d(a, b, c);
+            ASSERT_EQ((robust > 0) - (robust < 0), sign) << i << " " << j;
+            wrong += (fast > 0) - (fast < 0) != sign;
+        }
+    }
+
+    // the case is only interesting if plain doubles get it wrong
+    ASSERT_GT(wrong, 0);
+}
+
+TEST(Predicates, Orient3dExact) {
+
+    // points next to a plane, coordinates on a grid of step 2^-20 so that 128 bits hold the exact determinant
+
+    std::mt19937 gen(5);
+    std::uniform_int_distribution<int> coordinate(-(8 << 20), 8 << 20);
+    std::uniform_real_distribution<double> weight(-1, 2);
+    std::uniform_int_distribution<int> noise(-2, 2);
+
+    for (int n = 0; n < 20000; n++) {
+        double p[4][3];
+        for (int k = 0; k < 3; k++) {
+            for (int l = 0; l < 3; l++) {
+                p[k][l] = std::ldexp(coordinate(gen), -20);
+            }
+        }
+
+        double u = weight(gen), v = weight(gen);
+        for (int l = 0; l < 3; l++) {
+            double x = p[0][l] + u * (p[1][l] - p[0][l]) + v * (p[2][l] - p[0][l]);
+            p[3][l] = std::ldexp(std::round(std::ldexp(x, 20)) + noise(gen), -20);
+        }
+
+        __int128 m[3][3];
+        for (int k = 0; k < 3; k++) {
+            for (int l = 0; l < 3; l++) {
+                m[k][l] = static_cast<__int128>(std::ldexp(p[k][l] - p[3][l], 20));
+            }
+        }
+        __int128 exact = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1])
+                       - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0])
+                       + m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+        int sign = exact > 0 ? 1 : exact < 0 ? -1 : 0;
+
+        double robust = RobustPredicates::orient3d(p[0], p[1], p[2], p[3]);
+        ASSERT_EQ((robust > 0) - (robust < 0), sign) << n;
+    }
+}
+#endif
+
+TEST(Predicates, FlatTriangle) {
+
+    // exactly collinear vertices the length test of is_segment misses, the triangle is tested as its longest side
+
+    double e = std::ldexp(1.0, -49);
+    double flat[] = { 27 * e, 16 * e, 38 * e, 27, 16, 38, 216, 128, 304 };
+    double crossing[] = { 27, 10, 30, 27, 30, 30, 27, 16, 50 };
+    double apart[] = { 500, 10, 30, 500, 30, 30, 500, 16, 50 };
+
+    ASSERT_TRUE(have_intersection(flat, crossing));
+    ASSERT_TRUE(have_intersection(crossing, flat));
+    ASSERT_FALSE(have_intersection(flat, apart));
+    ASSERT_FALSE(have_intersection(apart, flat));
+}
+
+TEST(Predicates, FastKernel) {
+    double t1[] = { -78, 99, 40, -21, -72, 63, -19, -78, -83 };
+    double t2[] = { 9, 5, -21, 96, 77, -51, -95, -1, -16 };
+    double t3[] = { 3, 3, 4, 3, -1, 4, 1.5, 1.5, 4 };
+    double t4[] = { 10, 5, 4, -1, 0, 4, 7, -3, 4 };
+    const double* v1[3] = { t1, t1 + 3, t1 + 6 };
+    const double* v2[3] = { t2, t2 + 3, t2 + 6 };
+    const double* v3[3] = { t3, t3 + 3, t3 + 6 };
+    const double* v4[3] = { t4, t4 + 3, t4 + 6 };
+
+    ASSERT_TRUE(have_intersection<FastPredicates>(v1, v2));
+    ASSERT_TRUE(have_intersection<FastPredicates>(v3, v4));
+    ASSERT_FALSE(have_intersection<FastPredicates>(v1, v3));
+    ASSERT_TRUE(have_intersection<FastPredicates>(PreparedTriangle(t3), PreparedTriangle(t4)));
+}
+
+static std::vector<float> random_float_triangles(std::size_t n, unsigned seed) {
+
+    // every third triangle is scaled down so that the products of the sign tests underflow
+
+    std::vector<double> d = random_triangles(n, seed);
+    std::vector<float> t(d.size());
+    for (std::size_t i = 0; i < d.size(); i++) {
+        t[i] = static_cast<float>(d[i] * (i / 9 % 3 == 2 ? 1e-15 : 1));
+    }
+
+    return t;
+}
+
+TEST(Float, BatchMatchesScalar) {
+    const std::size_t n = 4013;
+    std::vector<float> a = random_float_triangles(n, 16);
+    std::vector<float> b = random_float_triangles(n, 17);
+
+    std::vector<float> soa_a(n * 9), soa_b(n * 9);
+    FloatTriangleBatch ba, bb;
+    for (int k = 0; k < 9; k++) {
+        for (std::size_t i = 0; i < n; i++) {
+            soa_a[k * n + i] = a[i * 9 + k];
+            soa_b[k * n + i] = b[i * 9 + k];
+        }
+        ba.coords[k] = soa_a.data() + k * n;
+        bb.coords[k] = soa_b.data() + k * n;
+    }
+
+    std::vector<bool> expected(n);
+    for (std::size_t i = 0; i < n; i++) {
+        double t1[9], t2[9];
+        std::copy(a.begin() + i * 9, a.begin() + i * 9 + 9, t1);
+        std::copy(b.begin() + i * 9, b.begin() + i * 9 + 9, t2);
+        expected[i] = have_intersection(t1, t2);
+        ASSERT_EQ(expected[i], have_intersection(a.data() + i * 9, b.data() + i * 9)) << "pair " << i;
+    }
+
+    for (SimdIsa isa : { SimdIsa::Scalar, SimdIsa::Avx2, SimdIsa::Avx512 }) {
+        if (isa > get_simd_isa()) {
+            continue;
+        }
+
+        std::vector<std::uint64_t> mask((n + 63) / 64, ~std::uint64_t(0));
+        have_intersection_batch(ba, bb, n, mask.data(), isa);
+
+        for (std::size_t i = 0; i < n; i++) {
+            ASSERT_EQ(expected[i], ((mask[i / 64] >> (i % 64)) & 1) != 0) << "pair " << i << ", isa " << static_cast<int>(isa);
+        }
+    }
+}
+
+static bool has_point(const Intersection& result, double x, double y, double z) {
+    for (std::size_t i = 0; i < result.count; i++) {
+        if (result.points[i][0] == x && result.points[i][1] == y && result.points[i][2] == z) {
+            return true;
+        }
+    }
+    return false;
+}
+
+TEST(Output, Segment) {
+    double t1[] = { 0, 0, 0, 4, 0, 0, 0, 4, 0 };
+    double t2[] = { 1, 1, -1, 1, 1, 1, 3, 1, 0 };
+    Intersection result;
+
+    ASSERT_TRUE(have_intersection(t1, t2, result));
+    ASSERT_EQ(Intersection::Kind::Segment, result.kind);
+    ASSERT_TRUE(has_point(result, 1, 1, 0));
+    ASSERT_TRUE(has_point(result, 3, 1, 0));
+
+    ASSERT_TRUE(have_intersection(t2, t1, result));
+    ASSERT_EQ(Intersection::Kind::Segment, result.kind);
+    ASSERT_TRUE(has_point(result, 1, 1, 0));
+    ASSERT_TRUE(has_point(result, 3, 1, 0));
+}
+
+TEST(Output, CoplanarPolygon) {
+    double t1[] = { 0, 0, 0, 4, 0, 0, 0, 4, 0 };
+    double t2[] = { 1, 1, 0, 5, 1, 0, 1, 5, 0 };
+    double t3[] = { 0, 0, 0, 4, 0, 0, 0, -4, 0 };
+    Intersection result;
+
+    ASSERT_TRUE(have_intersection(t1, t2, result));
+    ASSERT_EQ(Intersection::Kind::Polygon, result.kind);
+    ASSERT_EQ(3u, result.count);
+    ASSERT_TRUE(has_point(result, 1, 1, 0));
+    ASSERT_TRUE(has_point(result, 3, 1, 0));
+    ASSERT_TRUE(has_point(result, 1, 3, 0));
+
+    // shared edge
+    ASSERT_TRUE(have_intersection(t1, t3, result));
+    ASSERT_EQ(Intersection::Kind::Segment, result.kind);
+    ASSERT_TRUE(has_point(result, 0, 0, 0));
+    ASSERT_TRUE(has_point(result, 4, 0, 0));
+}
+
+TEST(Output, TouchingAndApart) {
+    double t1[] = { 0, 0, 0, 4, 0, 0, 0, 4, 0 };
+    double t2[] = { 1, 1, 0, 1, 1, 5, 2, 3, 5 };
+    double t3[] = { 1, 1, 1, 1, 1, 5, 2, 3, 5 };
+    Intersection result;
+
+    ASSERT_TRUE(have_intersection(t1, t2, result));
+    ASSERT_EQ(Intersection::Kind::Point, result.kind);
+    ASSERT_TRUE(has_point(result, 1, 1, 0));
+
+    ASSERT_FALSE(have_intersection(t1, t3, result));
+    ASSERT_EQ(Intersection::Kind::None, result.kind);
+    ASSERT_EQ(0u, result.count);
+}
+
+TEST(Output, MatchesBool) {
+
+    // same answers as the bool kernel, the points lie in the bounding boxes of both triangles
+
+    const std::size_t n = 4000;
+    std::vector<double> a = random_triangles(n, 18);
+    std::vector<double> b = random_triangles(n, 19);
+
+    for (std::size_t i = 0; i < n; i++) {
+        double* t1 = a.data() + i * 9;
+        double* t2 = b.data() + i * 9;
+        Intersection result;
+        bool hit = have_intersection(t1, t2, result);
+        ASSERT_EQ(have_intersection(t1, t2), hit) << "pair " << i;
+        ASSERT_EQ(hit, result.count > 0) << "pair " << i;
+
+        for (std::size_t j = 0; j < result.count; j++) {
+            for (int c = 0; c < 3; c++) {
+                for (const double* t : { t1, t2 }) {
+                    double lo = std::min({ t[c], t[3 + c], t[6 + c] });
+                    double hi = std::max({ t[c], t[3 + c], t[6 + c] });
+                    double slack = 1e-9 * (1 + hi - lo);
+                    ASSERT_GE(result.points[j][c], lo - slack) << "pair " << i;
+                    ASSERT_LE(result.points[j][c], hi + slack) << "pair " << i;
+                }
+            }
+        }
+    }
+}
+
+TEST(Output, CoplanarTouching) {
+
+    // coplanar pairs touching at a vertex or an edge point of t1, every reported point lies on both triangles
+
+    std::mt19937 gen(21);
+    std::uniform_real_distribution<double> position(-10, 10);
+    std::uniform_real_distribution<double> fraction(0, 1);
+    std::size_t with_points = 0;
+    for (int i = 0; i < 20000; i++) {
+        double t1[9], t2[9];
+        for (int v = 0; v < 3; v++) {
+            t1[v * 3] = position(gen);
+            t1[v * 3 + 1] = position(gen);
+            t1[v * 3 + 2] = 0;
+        }
+
+        // t2 starts at p on the boundary of t1 and widens away from the centroid of t1
+        int e = i % 3;
+        double a = i % 2 == 0 ? 0 : fraction(gen);
+        double p[2] = { t1[e * 3] + a * (t1[(e + 1) % 3 * 3] - t1[e * 3]), t1[e * 3 + 1] + a * (t1[(e + 1) % 3 * 3 + 1] - t1[e * 3 + 1]) };
+        double d[2] = { p[0] - (t1[0] + t1[3] + t1[6]) / 3, p[1] - (t1[1] + t1[4] + t1[7]) / 3 };
+        double w1 = fraction(gen) * 0.5, w2 = fraction(gen) * 0.5;
+        double q[9] = { p[0], p[1], 0,
+                        p[0] + 2 * d[0] - w1 * d[1], p[1] + 2 * d[1] + w1 * d[0], 0,
+                        p[0] + 2 * d[0] + w2 * d[1], p[1] + 2 * d[1] - w2 * d[0], 0 };
+        std::copy(q, q + 9, t2);
+
+        Intersection result;
+        if (!have_intersection(t1, t2, result)) {
+            continue;
+        }
+        with_points += result.count != 0;
+        for (std::size_t j = 0; j < result.count; j++) {
+            const double* r = result.points[j];
+            double point[9] = { r[0], r[1], r[2], r[0], r[1], r[2], r[0], r[1], r[2] };
+            ASSERT_LE(get_distance(t1, point), 1e-9) << "pair " << i;
+            ASSERT_LE(get_distance(t2, point), 1e-9) << "pair " << i;
+        }
+    }
+    ASSERT_GT(with_points, 10000u);
+}
+
+static void write_bytes(std::ofstream& out, const void* p, std::size_t size, bool big_endian) {
+    const char* bytes = static_cast<const char*>(p);
+    for (std::size_t i = 0; i < size; i++) {
+        out.put(bytes[big_endian ? size - 1 - i : i]);
+    }
+}
+
+static std::string write_stl(const std::string& name, const std::vector<double>& vertices, const std::vector<std::uint32_t>& indices) {
+    std::string path = testing::TempDir() + name;
+    std::ofstream out(path, std::ios::binary);
+    out << std::string(80, ' ');
+    std::uint32_t count = static_cast<std::uint32_t>(indices.size() / 3);
+    write_bytes(out, &count, 4, false);
+    for (std::size_t i = 0; i < count; i++) {
+        float record[12] = {};
+        for (int k = 0; k < 9; k++) {
+            record[3 + k] = static_cast<float>(vertices[indices[i * 3 + k / 3] * 3 + k % 3]);
+        }
+        for (float f : record) {
+            write_bytes(out, &f, 4, false);
+        }
+        out.put(0).put(0);
+    }
+    return path;
+}
+
+static std::string write_ply(const std::string& name, const std::vector<double>& vertices, const std::vector<std::uint32_t>& indices,
+                             bool big_endian, bool is_double, int face_size = 3) {
+
+    // extra properties around the coordinates and the indices, as scanners write them
+
+    std::string path = testing::TempDir() + name;
+    std::ofstream out(path, std::ios::binary);
+    out << "ply\nformat " << (big_endian ? "binary_big_endian" : "binary_little_endian") << " 1.0\ncomment test\n"
+        << "element vertex " << vertices.size() / 3 << "\n"
+        << "property uchar red\n"
+        << "property " << (is_double ? "double" : "float") << " x\n"
+        << "property " << (is_double ? "double" : "float") << " y\n"
+        << "property " << (is_double ? "double" : "float") << " z\n"
+        << "property short quality\n"
+        << "element face " << indices.size() / 3 << "\n"
+        << "property list uchar int vertex_indices\n"
+        << "property uchar flags\n"
+        << "end_header\n";
+    for (std::size_t i = 0; i < vertices.size() / 3; i++) {
+        out.put(7);
+        for (int c = 0; c < 3; c++) {
+            if (is_double) {
+                write_bytes(out, &vertices[i * 3 + c], 8, big_endian);
+            } else {
+                float f = static_cast<float>(vertices[i * 3 + c]);
+                write_bytes(out, &f, 4, big_endian);
+            }
+        }
+        std::int16_t quality = 1;
+        write_bytes(out, &quality, 2, big_endian);
+    }
+    for (std::size_t i = 0; i < indices.size() / 3; i++) {
+        out.put(static_cast<char>(face_size));
+        for (int k = 0; k < face_size; k++) {
+            std::int32_t index = static_cast<std::int32_t>(indices[i * 3 + k % 3]);
+            write_bytes(out, &index, 4, big_endian);
+        }
+        out.put(0);
+    }
+    return path;
+}
+
+TEST(MeshIo, Stl) {
+    std::vector<double> vertices;
+    std::vector<std::uint32_t> indices;
+    make_sphere(12, 16, 2, vertices, indices);
+    MappedMesh mesh(write_stl("sphere.stl", vertices, indices));
+
+    ASSERT_EQ(MeshFormat::Stl, mesh.format());
+    ASSERT_EQ(indices.size() / 3, mesh.triangle_count());
+    for (std::size_t i = 0; i < mesh.triangle_count(); i++) {
+        double t[9];
+        mesh.get_triangle(i, t);
+        for (int k = 0; k < 9; k++) {
+            ASSERT_EQ(static_cast<double>(static_cast<float>(vertices[indices[i * 3 + k / 3] * 3 + k % 3])), t[k]);
+        }
+    }
+
+    // welded back into a closed mesh
+    std::vector<double> welded;
+    std::vector<std::uint32_t> welded_indices;
+    load_indexed_mesh(mesh, welded, welded_indices);
+    ASSERT_EQ(vertices.size(), welded.size());
+    IndexedMesh indexed = { welded.data(), welded.size() / 3, welded_indices.data(), welded_indices.size() / 3 };
+    ASSERT_TRUE(find_self_intersections(indexed).empty());
+}
+
+TEST(MeshIo, Ply) {
+    std::vector<double> vertices;
+    std::vector<std::uint32_t> indices;
+    make_sphere(12, 16, 2, vertices, indices);
+
+    for (bool big_endian : { false, true }) {
+        for (bool is_double : { false, true }) {
+            MappedMesh mesh(write_ply("sphere.ply", vertices, indices, big_endian, is_double));
+            ASSERT_EQ(MeshFormat::Ply, mesh.format());
+
+            std::vector<double> loaded;
+            std::vector<std::uint32_t> loaded_indices;
+            load_indexed_mesh(mesh, loaded, loaded_indices);
+            ASSERT_EQ(indices, loaded_indices);
+            ASSERT_EQ(vertices.size(), loaded.size());
+            for (std::size_t i = 0; i < vertices.size(); i++) {
+                ASSERT_EQ(is_double ? vertices[i] : static_cast<float>(vertices[i]), loaded[i]);
+            }
+
+            // the records hold 27 bytes, never a view of doubles
+            VertexView view;
+            ASSERT_FALSE(mesh.get_vertex_view(view));
+        }
+    }
+}
+
+TEST(MeshIo, MatchesInMemory) {
+    std::vector<double> vertices1, vertices2;
+    std::vector<std::uint32_t> indices1, indices2;
+    make_sphere(12, 16, 2, vertices1, indices1);
+    make_sphere(10, 12, 1.5, vertices2, indices2);
+    for (std::size_t i = 0; i < vertices2.size(); i += 3) {
+        vertices2[i] += 1;
+    }
+
+    MappedMesh mesh1(write_stl("sphere1.stl", vertices1, indices1));
+    MappedMesh mesh2(write_ply("sphere2.ply", vertices2, indices2, false, true));
+    std::vector<double> t1 = load_triangles(mesh1);
+    std::vector<double> t2 = load_triangles(mesh2);
+
+    std::vector<double> expected1, expected2;
+    for (std::uint32_t i : indices1) {
+        for (int c = 0; c < 3; c++) {
+            expected1.push_back(static_cast<float>(vertices1[i * 3 + c]));
+        }
+    }
+    for (std::uint32_t i : indices2) {
+        for (int c = 0; c < 3; c++) {
+            expected2.push_back(vertices2[i * 3 + c]);
+        }
+    }
+    ASSERT_EQ(expected1, t1);
+    ASSERT_EQ(expected2, t2);
+
+    std::vector<TrianglePair> pairs = intersect_meshes(t1.data(), mesh1.triangle_count(), t2.data(), mesh2.triangle_count());
+    ASSERT_FALSE(pairs.empty());
+}
+
+TEST(MeshIo, Errors) {
+    std::vector<double> vertices;
+    std::vector<std::uint32_t> indices;
+    make_sphere(4, 4, 1, vertices, indices);
+
+    ASSERT_THROW(MappedMesh(testing::TempDir() + "missing.stl"), std::runtime_error);
+    ASSERT_THROW(MappedMesh(write_ply("quads.ply", vertices, indices, false, false, 4)), std::runtime_error);
+
+    std::string ascii = testing::TempDir() + "ascii.ply";
+    std::ofstream(ascii) << "ply\nformat ascii 1.0\nelement vertex 0\nproperty float x\nend_header\n";
+    ASSERT_THROW(MappedMesh mesh(ascii), std::runtime_error);
+
+    std::string text = testing::TempDir() + "text.stl";
+    std::ofstream(text) << "solid nothing\nendsolid nothing\n";
+    ASSERT_THROW(MappedMesh mesh(text), std::runtime_error);
+}
+
+static std::vector<TrianglePair> brute_force_scene(const std::vector<std::vector<double>>& meshes) {
+    std::vector<TrianglePair> pairs;
+    std::uint32_t first1 = 0;
+    for (std::size_t m1 = 0; m1 < meshes.size(); m1++) {
+        std::uint32_t first2 = first1 + static_cast<std::uint32_t>(meshes[m1].size() / 9);
+        for (std::size_t m2 = m1 + 1; m2 < meshes.size(); m2++) {
+            for (const TrianglePair& p : brute_force(meshes[m1], meshes[m2])) {
+                pairs.emplace_back(first1 + p.first, first2 + p.second);
+            }
+            first2 += static_cast<std::uint32_t>(meshes[m2].size() / 9);
+        }
+        first1 += static_cast<std::uint32_t>(meshes[m1].size() / 9);
+    }
+
+    std::sort(pairs.begin(), pairs.end());
+    return pairs;
+}
+
+TEST(DynamicScene, MatchesBruteForce) {
+    std::vector<std::vector<double>> meshes = { random_soup(150, 6, 1, 21), random_soup(150, 6, 1, 22), random_soup(10, 3, 1, 23) };
+    DynamicScene scene;
+    for (const std::vector<double>& m : meshes) {
+        scene.add_mesh(m.data(), m.size() / 9);
+    }
+
+    std::vector<TrianglePair> previous;
+    auto check = [&] (const DynamicScene::Changes& changes) {
+        std::vector<TrianglePair> expected = brute_force_scene(meshes);
+        std::vector<TrianglePair> added, removed;
+        std::set_difference(expected.begin(), expected.end(), previous.begin(), previous.end(), std::back_inserter(added));
+        std::set_difference(previous.begin(), previous.end(), expected.begin(), expected.end(), std::back_inserter(removed));
+        ASSERT_EQ(scene.get_intersections(), expected);
+        ASSERT_EQ(changes.added, added);
+        ASSERT_EQ(changes.removed, removed);
+        previous = expected;
+
+        std::size_t overlaps = 0;
+        for (std::size_t m1 = 0; m1 < meshes.size(); m1++) {
+            for (std::size_t m2 = m1 + 1; m2 < meshes.size(); m2++) {
+                for (std::size_t i = 0; i < meshes[m1].size(); i += 9) {
+                    for (std::size_t j = 0; j < meshes[m2].size(); j += 9) {
+                        overlaps += have_overlap(get_box(&meshes[m1][i]), get_box(&meshes[m2][j]));
+                    }
+                }
+            }
+        }
+        ASSERT_EQ(scene.get_overlap_count(), overlaps);
+    };
+
+    check(scene.update());
+    ASSERT_FALSE(previous.empty());
+
+    std::mt19937 gen(24);
+    std::uniform_real_distribution<double> jitter(-0.2, 0.2);
+    for (int step = 0; step < 16; step++) {
+
+        // the small mesh sweeps through the others, a few triangles of the first one shake
+
+        for (std::size_t k = 0; k < meshes[2].size(); k++) {
+            meshes[2][k] += k % 3 == 0 ? 0.4 : 0.1;
+        }
+        scene.move_mesh(2, meshes[2].data());
+
+        for (int i = 0; i < 5; i++) {
+            std::uint32_t t = gen() % 150;
+            for (int k = 0; k < 9; k++) {
+                meshes[0][t * 9 + k] += jitter(gen);
+            }
+            scene.move_triangle(t, &meshes[0][t * 9]);
+        }
+
+        // every few steps the whole second mesh moves
+        if (step % 7 == 6) {
+            for (double& c : meshes[1]) {
+                c += 0.5;
+            }
+            scene.move_mesh(1, meshes[1].data());
+        }
+
+        if (step == 10) {
+            meshes.push_back(random_soup(5, 6, 1, 25));
+            ASSERT_EQ(scene.add_mesh(meshes[3].data(), 5), 3u);
+        }
+
+        check(scene.update());
+    }
+
+    // nothing moved, nothing changes
+    DynamicScene::Changes changes = scene.update();
+    ASSERT_TRUE(changes.added.empty());
+    ASSERT_TRUE(changes.removed.empty());
+    ASSERT_EQ(scene.get_intersections(), previous);
+}
+
+TEST(StaticScene, MatchesBruteForce) {
+    std::vector<double> soup = random_soup(2000, 10, 1, 31);
+    std::vector<double> queries = random_soup(100, 10, 1.5, 32);
+    StaticScene scene(soup.data(), 2000);
+    ASSERT_EQ(scene.size(), 2000u);
+
+    std::vector<std::vector<std::uint32_t>> expected(100);
+    for (const TrianglePair& p : brute_force(queries, soup)) {
+        expected[p.first].push_back(p.second);
+    }
+
+    std::vector<std::uint32_t> hits;
+    std::size_t total = 0;
+    for (std::size_t q = 0; q < 100; q++) {
+        const double* t = &queries[q * 9];
+        hits.clear();
+        scene.get_all_hits(t, hits);
+        ASSERT_EQ(hits, expected[q]);
+        ASSERT_EQ(scene.have_any_hit(t), !expected[q].empty());
+
+        std::uint32_t first[2];
+        std::size_t count = scene.get_hits(t, first, 2);
+        ASSERT_EQ(count, std::min<std::size_t>(2, expected[q].size()));
+        for (std::size_t k = 0; k < count; k++) {
+            ASSERT_TRUE(std::binary_search(expected[q].begin(), expected[q].end(), first[k]));
+        }
+        total += expected[q].size();
+    }
+    ASSERT_GT(total, 0u);
+
+    StaticScene empty(nullptr, 0);
+    ASSERT_FALSE(empty.have_any_hit(&queries[0]));
+}
+
+TEST(StaticScene, ConcurrentQueries) {
+    std::vector<double> soup = random_soup(5000, 20, 1, 33);
+    std::vector<double> queries = random_soup(400, 20, 1.5, 34);
+    const StaticScene scene(soup.data(), 5000);
+
+    std::vector<std::uint32_t> expected;
+    for (std::size_t q = 0; q < 400; q++) {
+        scene.get_all_hits(&queries[q * 9], expected);
+    }
+
+    std::vector<std::vector<std::uint32_t>> found(4);
+    std::vector<std::thread> threads;
+    for (std::size_t w = 0; w < found.size(); w++) {
+        threads.emplace_back([&, w] {
+            for (std::size_t q = 0; q < 400; q++) {
+                scene.get_all_hits(&queries[q * 9], found[w]);
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+
+    for (const std::vector<std::uint32_t>& hits : found) {
+        ASSERT_EQ(hits, expected);
+    }
+}
+
+static bool get_ray_hit(const Ray& ray, const double* t, double& distance) {
+
+    // plain Moller-Trumbore with the tolerances of StaticScene
+
+    double e1[3], e2[3], p[3], s[3], q[3];
+    for (int c = 0; c < 3; c++) {
+        e1[c] = t[3 + c] - t[c];
+        e2[c] = t[6 + c] - t[c];
+        s[c] = ray.origin[c] - t[c];
+    }
+    p[0] = ray.direction[1] * e2[2] - ray.direction[2] * e2[1];
+    p[1] = ray.direction[2] * e2[0] - ray.direction[0] * e2[2];
+    p[2] = ray.direction[0] * e2[1] - ray.direction[1] * e2[0];
+    double det = e1[0] * p[0] + e1[1] * p[1] + e1[2] * p[2];
+    if (std::abs(det) < 1e-12) {
+        return false;
+    }
+    q[0] = s[1] * e1[2] - s[2] * e1[1];
+    q[1] = s[2] * e1[0] - s[0] * e1[2];
+    q[2] = s[0] * e1[1] - s[1] * e1[0];
+    double u = (s[0] * p[0] + s[1] * p[1] + s[2] * p[2]) / det;
+    double v = (ray.direction[0] * q[0] + ray.direction[1] * q[1] + ray.direction[2] * q[2]) / det;
+    distance = (e2[0] * q[0] + e2[1] * q[1] + e2[2] * q[2]) / det;
+    return u >= -1e-12 && u <= 1 + 1e-12 && v >= -1e-12 && u + v <= 1 + 1e-12
+        && distance >= 0 && distance <= ray.max_distance;
+}
+
+static void add_box(std::vector<double>& soup, const double min[3], const double max[3]) {
+
+    // the 12 triangles of an axis-aligned box, a closed surface
+
+    for (int axis = 0; axis < 3; axis++) {
+        int a = (axis + 1) % 3, b = (axis + 2) % 3;
+        for (int side = 0; side < 2; side++) {
+            double corners[4][3];
+            for (int k = 0; k < 4; k++) {
+                corners[k][axis] = side ? max[axis] : min[axis];
+                corners[k][a] = (k == 1 || k == 2) ? max[a] : min[a];
+                corners[k][b] = k >= 2 ? max[b] : min[b];
+            }
+            for (int k : { 0, 1, 2, 0, 2, 3 }) {
+                soup.insert(soup.end(), corners[k], corners[k] + 3);
+            }
+        }
+    }
+}
+
+TEST(StaticScene, NearestHits) {
+    const std::size_t n = 3000, ray_count = 1000;
+    std::vector<double> soup = random_soup(n, 10, 1, 35);
+    StaticScene scene(soup.data(), n);
+
+    std::mt19937 gen(36);
+    std::uniform_real_distribution<double> position(-1, 11);
+    std::uniform_real_distribution<double> direction(-1, 1);
+    std::vector<Ray> rays(ray_count);
+    for (std::size_t i = 0; i < ray_count; i++) {
+        for (int c = 0; c < 3; c++) {
+            rays[i].origin[c] = position(gen);
+            rays[i].direction[c] = direction(gen);
+        }
+        // every third one a segment, the first ones share their origin
+        rays[i].max_distance = i % 3 == 0 ? 1 : 1e30;
+        if (i < 100) {
+            std::fill(rays[i].origin, rays[i].origin + 3, 5.0);
+        }
+    }
+
+    std::vector<RayHit> hits(ray_count);
+    scene.get_nearest_hits(rays.data(), ray_count, hits.data(), SimdIsa::Scalar);
+
+    std::size_t hit_count = 0;
+    for (std::size_t i = 0; i < ray_count; i++) {
+        std::uint32_t nearest = StaticScene::NO_HIT;
+        double best = rays[i].max_distance;
+        for (std::uint32_t t = 0; t < n; t++) {
+            double distance;
+            if (get_ray_hit(rays[i], &soup[std::size_t(t) * 9], distance) && (nearest == StaticScene::NO_HIT || distance < best)) {
+                nearest = t;
+                best = distance;
+            }
+        }
+        ASSERT_EQ(nearest, hits[i].triangle) << "ray " << i;
+        ASSERT_NEAR(best, hits[i].distance, 1e-9 * (1 + best)) << "ray " << i;
+        hit_count += nearest != StaticScene::NO_HIT;
+    }
+    ASSERT_GT(hit_count, ray_count / 4);
+
+    // the same hits for every instruction set and for every packet boundary
+
+    for (SimdIsa isa : { SimdIsa::Avx2, SimdIsa::Avx512 }) {
+        for (std::size_t first : { std::size_t(0), std::size_t(5) }) {
+            std::vector<RayHit> other(ray_count - first);
+            scene.get_nearest_hits(rays.data() + first, ray_count - first, other.data(), isa);
+            for (std::size_t i = 0; i < other.size(); i++) {
+                ASSERT_EQ(hits[first + i].triangle, other[i].triangle);
+                ASSERT_EQ(hits[first + i].distance, other[i].distance);
+            }
+        }
+    }
+}
+
+TEST(StaticScene, ClassifyPoints) {
+    std::vector<double> soup;
+    const double min1[] = { 0, 0, 0 }, max1[] = { 1, 1, 1 };
+    const double min2[] = { 2, 0.25, 0 }, max2[] = { 3, 0.75, 2 };
+    add_box(soup, min1, max1);
+    add_box(soup, min2, max2);
+    StaticScene scene(soup.data(), soup.size() / 9);
+
+    std::mt19937 gen(37);
+    std::uniform_real_distribution<double> position(-0.5, 3.5);
+    const std::size_t n = 3000;
+    std::vector<double> points(n * 3);
+    for (double& p : points) {
+        p = position(gen);
+    }
+
+    // the first ray of this point passes through the corner (1, 1, 1) and has to be cast again
+
+    const double corner[] = { 1 - 0.2 * 0.5773502692, 1 - 0.2 * 0.7071067812, 1 - 0.2 * 0.4082482905 };
+    std::copy(corner, corner + 3, points.begin());
+
+    for (SimdIsa isa : { SimdIsa::Scalar, SimdIsa::Avx2, SimdIsa::Avx512 }) {
+        std::vector<std::uint64_t> inside((n + 63) / 64);
+        scene.classify_points(points.data(), n, inside.data(), isa);
+
+        std::size_t inside_count = 0;
+        for (std::size_t i = 0; i < n; i++) {
+            const double* p = &points[i * 3];
+            bool in1 = true, in2 = true;
+            for (int c = 0; c < 3; c++) {
+                in1 = in1 && p[c] > min1[c] && p[c] < max1[c];
+                in2 = in2 && p[c] > min2[c] && p[c] < max2[c];
+            }
+            bool expected = in1 || in2;
+            ASSERT_EQ(expected, ((inside[i / 64] >> (i % 64)) & 1) != 0) << "point " << i;
+            inside_count += expected;
+        }
+        ASSERT_GT(inside_count, 0u);
+    }
+}
+
+TEST(CompactScene, MatchesStaticScene) {
+
+    // random triangles, then the same snapped to a coarse grid: touching, coplanar and flat pairs
+
+    for (int snapped = 0; snapped < 2; snapped++) {
+        std::vector<double> soup = random_soup(3000, 10, 1, 36);
+        std::vector<double> queries = random_soup(200, 10, 1.5, 37);
+        if (snapped) {
+            for (double& x : soup) {
+                x = std::round(x * 2) / 2;
+            }
+            for (double& x : queries) {
+                x = std::round(x * 2) / 2;
+            }
+        }
+
+        StaticScene expected(soup.data(), 3000);
+        CompactScene scene(soup.data(), 3000);
+        ASSERT_EQ(scene.size(), 3000u);
+
+        std::vector<std::uint32_t> hits, expected_hits;
+        std::size_t total = 0;
+        for (std::size_t q = 0; q < 200; q++) {
+            const double* t = &queries[q * 9];
+            hits.clear();
+            expected_hits.clear();
+            scene.get_all_hits(t, hits);
+            expected.get_all_hits(t, expected_hits);
+            ASSERT_EQ(hits, expected_hits);
+            ASSERT_EQ(scene.have_any_hit(t), !expected_hits.empty());
+
+            std::uint32_t first[2];
+            std::size_t count = scene.get_hits(t, first, 2);
+            ASSERT_EQ(count, std::min<std::size_t>(2, expected_hits.size()));
+            total += expected_hits.size();
+        }
+        ASSERT_GT(total, 0u);
+
+        // the soup included, less than StaticScene; the rest, a third of it at most
+        std::size_t soup_size = 3000 * 9 * sizeof(double);
+        std::size_t uncompressed = expected.nodes().size() * sizeof(StaticScene::Node) + soup_size + 3000 * sizeof(std::uint32_t);
+        ASSERT_LT(scene.get_memory_size(), uncompressed);
+        ASSERT_LT((scene.get_memory_size() - soup_size) * 3, uncompressed);
+    }
+
+    CompactScene empty(nullptr, 0);
+    ASSERT_EQ(empty.get_memory_size(), 0u);
+    double t[9] = { 0, 0, 0, 1, 0, 0, 0, 1, 0 };
+    ASSERT_FALSE(empty.have_any_hit(t));
+}
+
+TEST(Kernels, ExistingCases) {
+
+    // the Intersection and Intersection_Degenerate cases, for every kernel
+
+    struct Case {
+        double t1[9];
+        double t2[9];
+        bool expected;
+    };
+
+    const Case cases[] = {
+        { { -78, 99, 40, -21, -72, 63, -19, -78, -83 }, { 9, 5, -21, 96, 77, -51, -95, -1, -16 }, true }, // Intersection
+        { { -1, 4, 3, 3, 5, -2, -4, -7, 1 }, { 3, -5, -4, -2.5, -5.7, 0, 6, 1.6, 2 }, false }, // NoIntersection
+        { { -1, 4, 3, 3, 5, -2, -4, -7, 1 }, { -1, 4, 5, 3, 5, 0, -4, -7, 3 }, false }, // NoIntersectionParallel
+        { { 3, 3, 4, 3, -1, 4, 1.5, 1.5, 4 }, { 10, 5, 4, -1, 0, 4, 7, -3, 4 }, true }, // IntersectionCoplanar
+        { { 3, 3, 4, 3, -1, 4, 1.5, 1.5, 4 }, { 5, 10, 4, -1, 0, 4, 7, -3, 4 }, true }, // IntersectionCoplanarContainement
+        { { 3, 3, 4, 3, -1, 4, 1.5, 1.5, 4 }, { 5, 10, 4, -1, 0, 4, 1.5, 1.5, 4 }, true }, // SharedVertexCoplanar
+        { { 3, 3, 4, 3, -1, 4, 1.5, 1.5, 4 }, { 3, 3, 4, -1, 0, 4, 1.5, 1.5, 4 }, true }, // SharedEdgeCoplanar
+        { { 3, 3, 4, 3, -1, 4, 1.5, 1.5, 4 }, { 5, 10, 4, 4, 0, 4, 7, -3, 4 }, false }, // NoIntersectionCoplanar
+        { { -1, 4, 3, 3, 5, -2, -4, -7, 1 }, { 3, -5, -4, 3, 5, -2, 6, 1.6, 2 }, true }, // SharedVertex
+        { { 10, -25.5, 3, 6.3, -25.5, 1, 5, 0, 0 }, { 5, -5, -4, 5, 5, 4, 6, 1.6, 2 }, true }, // VertexOnEdge
+        { { 10, -25.5, 3, 12.3, 9.3, -4, 2.5, -2.7, 2 }, { 5, -5, -4, 12.3, 9.3, -4, 2.5, -2.7, 2 }, true }, // SharedEdge
+        { { 3, 3, 4, -3, -3, -4, 3, -1, 4 }, { 0, -1, 0, 0, -1, 0, 0, -1, 0 }, true }, // IntersectionTrianglePoint
+        { { 5.45, -1.77, -0.68, 5.45, -1.77, -0.68, 5.45, -1.77, -0.68 }, { 5, -5, -4, 12.3, 9.3, -4, 2.5, -2.7, 2 }, false }, // NoIntersectionTrianglePoint
+        { { 3, 3, 4, -3, -3, -4, 3, -1, 4 }, { -5, 2, -2, -5, 2, -2, 5, -4, 3 }, true }, // IntersectionTriangleSegment
+        { { 3, 3, 4, -3, -3, -4, 3, -1, 4 }, { -1, 2, -2, 5, -4, 3, -1, 2, -2 }, false }, // NoIntersectionTriangleSegment
+        { { 3, 3, 4, -3, -3, -4, -3, -3, -4 }, { -1, 2, -2, 5, -4, 3, -1, 2, -2 }, false }, // NoIntersectionSegmentSegment
+        { { 3, 3, 4, -3, -3, -4, -3, -3, -4 }, { 3, 3, -4, -3, -3, 44, -3, -3, 4 }, true }, // IntersectionSegmentSegment
+        { { 3, 3, -4, -3, -3, 4, -3, -3, 4 }, { 4, 4, -4, -2, -2, 4, -2, -2, 4 }, false }, // NoIntersectionSegmentSegmentCoplanar
+        { { 3, 3, -4, -3, -3, 4, -3, -3, 4 }, { 4, 3, -4, -2, -1, 4, -2, -1, 4 }, false }, // NoIntersectionSegmentSegmentParallel
+        { { 10, -10, 3, 12, 15, 3, -5, -3, 3 }, { 15, 9, 3, -10, 5, 3, 2.5, 7, 3 }, true }, // IntersectionTriangleSegmentCoplanar
+        { { 2.5, 7, 3, 2.5, 7, 3, 2.5, 7, 3 }, { 15, 9, 3, -10, 5, 3, 2.5, 7, 3 }, true }, // IntersectionSegmentPoint
+        { { 5, 7, 3, 5, 7, 3, 5, 7, 3 }, { 15, 9, 3, -10, 5, 3, 2.5, 7, 3 }, false }, // NoIntersectionSegmentPoint
+        { { 5, 7, 3, 5, 7, 3, 5, 7, 3 }, { 5, 7, 3, 5, 7, 3, 5, 7, 3 }, true }, // IntersectionPointPoint
+        { { 10, -25.5, 3, 10, -25.5, 3, 10, -25.5, 3 }, { 5.45, -1.77, -0.68, 5.45, -1.77, -0.68, 5.45, -1.77, -0.68 }, false }, // NoIntersectionPointPoint
+    };
+
+    for (std::size_t k = 0; k < KERNEL_COUNT; k++) {
+        Kernel kernel = static_cast<Kernel>(k);
+        for (const Case& c : cases) {
+            ASSERT_EQ(c.expected, have_intersection(c.t1, c.t2, kernel)) << get_kernel_name(kernel) << ", case " << &c - cases;
+        }
+    }
+}
+
+TEST(Kernels, MatchDevillersGuigue) {
+
+    // grid triangles touch and share planes all the time, the others are in general position
+
+    const std::size_t n = 20000;
+    std::vector<double> a = random_triangles(n, 38);
+    std::vector<double> b = random_triangles(n, 39);
+
+    std::size_t hits = 0;
+    for (std::size_t i = 0; i < n; i++) {
+        bool expected = have_intersection(&a[i * 9], &b[i * 9], Kernel::DevillersGuigue);
+        ASSERT_EQ(expected, have_intersection(&a[i * 9], &b[i * 9], Kernel::Moller)) << "pair " << i;
+        ASSERT_EQ(expected, have_intersection(&a[i * 9], &b[i * 9], Kernel::SeparatingAxis)) << "pair " << i;
+        hits += expected;
+    }
+    ASSERT_GT(hits, n / 10);
+    ASSERT_LT(hits, n - n / 10);
+
+    // scaled down, with points and segments among them, where the absolute tolerances of Devillers-Guigue count
+
+    for (double scale : { 1e-4, 1e-6 }) {
+        std::vector<double> sa(a), sb(b);
+        for (std::size_t i = 0; i < n * 9; i++) {
+            sa[i] *= scale;
+            sb[i] *= scale;
+        }
+        for (std::size_t i = 0; i + 1 < n; i += 3) {
+            std::copy(&sa[i * 9], &sa[i * 9 + 3], &sa[i * 9 + 3]);
+            std::copy(&sa[i * 9], &sa[i * 9 + 3], &sa[i * 9 + 6]);
+            std::copy(&sb[i * 9 + 12], &sb[i * 9 + 15], &sb[i * 9 + 15]);
+        }
+        for (std::size_t i = 0; i < n; i++) {
+            bool expected = have_intersection(&sa[i * 9], &sb[i * 9], Kernel::DevillersGuigue);
+            ASSERT_EQ(expected, have_intersection(&sa[i * 9], &sb[i * 9], Kernel::Moller)) << "scale " << scale << ", pair " << i;
+            ASSERT_EQ(expected, have_intersection(&sa[i * 9], &sb[i * 9], Kernel::SeparatingAxis)) << "scale " << scale << ", pair " << i;
+        }
+    }
+}
+
+TEST(Kernels, Autotune) {
+    const std::size_t n = 50000;
+    std::vector<double> a = random_triangles(n, 40);
+    std::vector<double> b = random_triangles(n, 41);
+
+    AutotuneOptions options;
+    options.sample_size = 1000;
+    Kernel kernel = autotune(a.data(), b.data(), n, options);
+    ASSERT_LT(static_cast<std::size_t>(kernel), KERNEL_COUNT);
+    ASSERT_EQ(Kernel::DevillersGuigue, autotune(a.data(), b.data(), options.sample_size - 1, options));
+
+    std::vector<std::uint64_t> mask((n + 63) / 64, ~std::uint64_t(0));
+    have_intersection_autotuned(a.data(), b.data(), n, mask.data(), options);
+    for (std::size_t i = 0; i < n; i++) {
+        ASSERT_EQ(have_intersection(&a[i * 9], &b[i * 9]), ((mask[i / 64] >> (i % 64)) & 1) != 0) << "pair " << i;
+    }
+}
+
+TEST(Integer, ScaledCases) {
+
+    // the Intersection and Intersection_Degenerate cases, scaled by 100 onto the integer grid
+
+    struct Case {
+        std::int32_t t1[9];
+        std::int32_t t2[9];
+        bool expected;
+    };
+
+    const Case cases[] = {
+        { { -7800, 9900, 4000, -2100, -7200, 6300, -1900, -7800, -8300 }, { 900, 500, -2100, 9600, 7700, -5100, -9500, -100, -1600 }, true }, // Intersection
+        { { -100, 400, 300, 300, 500, -200, -400, -700, 100 }, { 300, -500, -400, -250, -570, 0, 600, 160, 200 }, false }, // NoIntersection
+        { { -100, 400, 300, 300, 500, -200, -400, -700, 100 }, { -100, 400, 500, 300, 500, 0, -400, -700, 300 }, false }, // NoIntersectionParallel
+        { { 300, 300, 400, 300, -100, 400, 150, 150, 400 }, { 1000, 500, 400, -100, 0, 400, 700, -300, 400 }, true }, // IntersectionCoplanar
+        { { 300, 300, 400, 300, -100, 400, 150, 150, 400 }, { 500, 1000, 400, -100, 0, 400, 700, -300, 400 }, true }, // IntersectionCoplanarContainement
+        { { 300, 300, 400, 300, -100, 400, 150, 150, 400 }, { 500, 1000, 400, -100, 0, 400, 150, 150, 400 }, true }, // SharedVertexCoplanar
+        { { 300, 300, 400, 300, -100, 400, 150, 150, 400 }, { 300, 300, 400, -100, 0, 400, 150, 150, 400 }, true }, // SharedEdgeCoplanar
+        { { 300, 300, 400, 300, -100, 400, 150, 150, 400 }, { 500, 1000, 400, 400, 0, 400, 700, -300, 400 }, false }, // NoIntersectionCoplanar
+        { { -100, 400, 300, 300, 500, -200, -400, -700, 100 }, { 300, -500, -400, 300, 500, -200, 600, 160, 200 }, true }, // SharedVertex
+        { { 1000, -2550, 300, 630, -2550, 100, 500, 0, 0 }, { 500, -500, -400, 500, 500, 400, 600, 160, 200 }, true }, // VertexOnEdge
+        { { 1000, -2550, 300, 1230, 930, -400, 250, -270, 200 }, { 500, -500, -400, 1230, 930, -400, 250, -270, 200 }, true }, // SharedEdge
+        { { 300, 300, 400, -300, -300, -400, 300, -100, 400 }, { 0, -100, 0, 0, -100, 0, 0, -100, 0 }, true }, // IntersectionTrianglePoint
+        { { 545, -177, -68, 545, -177, -68, 545, -177, -68 }, { 500, -500, -400, 1230, 930, -400, 250, -270, 200 }, false }, // NoIntersectionTrianglePoint
+        { { 300, 300, 400, -300, -300, -400, 300, -100, 400 }, { -500, 200, -200, -500, 200, -200, 500, -400, 300 }, true }, // IntersectionTriangleSegment
+        { { 300, 300, 400, -300, -300, -400, 300, -100, 400 }, { -100, 200, -200, 500, -400, 300, -100, 200, -200 }, false }, // NoIntersectionTriangleSegment
+        { { 300, 300, 400, -300, -300, -400, -300, -300, -400 }, { -100, 200, -200, 500, -400, 300, -100, 200, -200 }, false }, // NoIntersectionSegmentSegment
+        { { 300, 300, 400, -300, -300, -400, -300, -300, -400 }, { 300, 300, -400, -300, -300, 4400, -300, -300, 400 }, true }, // IntersectionSegmentSegment
+        { { 300, 300, -400, -300, -300, 400, -300, -300, 400 }, { 400, 400, -400, -200, -200, 400, -200, -200, 400 }, false }, // NoIntersectionSegmentSegmentCoplanar
+        { { 300, 300, -400, -300, -300, 400, -300, -300, 400 }, { 400, 300, -400, -200, -100, 400, -200, -100, 400 }, false }, // NoIntersectionSegmentSegmentParallel
+        { { 1000, -1000, 300, 1200, 1500, 300, -500, -300, 300 }, { 1500, 900, 300, -1000, 500, 300, 250, 700, 300 }, true }, // IntersectionTriangleSegmentCoplanar
+        { { 250, 700, 300, 250, 700, 300, 250, 700, 300 }, { 1500, 900, 300, -1000, 500, 300, 250, 700, 300 }, true }, // IntersectionSegmentPoint
+        { { 500, 700, 300, 500, 700, 300, 500, 700, 300 }, { 1500, 900, 300, -1000, 500, 300, 250, 700, 300 }, false }, // NoIntersectionSegmentPoint
+        { { 500, 700, 300, 500, 700, 300, 500, 700, 300 }, { 500, 700, 300, 500, 700, 300, 500, 700, 300 }, true }, // IntersectionPointPoint
+        { { 1000, -2550, 300, 1000, -2550, 300, 1000, -2550, 300 }, { 545, -177, -68, 545, -177, -68, 545, -177, -68 }, false }, // NoIntersectionPointPoint
+    };
+
+    for (const Case& c : cases) {
+        ASSERT_EQ(have_intersection(c.t1, c.t2), c.expected);
+        ASSERT_EQ(have_intersection(c.t2, c.t1), c.expected);
+    }
+}
+
+TEST(Integer, Degenerate) {
+    // a segment inside a triangle of its plane, touching nothing but the interior
+    std::int32_t t[] = { -3, -2, 0, 3, -3, 0, 0, 2, 0 };
+    std::int32_t s[] = { 0, -2, 0, 0, -1, 0, 0, 1, 0 };
+    ASSERT_TRUE(have_intersection(t, s));
+
+    // overlapping and disjoint collinear segments
+    std::int32_t s1[] = { -2, -1, 0, 2, -1, 0, -1, -1, 0 };
+    std::int32_t s2[] = { 3, -1, 0, 1, -1, 0, -1, -1, 0 };
+    std::int32_t s3[] = { 3, -1, 0, 5, -1, 0, 4, -1, 0 };
+    ASSERT_TRUE(have_intersection(s1, s2));
+    ASSERT_FALSE(have_intersection(s1, s3));
+
+    // touching at one vertex, coplanar and across planes
+    std::int32_t t1[] = { 0, 0, 0, 4, 0, 0, 0, 4, 0 };
+    std::int32_t t2[] = { 4, 0, 0, 8, 0, 0, 8, 4, 0 };
+    std::int32_t t3[] = { 4, 0, 0, 8, 0, 5, 8, 4, 5 };
+    std::int32_t t4[] = { 5, 0, 0, 8, 0, 5, 8, 4, 5 };
+    ASSERT_TRUE(have_intersection(t1, t2));
+    ASSERT_TRUE(have_intersection(t1, t3));
+    ASSERT_FALSE(have_intersection(t1, t4));
+
+    // at the bound, one unit apart
+    const std::int32_t b = MAX_INTEGER_COORDINATE;
+    std::int32_t big1[] = { -b, -b, 0, b, -b, 0, -b, b, 0 };
+    std::int32_t big2[] = { b, b, -b, b, b, b, 0, 0, 0 };
+    std::int32_t big3[] = { b, b, -b, b, b, b, 1, 0, 0 };
+    ASSERT_TRUE(have_intersection(big1, big2));
+    ASSERT_FALSE(have_intersection(big1, big3));
+}
+
+TEST(Integer, CoplanarCases) {
+
+    // the pairs MatchesDouble skips: triangles, segments and points in the plane of a triangle, with known answers
+
+    struct Case {
+        std::int32_t t[9];
+        bool expected;
+    };
+
+    const std::int32_t t[] = { 0, 0, 0, 10, 0, 0, 0, 10, 0 };
+    const Case cases[] = {
+        { { 2, 2, 0, 12, 2, 0, 2, 12, 0 }, true },         // overlapping triangles
+        { { 1, 1, 0, 3, 1, 0, 1, 3, 0 }, true },           // contained triangle
+        { { 10, 0, 0, 0, 10, 0, 10, 10, 0 }, true },       // shared edge
+        { { 5, 5, 0, 10, 10, 0, 5, 10, 0 }, true },        // vertex on an edge
+        { { 6, 5, 0, 10, 10, 0, 5, 10, 0 }, false },       // one unit past the edge
+        { { 1, 1, 0, 2, 2, 0, 3, 3, 0 }, true },           // segment inside
+        { { -1, 5, 0, 5, 5, 0, 2, 5, 0 }, true },          // segment across an edge
+        { { 12, -2, 0, 2, 8, 0, 7, 3, 0 }, true },         // segment along an edge
+        { { 11, -1, 0, 12, -2, 0, 13, -3, 0 }, false },    // segment on the line of an edge, past its end
+        { { 3, 3, 0, 3, 3, 0, 3, 3, 0 }, true },           // point inside
+        { { 5, 0, 0, 5, 0, 0, 5, 0, 0 }, true },           // point on an edge
+        { { 10, 0, 0, 10, 0, 0, 10, 0, 0 }, true },        // point on a vertex
+        { { 5, -1, 0, 5, -1, 0, 5, -1, 0 }, false },       // point outside
+    };
+
+    for (const Case& c : cases) {
+        ASSERT_EQ(have_intersection(t, c.t), c.expected);
+        ASSERT_EQ(have_intersection(c.t, t), c.expected);
+    }
+
+    // known misses of the double kernel on the same pairs, to notice when they change
+
+    double d[9], segment[9], on_edge[9], on_vertex[9];
+    for (int k = 0; k < 9; k++) {
+        d[k] = t[k];
+        segment[k] = cases[5].t[k];
+        on_edge[k] = cases[10].t[k];
+        on_vertex[k] = cases[11].t[k];
+    }
+    EXPECT_NE(have_intersection(d, segment), have_intersection(t, cases[5].t));
+    EXPECT_NE(have_intersection(d, on_edge), have_intersection(t, cases[10].t));
+    EXPECT_NE(have_intersection(d, on_vertex), have_intersection(t, cases[11].t));
+}
+
+static bool is_collinear(const std::int32_t t[9]) {
+    std::int64_t u[3], v[3];
+    for (int k = 0; k < 3; k++) {
+        u[k] = std::int64_t(t[3 + k]) - t[k];
+        v[k] = std::int64_t(t[6 + k]) - t[k];
+    }
+    return u[1] * v[2] == u[2] * v[1] && u[2] * v[0] == u[0] * v[2] && u[0] * v[1] == u[1] * v[0];
+}
+
+TEST(Integer, MatchesDouble) {
+
+    /*
+    Away from coplanar pairs the double kernel takes exact signs only, the answers have to agree.
+    Small grids make touching pairs common, the large one checks the bound
+    */
+
+    std::mt19937 gen(41);
+    std::size_t hits = 0;
+    for (std::int32_t extent : { 3, 100, MAX_INTEGER_COORDINATE }) {
+        std::uniform_int_distribution<std::int32_t> coordinate(-extent, extent);
+        for (int i = 0; i < 20000; i++) {
+            std::int32_t t1[9], t2[9];
+            double d1[9], d2[9];
+            for (int k = 0; k < 9; k++) {
+                d1[k] = t1[k] = coordinate(gen);
+                d2[k] = t2[k] = coordinate(gen);
+            }
+
+            const double* v1[3] = { d1, d1 + 3, d1 + 6 };
+            const double* v2[3] = { d2, d2 + 3, d2 + 6 };
+            bool is_coplanar = RobustPredicates::orient3d(d1, d1 + 3, d1 + 6, d2) == 0
+                && RobustPredicates::orient3d(d1, d1 + 3, d1 + 6, d2 + 3) == 0
+                && RobustPredicates::orient3d(d1, d1 + 3, d1 + 6, d2 + 6) == 0;
+            if (is_coplanar || is_collinear(t1) || is_collinear(t2)) {
+                continue;
+            }
+
+            bool hit = have_intersection(t1, t2);
+            ASSERT_EQ(hit, have_intersection(v1, v2));
+            hits += hit;
+        }
+    }
+    ASSERT_GT(hits, 1000u);
+}
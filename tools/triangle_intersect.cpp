@@ -0,0 +1,137 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "mesh.hpp"
+#include "mesh_io.hpp"
+
+/*
+triangle_intersect [-j threads] [-s] mesh1 [mesh2]
+
+Binary STL or PLY meshes. With two meshes, prints the intersecting pairs "i j"
+(triangle i of mesh1, triangle j of mesh2), one per line, -j caps the threads.
+With one mesh, prints its self-intersecting pairs "i j", i < j; the vertices of STL files
+are welded first so that neighbours are recognized. The search of one mesh runs on one thread, -j does not apply.
+The pairs are printed as they are found, in no particular order; -s collects and sorts them first.
+Exit status: 0 on success, 1 on bad arguments or unreadable files
+*/
+
+using namespace triangle_intersection;
+
+namespace {
+    void print_usage() {
+        std::fprintf(stderr, "usage: triangle_intersect [-j threads] [-s] mesh1 [mesh2]\n");
+    }
+
+    /*
+    Formats the pairs of each worker into a block of its own and writes whole blocks under a lock,
+    so that the lines of concurrent workers never interleave. Millions of pairs are common
+    */
+    class PrintSink : public PairSink {
+    public:
+        void start(unsigned worker_count) override {
+            blocks_.assign(worker_count, Block());
+        }
+
+        void put(const TrianglePair* pairs, std::size_t count, unsigned worker) override {
+            Block& block = blocks_[worker];
+            for (std::size_t i = 0; i < count; i++) {
+                if (block.data.size() - block.used < 32) {
+                    write(block);
+                }
+                block.used += static_cast<std::size_t>(std::snprintf(block.data.data() + block.used, block.data.size() - block.used, "%u %u\n",
+                                                                     static_cast<unsigned>(pairs[i].first), static_cast<unsigned>(pairs[i].second)));
+            }
+        }
+
+        void finish() override {
+            for (Block& block : blocks_) {
+                write(block);
+            }
+            std::fflush(stdout);
+        }
+
+    private:
+        struct Block {
+            std::vector<char> data = std::vector<char>(1 << 16);
+            std::size_t used = 0;
+        };
+
+        void write(Block& block) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            std::fwrite(block.data.data(), 1, block.used, stdout);
+            block.used = 0;
+        }
+
+        std::vector<Block> blocks_;
+        std::mutex mutex_;
+    };
+
+    void print_pairs(const std::vector<TrianglePair>& pairs) {
+        PrintSink sink;
+        sink.start(1);
+        sink.put(pairs.data(), pairs.size(), 0);
+        sink.finish();
+    }
+}
+
+int main(int argc, char** argv) {
+    ParallelOptions options;
+    bool sorted = false;
+    std::vector<std::string> paths;
+    for (int i = 1; i < argc; i++) {
+        if (std::strcmp(argv[i], "-j") == 0 && i + 1 < argc) {
+            options.max_threads = static_cast<unsigned>(std::strtoul(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "-s") == 0) {
+            sorted = true;
+        } else if (argv[i][0] == '-') {
+            print_usage();
+            return 1;
+        } else {
+            paths.push_back(argv[i]);
+        }
+    }
+
+    if (paths.empty() || paths.size() > 2) {
+        print_usage();
+        return 1;
+    }
+
+    try {
+        if (paths.size() == 2) {
+            MappedMesh mesh1(paths[0]);
+            MappedMesh mesh2(paths[1]);
+            std::vector<double> triangles1 = load_triangles(mesh1);
+            std::vector<double> triangles2 = load_triangles(mesh2);
+            Bvh bvh1(triangles1.data(), mesh1.triangle_count());
+            Bvh bvh2(triangles2.data(), mesh2.triangle_count());
+            if (sorted) {
+                print_pairs(intersect_meshes(bvh1, bvh2, options));
+            } else {
+                PrintSink sink;
+                QueryArena arena;
+                intersect_meshes(bvh1, bvh2, sink, arena, options);
+            }
+        } else {
+            MappedMesh mesh(paths[0]);
+            std::vector<double> vertices;
+            std::vector<std::uint32_t> indices;
+            load_indexed_mesh(mesh, vertices, indices);
+            IndexedMesh indexed { vertices.data(), vertices.size() / 3, indices.data(), indices.size() / 3 };
+            if (sorted) {
+                print_pairs(find_self_intersections(indexed));
+            } else {
+                PrintSink sink;
+                find_self_intersections(indexed, sink);
+            }
+        }
+    } catch (const std::exception& e) {
+        std::fprintf(stderr, "triangle_intersect: %s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}